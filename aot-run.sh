@@ -0,0 +1,4 @@
+#!/bin/sh
+# Runs a project compiled by aot-check with the same arguments jit-check.sh
+# gives scrap-run. Usage: aot-run.sh <dir> -s <seed> <project.scrp>
+exec "$1/$(basename "$4" .scrp)" "$2" "$3"
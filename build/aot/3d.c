@@ -0,0 +1,778 @@
+// Generated by scrap-aot from examples/3d.scrp
+// Link with scrap.c built with -DSCRAP_HEADLESS
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "vm.h"
+
+// Defined in scrap.c
+extern ScrVm vm;
+void term_init(int char_w, int char_h);
+void register_blocks(void);
+bool headless_run_compiled(ScrCompiledChain* chains, size_t len);
+
+static const ScrData aot_control_begin = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_BEGIN } };
+static const ScrData aot_control_end = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_END } };
+
+static ScrBlock aot_blocks[25];
+static const char* const aot_blockdef_ids[25] = {
+    "on_start",
+    "decl_var",
+    "create_list",
+    "repeat",
+    "list_add",
+    "random",
+    "loop",
+    "term_clear",
+    "length",
+    "list_set",
+    "list_get",
+    "minus",
+    "if",
+    "less_eq",
+    "div",
+    "cursor_max_x",
+    "plus",
+    "cursor_max_y",
+    "more_eq",
+    "less",
+    "and",
+    "set_cursor",
+    "print",
+    "set_var",
+    "sleep",
+};
+
+static ScrData aot_values[71] = {
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 1 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 10 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 10 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 1 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+};
+static const char* const aot_value_texts[71] = {
+    "x",
+    "y",
+    "z",
+    "100",
+    "x",
+    "-10000",
+    "10000",
+    "y",
+    "-10000",
+    "10000",
+    "z",
+    "11",
+    "300",
+    "100",
+    "i",
+    "0",
+    "z",
+    "z",
+    "i",
+    "z",
+    "i",
+    NULL,
+    "z",
+    "i",
+    NULL,
+    "x",
+    "i",
+    "-10000",
+    "10000",
+    "y",
+    "i",
+    "-10000",
+    "10000",
+    "z",
+    "i",
+    "11",
+    "300",
+    "z",
+    "i",
+    NULL,
+    "pos x",
+    "x",
+    "i",
+    "z",
+    "i",
+    "2",
+    "pos y",
+    "y",
+    "i",
+    "z",
+    "i",
+    "2",
+    "pos x",
+    NULL,
+    "pos x",
+    "pos y",
+    NULL,
+    "pos y",
+    "pos x",
+    "pos y",
+    "*",
+    "pos x",
+    NULL,
+    "pos x",
+    "pos y",
+    NULL,
+    "pos y",
+    NULL,
+    "i",
+    "z",
+    "6000",
+};
+
+static ScrPostfixOp aot_ops[37] = {
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[16] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[18] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[19], .index = &aot_values[20] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[11] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[22], .index = &aot_values[23] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[13] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[26] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[30] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[34] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[37], .index = &aot_values[38] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[13] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[41], .index = &aot_values[42] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[43], .index = &aot_values[44] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[16] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[47], .index = &aot_values[48] },
+    { .type = POSTFIX_LIST_GET_VAR, .argc = 0, .var_version = (size_t)-1, .block = &aot_blocks[10], .value = &aot_values[49], .index = &aot_values[50] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[16] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[52] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[18] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[54] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[19] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[55] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[18] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[57] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[19] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[58] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[59] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[61] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[18] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[63] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[19] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[64] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[18] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[66] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[19] },
+    { .type = POSTFIX_INC_VAR, .argc = 1, .var_version = (size_t)-1, .block = &aot_blocks[23], .value = &aot_values[68], .inner = &aot_blocks[16] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[69] },
+};
+
+static bool aot_chain_0(ScrExec* exec, size_t arena_base);
+
+static bool aot_chain_0(ScrExec* exec, size_t arena_base) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    ScrBlockFrame frame;
+    size_t stack_begin;
+    bool omit_args;
+    ScrData* argv;
+
+    atomic_store_explicit(&chain_data->running_ind, 0, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    frame.block_return = aot_blocks[0].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 1, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[0]);
+    if (!exec_call_block(exec, &aot_blocks[2], 0)) return false;
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 2, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[1]);
+    if (!exec_call_block(exec, &aot_blocks[2], 0)) return false;
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 3, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[2]);
+    if (!exec_call_block(exec, &aot_blocks[2], 0)) return false;
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 4, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, aot_values[3]);
+    frame.block_return = aot_blocks[3].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 4)) goto aot_block_8;
+
+aot_block_5:
+    atomic_store_explicit(&chain_data->running_ind, 5, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[4]);
+    arg_stack_push_arg(exec, aot_values[5]);
+    arg_stack_push_arg(exec, aot_values[6]);
+    if (!exec_call_block(exec, &aot_blocks[5], 2)) return false;
+    frame.block_return = aot_blocks[4].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 6, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[7]);
+    arg_stack_push_arg(exec, aot_values[8]);
+    arg_stack_push_arg(exec, aot_values[9]);
+    if (!exec_call_block(exec, &aot_blocks[5], 2)) return false;
+    frame.block_return = aot_blocks[4].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 7, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[10]);
+    arg_stack_push_arg(exec, aot_values[11]);
+    arg_stack_push_arg(exec, aot_values[12]);
+    if (!exec_call_block(exec, &aot_blocks[5], 2)) return false;
+    frame.block_return = aot_blocks[4].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_8:
+    atomic_store_explicit(&chain_data->running_ind, 8, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        arg_stack_push_arg(exec, aot_values[13]);
+    }
+    frame.block_return = aot_blocks[3].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 8) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 4)) goto aot_block_8;
+        goto aot_block_5;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 9, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    frame.block_return = aot_blocks[6].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 9)) goto aot_block_28;
+
+aot_block_10:
+    atomic_store_explicit(&chain_data->running_ind, 10, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    frame.block_return = aot_blocks[7].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 11, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[14]);
+    arg_stack_push_arg(exec, aot_values[15]);
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 12, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    exec_push_var(exec, &aot_ops[0]);
+    if (!exec_call_block(exec, &aot_blocks[8], 1)) return false;
+    frame.block_return = aot_blocks[3].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 12)) goto aot_block_26;
+
+aot_block_13:
+    atomic_store_explicit(&chain_data->running_ind, 13, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[17]);
+    exec_push_var(exec, &aot_ops[1]);
+    if (!exec_list_get_var(exec, &aot_ops[2])) return false;
+    arg_stack_push_arg(exec, aot_values[21]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg - argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[3])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[9].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 14, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    if (!exec_list_get_var(exec, &aot_ops[4])) return false;
+    arg_stack_push_arg(exec, aot_values[24]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg <= argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[5])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[12].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 14)) goto aot_block_18;
+
+aot_block_15:
+    atomic_store_explicit(&chain_data->running_ind, 15, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[25]);
+    exec_push_var(exec, &aot_ops[6]);
+    arg_stack_push_arg(exec, aot_values[27]);
+    arg_stack_push_arg(exec, aot_values[28]);
+    if (!exec_call_block(exec, &aot_blocks[5], 2)) return false;
+    frame.block_return = aot_blocks[9].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 16, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[29]);
+    exec_push_var(exec, &aot_ops[7]);
+    arg_stack_push_arg(exec, aot_values[31]);
+    arg_stack_push_arg(exec, aot_values[32]);
+    if (!exec_call_block(exec, &aot_blocks[5], 2)) return false;
+    frame.block_return = aot_blocks[9].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 17, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[33]);
+    exec_push_var(exec, &aot_ops[8]);
+    arg_stack_push_arg(exec, aot_values[35]);
+    arg_stack_push_arg(exec, aot_values[36]);
+    if (!exec_call_block(exec, &aot_blocks[5], 2)) return false;
+    frame.block_return = aot_blocks[9].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_18:
+    atomic_store_explicit(&chain_data->running_ind, 18, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        if (!exec_list_get_var(exec, &aot_ops[9])) return false;
+        arg_stack_push_arg(exec, aot_values[39]);
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg <= argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[10])) {
+            return false;
+        }
+    }
+    frame.block_return = aot_blocks[12].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 18) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 14)) goto aot_block_18;
+        goto aot_block_15;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 19, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[40]);
+    if (!exec_list_get_var(exec, &aot_ops[11])) return false;
+    if (!exec_list_get_var(exec, &aot_ops[12])) return false;
+    if (!exec_call_block(exec, &aot_blocks[14], 2)) return false;
+    if (!exec_call_block(exec, &aot_blocks[15], 0)) return false;
+    arg_stack_push_arg(exec, aot_values[45]);
+    if (!exec_call_block(exec, &aot_blocks[14], 2)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg + argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[13])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 20, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[46]);
+    if (!exec_list_get_var(exec, &aot_ops[14])) return false;
+    if (!exec_list_get_var(exec, &aot_ops[15])) return false;
+    if (!exec_call_block(exec, &aot_blocks[14], 2)) return false;
+    if (!exec_call_block(exec, &aot_blocks[17], 0)) return false;
+    arg_stack_push_arg(exec, aot_values[51]);
+    if (!exec_call_block(exec, &aot_blocks[14], 2)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg + argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[16])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 21, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    exec_push_var(exec, &aot_ops[17]);
+    arg_stack_push_arg(exec, aot_values[53]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[18])) {
+        return false;
+    }
+    if (exec_short_circuit(exec, false)) goto aot_21_8;
+    exec_push_var(exec, &aot_ops[19]);
+    if (!exec_call_block(exec, &aot_blocks[15], 0)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[20])) {
+        return false;
+    }
+    if (!exec_call_block(exec, &aot_blocks[20], 2)) return false;
+aot_21_8: ;
+    if (exec_short_circuit(exec, false)) goto aot_21_18;
+    exec_push_var(exec, &aot_ops[21]);
+    arg_stack_push_arg(exec, aot_values[56]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[22])) {
+        return false;
+    }
+    if (exec_short_circuit(exec, false)) goto aot_21_17;
+    exec_push_var(exec, &aot_ops[23]);
+    if (!exec_call_block(exec, &aot_blocks[17], 0)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[24])) {
+        return false;
+    }
+    if (!exec_call_block(exec, &aot_blocks[20], 2)) return false;
+aot_21_17: ;
+    if (!exec_call_block(exec, &aot_blocks[20], 2)) return false;
+aot_21_18: ;
+    frame.block_return = aot_blocks[12].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 21)) goto aot_block_24;
+
+aot_block_22:
+    atomic_store_explicit(&chain_data->running_ind, 22, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    exec_push_var(exec, &aot_ops[25]);
+    exec_push_var(exec, &aot_ops[26]);
+    frame.block_return = aot_blocks[21].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 23, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[60]);
+    frame.block_return = aot_blocks[22].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_24:
+    atomic_store_explicit(&chain_data->running_ind, 24, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        exec_push_var(exec, &aot_ops[27]);
+        arg_stack_push_arg(exec, aot_values[62]);
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[28])) {
+            return false;
+        }
+        if (exec_short_circuit(exec, false)) goto aot_24_8;
+        exec_push_var(exec, &aot_ops[29]);
+        if (!exec_call_block(exec, &aot_blocks[15], 0)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[30])) {
+            return false;
+        }
+        if (!exec_call_block(exec, &aot_blocks[20], 2)) return false;
+aot_24_8: ;
+        if (exec_short_circuit(exec, false)) goto aot_24_18;
+        exec_push_var(exec, &aot_ops[31]);
+        arg_stack_push_arg(exec, aot_values[65]);
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[32])) {
+            return false;
+        }
+        if (exec_short_circuit(exec, false)) goto aot_24_17;
+        exec_push_var(exec, &aot_ops[33]);
+        if (!exec_call_block(exec, &aot_blocks[17], 0)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[34])) {
+            return false;
+        }
+        if (!exec_call_block(exec, &aot_blocks[20], 2)) return false;
+aot_24_17: ;
+        if (!exec_call_block(exec, &aot_blocks[20], 2)) return false;
+aot_24_18: ;
+    }
+    frame.block_return = aot_blocks[12].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 24) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 21)) goto aot_block_24;
+        goto aot_block_22;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 25, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[67]);
+    if (exec_inc_var(exec, &aot_ops[35]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_26:
+    atomic_store_explicit(&chain_data->running_ind, 26, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        exec_push_var(exec, &aot_ops[36]);
+        if (!exec_call_block(exec, &aot_blocks[8], 1)) return false;
+    }
+    frame.block_return = aot_blocks[3].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 26) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 12)) goto aot_block_26;
+        goto aot_block_13;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 27, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[70]);
+    frame.block_return = aot_blocks[24].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_28:
+    atomic_store_explicit(&chain_data->running_ind, 28, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+    }
+    frame.block_return = aot_blocks[6].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 28) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 9)) goto aot_block_28;
+        goto aot_block_10;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+    return true;
+}
+
+static ScrCompiledChain aot_main_chains[] = {
+    aot_chain_0,
+    NULL,
+};
+
+int main(int argc, char** argv) {
+    unsigned int seed = time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:")) != -1) {
+        if (opt != 's') break;
+        seed = strtoul(optarg, NULL, 10);
+    }
+    if (opt != -1 || optind != argc) {
+        printf("Usage: %s [-s seed]\n", argv[0]);
+        return 2;
+    }
+
+    srand(seed);
+    term_init(80, 25);
+    register_blocks();
+    for (size_t i = 0; i < 25; i++) {
+        aot_blocks[i].blockdef = blockdef_find(&vm, aot_blockdef_ids[i]);
+        if (aot_blocks[i].blockdef) continue;
+        printf("[AOT] Block %s is not registered\n", aot_blockdef_ids[i]);
+        vm_free(&vm);
+        return 2;
+    }
+    for (size_t i = 0; i < 71; i++) {
+        if (aot_value_texts[i]) aot_values[i].data.str_arg = intern_str(aot_value_texts[i]);
+    }
+
+    bool ok = headless_run_compiled(aot_main_chains, 1);
+    vm_free(&vm);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,842 @@
+// Generated by scrap-aot from examples/ball.scrp
+// Link with scrap.c built with -DSCRAP_HEADLESS
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "vm.h"
+
+// Defined in scrap.c
+extern ScrVm vm;
+void term_init(int char_w, int char_h);
+void register_blocks(void);
+bool headless_run_compiled(ScrCompiledChain* chains, size_t len);
+
+static const ScrData aot_control_begin = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_BEGIN } };
+static const ScrData aot_control_end = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_END } };
+
+static ScrBlock aot_blocks[19];
+static const char* const aot_blockdef_ids[19] = {
+    "on_start",
+    "decl_var",
+    "cursor_max_x",
+    "div",
+    "cursor_max_y",
+    "if",
+    "random",
+    "set_var",
+    "else",
+    "loop",
+    "plus",
+    "more_eq",
+    "less",
+    "or",
+    "mult",
+    "term_clear",
+    "set_cursor",
+    "print",
+    "sleep",
+};
+
+static ScrData aot_values[64] = {
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = -1 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = -1 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+};
+static const char* const aot_value_texts[64] = {
+    "ball x",
+    "2",
+    "ball y",
+    "2",
+    "ball vx",
+    "0",
+    "ball vy",
+    "0",
+    "0",
+    "1",
+    "ball vx",
+    "-1",
+    "ball vx",
+    "0",
+    "1",
+    "ball vx",
+    "1",
+    "ball vx",
+    "0",
+    "1",
+    "ball vy",
+    "-1",
+    "ball vy",
+    "0",
+    "1",
+    "ball vy",
+    "1",
+    "ball vy",
+    "next x",
+    "ball x",
+    "ball vx",
+    "next y",
+    "ball y",
+    "ball vy",
+    "next x",
+    "next x",
+    NULL,
+    "ball vx",
+    "ball vx",
+    NULL,
+    "ball vx",
+    "next x",
+    "next x",
+    NULL,
+    "ball x",
+    "next x",
+    "ball x",
+    "next y",
+    "next y",
+    NULL,
+    "ball vy",
+    "ball vy",
+    NULL,
+    "ball vy",
+    "next y",
+    "next y",
+    NULL,
+    "ball y",
+    "next y",
+    "ball y",
+    "ball x",
+    "ball y",
+    "O",
+    "32000",
+};
+
+static ScrPostfixOp aot_ops[38] = {
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[12] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[17] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[22] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[27] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[29] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[30] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[10] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[32] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[33] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[10] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[34] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[11] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[35] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[12] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[38] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[14] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[40] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[41] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[11] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[42] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[12] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[45] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[46] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[47] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[11] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[48] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[12] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[51] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[14] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[53] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[54] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[11] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[55] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[12] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[58] },
+    { .type = POSTFIX_SET_VAR, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7], .value = &aot_values[59] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[60] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[61] },
+};
+
+static bool aot_chain_0(ScrExec* exec, size_t arena_base);
+
+static bool aot_chain_0(ScrExec* exec, size_t arena_base) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    ScrBlockFrame frame;
+    size_t stack_begin;
+    bool omit_args;
+    ScrData* argv;
+
+    atomic_store_explicit(&chain_data->running_ind, 0, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    frame.block_return = aot_blocks[0].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 1, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[0]);
+    if (!exec_call_block(exec, &aot_blocks[2], 0)) return false;
+    arg_stack_push_arg(exec, aot_values[1]);
+    if (!exec_call_block(exec, &aot_blocks[3], 2)) return false;
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 2, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[2]);
+    if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+    arg_stack_push_arg(exec, aot_values[3]);
+    if (!exec_call_block(exec, &aot_blocks[3], 2)) return false;
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 3, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[4]);
+    arg_stack_push_arg(exec, aot_values[5]);
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 4, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[6]);
+    arg_stack_push_arg(exec, aot_values[7]);
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 5, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, aot_values[8]);
+    arg_stack_push_arg(exec, aot_values[9]);
+    if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 5)) goto aot_block_7;
+
+aot_block_6:
+    atomic_store_explicit(&chain_data->running_ind, 6, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[10]);
+    arg_stack_push_arg(exec, aot_values[11]);
+    if (exec_set_var(exec, &aot_ops[0]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_7:
+    atomic_store_explicit(&chain_data->running_ind, 7, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        arg_stack_push_arg(exec, aot_values[13]);
+        arg_stack_push_arg(exec, aot_values[14]);
+        if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+    }
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 7) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 5)) goto aot_block_7;
+        goto aot_block_6;
+    }
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, frame.block_return);
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 7)) goto aot_block_9;
+
+aot_block_8:
+    atomic_store_explicit(&chain_data->running_ind, 8, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[15]);
+    arg_stack_push_arg(exec, aot_values[16]);
+    if (exec_set_var(exec, &aot_ops[1]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_9:
+    atomic_store_explicit(&chain_data->running_ind, 9, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+    }
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 9) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 7)) goto aot_block_9;
+        goto aot_block_8;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 10, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, aot_values[18]);
+    arg_stack_push_arg(exec, aot_values[19]);
+    if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 10)) goto aot_block_12;
+
+aot_block_11:
+    atomic_store_explicit(&chain_data->running_ind, 11, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[20]);
+    arg_stack_push_arg(exec, aot_values[21]);
+    if (exec_set_var(exec, &aot_ops[2]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_12:
+    atomic_store_explicit(&chain_data->running_ind, 12, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        arg_stack_push_arg(exec, aot_values[23]);
+        arg_stack_push_arg(exec, aot_values[24]);
+        if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+    }
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 12) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 10)) goto aot_block_12;
+        goto aot_block_11;
+    }
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, frame.block_return);
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 12)) goto aot_block_14;
+
+aot_block_13:
+    atomic_store_explicit(&chain_data->running_ind, 13, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[25]);
+    arg_stack_push_arg(exec, aot_values[26]);
+    if (exec_set_var(exec, &aot_ops[3]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_14:
+    atomic_store_explicit(&chain_data->running_ind, 14, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+    }
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 14) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 12)) goto aot_block_14;
+        goto aot_block_13;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 15, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    frame.block_return = aot_blocks[9].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 15)) goto aot_block_32;
+
+aot_block_16:
+    atomic_store_explicit(&chain_data->running_ind, 16, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[28]);
+    exec_push_var(exec, &aot_ops[4]);
+    exec_push_var(exec, &aot_ops[5]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg + argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[6])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 17, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[31]);
+    exec_push_var(exec, &aot_ops[7]);
+    exec_push_var(exec, &aot_ops[8]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg + argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[9])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 18, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    exec_push_var(exec, &aot_ops[10]);
+    if (!exec_call_block(exec, &aot_blocks[2], 0)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[11])) {
+        return false;
+    }
+    if (exec_short_circuit(exec, true)) goto aot_20_8;
+    exec_push_var(exec, &aot_ops[12]);
+    arg_stack_push_arg(exec, aot_values[36]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[13])) {
+        return false;
+    }
+    if (!exec_call_block(exec, &aot_blocks[13], 2)) return false;
+aot_20_8: ;
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 18)) goto aot_block_20;
+
+aot_block_19:
+    atomic_store_explicit(&chain_data->running_ind, 19, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[37]);
+    exec_push_var(exec, &aot_ops[14]);
+    arg_stack_push_arg(exec, aot_values[39]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg * argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[15])) {
+        return false;
+    }
+    if (exec_set_var(exec, &aot_ops[16]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_20:
+    atomic_store_explicit(&chain_data->running_ind, 20, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        exec_push_var(exec, &aot_ops[17]);
+        if (!exec_call_block(exec, &aot_blocks[2], 0)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[18])) {
+            return false;
+        }
+        if (exec_short_circuit(exec, true)) goto aot_22_8;
+        exec_push_var(exec, &aot_ops[19]);
+        arg_stack_push_arg(exec, aot_values[43]);
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[20])) {
+            return false;
+        }
+        if (!exec_call_block(exec, &aot_blocks[13], 2)) return false;
+aot_22_8: ;
+    }
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 20) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 18)) goto aot_block_20;
+        goto aot_block_19;
+    }
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, frame.block_return);
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 20)) goto aot_block_22;
+
+aot_block_21:
+    atomic_store_explicit(&chain_data->running_ind, 21, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[44]);
+    exec_push_var(exec, &aot_ops[21]);
+    if (exec_set_var(exec, &aot_ops[22]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_22:
+    atomic_store_explicit(&chain_data->running_ind, 22, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+    }
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 22) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 20)) goto aot_block_22;
+        goto aot_block_21;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 23, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    exec_push_var(exec, &aot_ops[23]);
+    if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[24])) {
+        return false;
+    }
+    if (exec_short_circuit(exec, true)) goto aot_26_8;
+    exec_push_var(exec, &aot_ops[25]);
+    arg_stack_push_arg(exec, aot_values[49]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[26])) {
+        return false;
+    }
+    if (!exec_call_block(exec, &aot_blocks[13], 2)) return false;
+aot_26_8: ;
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 23)) goto aot_block_25;
+
+aot_block_24:
+    atomic_store_explicit(&chain_data->running_ind, 24, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[50]);
+    exec_push_var(exec, &aot_ops[27]);
+    arg_stack_push_arg(exec, aot_values[52]);
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg * argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[28])) {
+        return false;
+    }
+    if (exec_set_var(exec, &aot_ops[29]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_25:
+    atomic_store_explicit(&chain_data->running_ind, 25, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        exec_push_var(exec, &aot_ops[30]);
+        if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg >= argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[31])) {
+            return false;
+        }
+        if (exec_short_circuit(exec, true)) goto aot_28_8;
+        exec_push_var(exec, &aot_ops[32]);
+        arg_stack_push_arg(exec, aot_values[56]);
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg < argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[33])) {
+            return false;
+        }
+        if (!exec_call_block(exec, &aot_blocks[13], 2)) return false;
+aot_28_8: ;
+    }
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 25) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 23)) goto aot_block_25;
+        goto aot_block_24;
+    }
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    arg_stack_push_arg(exec, frame.block_return);
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 25)) goto aot_block_27;
+
+aot_block_26:
+    atomic_store_explicit(&chain_data->running_ind, 26, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[57]);
+    exec_push_var(exec, &aot_ops[34]);
+    if (exec_set_var(exec, &aot_ops[35]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_27:
+    atomic_store_explicit(&chain_data->running_ind, 27, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+    }
+    frame.block_return = aot_blocks[8].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 27) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 25)) goto aot_block_27;
+        goto aot_block_26;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 28, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    frame.block_return = aot_blocks[15].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 29, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    exec_push_var(exec, &aot_ops[36]);
+    exec_push_var(exec, &aot_ops[37]);
+    frame.block_return = aot_blocks[16].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 30, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[62]);
+    frame.block_return = aot_blocks[17].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 31, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[63]);
+    frame.block_return = aot_blocks[18].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_32:
+    atomic_store_explicit(&chain_data->running_ind, 32, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+    }
+    frame.block_return = aot_blocks[9].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 32) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 15)) goto aot_block_32;
+        goto aot_block_16;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+    return true;
+}
+
+static ScrCompiledChain aot_main_chains[] = {
+    aot_chain_0,
+    NULL,
+};
+
+int main(int argc, char** argv) {
+    unsigned int seed = time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:")) != -1) {
+        if (opt != 's') break;
+        seed = strtoul(optarg, NULL, 10);
+    }
+    if (opt != -1 || optind != argc) {
+        printf("Usage: %s [-s seed]\n", argv[0]);
+        return 2;
+    }
+
+    srand(seed);
+    term_init(80, 25);
+    register_blocks();
+    for (size_t i = 0; i < 19; i++) {
+        aot_blocks[i].blockdef = blockdef_find(&vm, aot_blockdef_ids[i]);
+        if (aot_blocks[i].blockdef) continue;
+        printf("[AOT] Block %s is not registered\n", aot_blockdef_ids[i]);
+        vm_free(&vm);
+        return 2;
+    }
+    for (size_t i = 0; i < 64; i++) {
+        if (aot_value_texts[i]) aot_values[i].data.str_arg = intern_str(aot_value_texts[i]);
+    }
+
+    bool ok = headless_run_compiled(aot_main_chains, 1);
+    vm_free(&vm);
+    return ok ? 0 : 1;
+}
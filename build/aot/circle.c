@@ -0,0 +1,428 @@
+// Generated by scrap-aot from examples/circle.scrp
+// Link with scrap.c built with -DSCRAP_HEADLESS
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "vm.h"
+
+// Defined in scrap.c
+extern ScrVm vm;
+void term_init(int char_w, int char_h);
+void register_blocks(void);
+bool headless_run_compiled(ScrCompiledChain* chains, size_t len);
+
+static const ScrData aot_control_begin = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_BEGIN } };
+static const ScrData aot_control_end = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_END } };
+
+static ScrBlock aot_blocks[14];
+static const char* const aot_blockdef_ids[14] = {
+    "on_start",
+    "decl_var",
+    "repeat",
+    "cursor_max_y",
+    "cursor_max_x",
+    "if",
+    "div",
+    "minus",
+    "pow",
+    "plus",
+    "less_eq",
+    "set_cursor",
+    "print",
+    "set_var",
+};
+
+static ScrData aot_values[29] = {
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 1 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 1 } },
+    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },
+};
+static const char* const aot_value_texts[29] = {
+    "radius",
+    "15",
+    "y",
+    "0",
+    "x",
+    "0",
+    "x",
+    "2",
+    "2",
+    "y",
+    "2",
+    "2",
+    "radius",
+    "2",
+    "x",
+    "y",
+    "#",
+    "x",
+    "2",
+    "2",
+    "y",
+    "2",
+    "2",
+    "radius",
+    "2",
+    NULL,
+    "x",
+    NULL,
+    "y",
+};
+
+static ScrPostfixOp aot_ops[18] = {
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[6] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[9] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[9] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[12] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[10] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[14] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[15] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[17] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[20] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[7] },
+    { .type = POSTFIX_ARITH, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[9] },
+    { .type = POSTFIX_GET_VAR, .argc = 0, .var_version = (size_t)-1, .value = &aot_values[23] },
+    { .type = POSTFIX_COMPARE, .argc = 2, .var_version = (size_t)-1, .block = &aot_blocks[10] },
+    { .type = POSTFIX_INC_VAR, .argc = 1, .var_version = (size_t)-1, .block = &aot_blocks[13], .value = &aot_values[26], .inner = &aot_blocks[9] },
+    { .type = POSTFIX_INC_VAR, .argc = 1, .var_version = (size_t)-1, .block = &aot_blocks[13], .value = &aot_values[28], .inner = &aot_blocks[9] },
+};
+
+static bool aot_chain_0(ScrExec* exec, size_t arena_base);
+
+static bool aot_chain_0(ScrExec* exec, size_t arena_base) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    ScrBlockFrame frame;
+    size_t stack_begin;
+    bool omit_args;
+    ScrData* argv;
+
+    atomic_store_explicit(&chain_data->running_ind, 0, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    frame.block_return = aot_blocks[0].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 1, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[0]);
+    arg_stack_push_arg(exec, aot_values[1]);
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 2, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[2]);
+    arg_stack_push_arg(exec, aot_values[3]);
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 3, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    if (!exec_call_block(exec, &aot_blocks[3], 0)) return false;
+    frame.block_return = aot_blocks[2].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 3)) goto aot_block_13;
+
+aot_block_4:
+    atomic_store_explicit(&chain_data->running_ind, 4, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[4]);
+    arg_stack_push_arg(exec, aot_values[5]);
+    frame.block_return = aot_blocks[1].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 5, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+    frame.block_return = aot_blocks[2].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 5)) goto aot_block_11;
+
+aot_block_6:
+    atomic_store_explicit(&chain_data->running_ind, 6, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    frame.control_base = exec->control_stack_len;
+    frame.variable_base = exec->variable_stack_len;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_begin);
+    exec_push_var(exec, &aot_ops[0]);
+    if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+    arg_stack_push_arg(exec, aot_values[7]);
+    if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg - argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[1])) {
+        return false;
+    }
+    arg_stack_push_arg(exec, aot_values[8]);
+    if (!exec_call_block(exec, &aot_blocks[8], 2)) return false;
+    exec_push_var(exec, &aot_ops[2]);
+    if (!exec_call_block(exec, &aot_blocks[3], 0)) return false;
+    arg_stack_push_arg(exec, aot_values[10]);
+    if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg - argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[3])) {
+        return false;
+    }
+    arg_stack_push_arg(exec, aot_values[11]);
+    if (!exec_call_block(exec, &aot_blocks[8], 2)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0].data.int_arg = argv[0].data.int_arg + argv[1].data.int_arg;
+        argv[0].storage.type = DATA_STORAGE_STATIC;
+        exec->arg_stack_len--;
+    } else if (!exec_arith(exec, &aot_ops[4])) {
+        return false;
+    }
+    exec_push_var(exec, &aot_ops[5]);
+    arg_stack_push_arg(exec, aot_values[13]);
+    if (!exec_call_block(exec, &aot_blocks[8], 2)) return false;
+    argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg <= argv[1].data.int_arg } };
+        exec->arg_stack_len--;
+    } else if (!exec_compare(exec, &aot_ops[6])) {
+        return false;
+    }
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (exec_push_layer(exec, &frame, 6)) goto aot_block_9;
+
+aot_block_7:
+    atomic_store_explicit(&chain_data->running_ind, 7, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    exec_push_var(exec, &aot_ops[7]);
+    exec_push_var(exec, &aot_ops[8]);
+    frame.block_return = aot_blocks[11].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 8, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[16]);
+    frame.block_return = aot_blocks[12].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_9:
+    atomic_store_explicit(&chain_data->running_ind, 9, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        exec_push_var(exec, &aot_ops[9]);
+        if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+        arg_stack_push_arg(exec, aot_values[18]);
+        if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0].data.int_arg = argv[0].data.int_arg - argv[1].data.int_arg;
+            argv[0].storage.type = DATA_STORAGE_STATIC;
+            exec->arg_stack_len--;
+        } else if (!exec_arith(exec, &aot_ops[10])) {
+            return false;
+        }
+        arg_stack_push_arg(exec, aot_values[19]);
+        if (!exec_call_block(exec, &aot_blocks[8], 2)) return false;
+        exec_push_var(exec, &aot_ops[11]);
+        if (!exec_call_block(exec, &aot_blocks[3], 0)) return false;
+        arg_stack_push_arg(exec, aot_values[21]);
+        if (!exec_call_block(exec, &aot_blocks[6], 2)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0].data.int_arg = argv[0].data.int_arg - argv[1].data.int_arg;
+            argv[0].storage.type = DATA_STORAGE_STATIC;
+            exec->arg_stack_len--;
+        } else if (!exec_arith(exec, &aot_ops[12])) {
+            return false;
+        }
+        arg_stack_push_arg(exec, aot_values[22]);
+        if (!exec_call_block(exec, &aot_blocks[8], 2)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0].data.int_arg = argv[0].data.int_arg + argv[1].data.int_arg;
+            argv[0].storage.type = DATA_STORAGE_STATIC;
+            exec->arg_stack_len--;
+        } else if (!exec_arith(exec, &aot_ops[13])) {
+            return false;
+        }
+        exec_push_var(exec, &aot_ops[14]);
+        arg_stack_push_arg(exec, aot_values[24]);
+        if (!exec_call_block(exec, &aot_blocks[8], 2)) return false;
+        argv = &exec->arg_stack[exec->arg_stack_len - 2];
+        if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+            argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg <= argv[1].data.int_arg } };
+            exec->arg_stack_len--;
+        } else if (!exec_compare(exec, &aot_ops[15])) {
+            return false;
+        }
+    }
+    frame.block_return = aot_blocks[5].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 9) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 6)) goto aot_block_9;
+        goto aot_block_7;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 10, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[25]);
+    if (exec_inc_var(exec, &aot_ops[16]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_11:
+    atomic_store_explicit(&chain_data->running_ind, 11, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        if (!exec_call_block(exec, &aot_blocks[4], 0)) return false;
+    }
+    frame.block_return = aot_blocks[2].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 11) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 5)) goto aot_block_11;
+        goto aot_block_6;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+    atomic_store_explicit(&chain_data->running_ind, 12, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_values[27]);
+    if (exec_inc_var(exec, &aot_ops[17]) == POSTFIX_ERROR) return false;
+    frame.block_return = exec->arg_stack[--exec->arg_stack_len];
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+
+aot_block_13:
+    atomic_store_explicit(&chain_data->running_ind, 13, memory_order_relaxed);
+    exec->arena_len = arena_base;
+    if (chain_data->is_returning) return true;
+    omit_args = exec_pop_layer(exec, &frame);
+    stack_begin = exec->arg_stack_len;
+    arg_stack_push_arg(exec, aot_control_end);
+    if (!omit_args) {
+        if (!exec_call_block(exec, &aot_blocks[3], 0)) return false;
+    }
+    frame.block_return = aot_blocks[2].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (chain_data->running_ind != 13) {
+        pthread_testcancel();
+        if (exec_push_layer(exec, &frame, 3)) goto aot_block_13;
+        goto aot_block_4;
+    }
+    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+    return true;
+}
+
+static ScrCompiledChain aot_main_chains[] = {
+    aot_chain_0,
+    NULL,
+};
+
+int main(int argc, char** argv) {
+    unsigned int seed = time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:")) != -1) {
+        if (opt != 's') break;
+        seed = strtoul(optarg, NULL, 10);
+    }
+    if (opt != -1 || optind != argc) {
+        printf("Usage: %s [-s seed]\n", argv[0]);
+        return 2;
+    }
+
+    srand(seed);
+    term_init(80, 25);
+    register_blocks();
+    for (size_t i = 0; i < 14; i++) {
+        aot_blocks[i].blockdef = blockdef_find(&vm, aot_blockdef_ids[i]);
+        if (aot_blocks[i].blockdef) continue;
+        printf("[AOT] Block %s is not registered\n", aot_blockdef_ids[i]);
+        vm_free(&vm);
+        return 2;
+    }
+    for (size_t i = 0; i < 29; i++) {
+        if (aot_value_texts[i]) aot_values[i].data.str_arg = intern_str(aot_value_texts[i]);
+    }
+
+    bool ok = headless_run_compiled(aot_main_chains, 1);
+    vm_free(&vm);
+    return ok ? 0 : 1;
+}
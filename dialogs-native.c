@@ -0,0 +1,109 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains file dialogs for the native desktop build.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// external/tinyfiledialogs.c only works in a browser, so the desktop build
+// links this file instead. It implements the tinyfd dialogs that scrap uses
+// by running zenity, same as upstream tinyfiledialogs does on most linux
+// desktops
+
+#include "external/tinyfiledialogs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+
+static char dialog_response[1024];
+static char dialog_command[4096];
+
+static void dialog_append(const char* str) {
+    strncat(dialog_command, str, sizeof(dialog_command) - strlen(dialog_command) - 1);
+}
+
+// Appends ` --option='value'` with single quotes in value escaped, does nothing for NULL or ""
+static void dialog_append_option(const char* option, const char* value) {
+    if (!value || !*value) return;
+    dialog_append(" ");
+    dialog_append(option);
+    dialog_append("='");
+    for (const char* c = value; *c; c++) {
+        char ch[2] = { *c, 0 };
+        dialog_append(*c == '\'' ? "'\\''" : ch);
+    }
+    dialog_append("'");
+}
+
+static void dialog_append_filter(int filter_count, const char* const* filters, const char* description) {
+    if (filter_count <= 0 || !filters) return;
+    char filter[512] = "";
+    if (description && *description) {
+        strncat(filter, description, sizeof(filter) - strlen(filter) - 1);
+        strncat(filter, " |", sizeof(filter) - strlen(filter) - 1);
+    }
+    for (int i = 0; i < filter_count; i++) {
+        strncat(filter, " ", sizeof(filter) - strlen(filter) - 1);
+        strncat(filter, filters[i], sizeof(filter) - strlen(filter) - 1);
+    }
+    dialog_append_option("--file-filter", filter);
+}
+
+// Runs built command and returns first line of its output or NULL if the dialog was cancelled or could not be shown
+static char* dialog_run(void) {
+    dialog_append(" 2>/dev/null");
+
+    dialog_response[0] = 0;
+    FILE* out = popen(dialog_command, "r");
+    if (!out) return NULL;
+    if (fgets(dialog_response, sizeof(dialog_response), out)) {
+        dialog_response[strcspn(dialog_response, "\n")] = 0;
+    }
+    while (fgetc(out) != EOF);
+
+    int status = pclose(out);
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return NULL;
+    return *dialog_response ? dialog_response : NULL;
+}
+
+char* tinyfd_saveFileDialog(
+    const char* aTitle,
+    const char* aDefaultPathAndOrFile,
+    int aNumOfFilterPatterns,
+    const char* const* aFilterPatterns,
+    const char* aSingleFilterDescription)
+{
+    strcpy(dialog_command, "zenity --file-selection --save --confirm-overwrite");
+    dialog_append_option("--title", aTitle);
+    dialog_append_option("--filename", aDefaultPathAndOrFile);
+    dialog_append_filter(aNumOfFilterPatterns, aFilterPatterns, aSingleFilterDescription);
+    return dialog_run();
+}
+
+char* tinyfd_openFileDialog(
+    const char* aTitle,
+    const char* aDefaultPathAndOrFile,
+    int aNumOfFilterPatterns,
+    const char* const* aFilterPatterns,
+    const char* aSingleFilterDescription,
+    int aAllowMultipleSelects)
+{
+    strcpy(dialog_command, "zenity --file-selection");
+    if (aAllowMultipleSelects) dialog_append(" --multiple --separator='|'");
+    dialog_append_option("--title", aTitle);
+    dialog_append_option("--filename", aDefaultPathAndOrFile);
+    dialog_append_filter(aNumOfFilterPatterns, aFilterPatterns, aSingleFilterDescription);
+    return dialog_run();
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Runs projects with scrap-run built with the interpreter only and with the
+# JIT and compares their output. Usage: jit-check.sh <interpreter> <jit> <project.scrp>...
+# Runners can be commands with arguments, e.g. "node build/scrap-run-web.js"
+#
+# Both runs get the same random seed and the same input. Projects that are
+# still running after a few seconds are stopped, for them only the output
+# that both runs got to print is compared, which is why output is unbuffered
+interp=$1
+jit=$2
+shift 2
+out=$(mktemp -d)
+failed=0
+for project in "$@"; do
+    seq 1 100 | timeout 5 stdbuf -o0 $interp -s 1 "$project" > "$out/interp.txt" 2>&1
+    interp_status=$?
+    seq 1 100 | timeout 5 stdbuf -o0 $jit -s 1 "$project" > "$out/jit.txt" 2>&1
+    jit_status=$?
+
+    if [ $interp_status -eq 124 ] || [ $jit_status -eq 124 ]; then
+        interp_len=$(wc -c < "$out/interp.txt")
+        jit_len=$(wc -c < "$out/jit.txt")
+        len=$((interp_len < jit_len ? interp_len : jit_len))
+        if [ "$len" -eq 0 ] || ! cmp -s -n "$len" "$out/interp.txt" "$out/jit.txt"; then
+            echo "[JIT] $project: output differs from interpreter"
+            failed=$((failed + 1))
+        fi
+    elif [ $interp_status -ne $jit_status ] || ! cmp -s "$out/interp.txt" "$out/jit.txt"; then
+        echo "[JIT] $project: output or exit status differs from interpreter"
+        failed=$((failed + 1))
+    fi
+done
+rm -rf "$out"
+echo "[JIT] $(($# - failed)) of $# projects match the interpreter"
+[ $failed -eq 0 ]
@@ -0,0 +1,238 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains the x86-64 JIT, it is included by vm.h.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Dispatch threading tier. Every block of a hot chain becomes a direct call
+// of the interpreter function that runs it, followed by a jump straight to
+// the block that usually runs next. Blocks run the same C code as in
+// exec_run_chain, so the only work left out is the dispatch loop and the
+// checks that depend on the kind of the block, which are done while compiling.
+//
+// Generated function keeps these in callee saved registers:
+// - rbx: exec
+// - r12: chain
+// - r14: arena base
+// - r15: jump table used to enter or continue at any block
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define JIT_RAX 0
+#define JIT_RCX 1
+#define JIT_RDX 2
+#define JIT_RBX 3
+#define JIT_RSI 6
+#define JIT_RDI 7
+#define JIT_R12 12
+#define JIT_R14 14
+#define JIT_R15 15
+
+#define JIT_JMP 0xe9
+#define JIT_JE 0x84
+#define JIT_JNE 0x85
+#define JIT_JAE 0x83
+
+typedef struct {
+    size_t at;
+    size_t label;
+} ScrJitFixup;
+
+typedef struct {
+    unsigned char* code;
+    // Code offset of every label, (size_t)-1 if not bound yet
+    size_t* labels;
+    ScrJitFixup* fixups;
+} ScrJitEmitter;
+
+// Same as exec_run_block for a normal block that no break or continue jumps
+// from. Only blocks that can loop check for cancellation
+size_t jit_run_normal(ScrExec* exec, ScrBlockChain* chain, size_t i, size_t arena_base) {
+    exec->arena_len = arena_base;
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    atomic_store_explicit(&chain_data->running_ind, i, memory_order_relaxed);
+    if (chain_data->is_returning) return vector_size(chain->blocks);
+
+    ScrData block_return;
+    if (!exec_block_impl(exec, &chain->blocks[i], &chain->postfix[chain->postfix_start[i]], &block_return, false, false, (ScrData){0}, false)) {
+        return (size_t)-1;
+    }
+    if (block_return.storage.type == DATA_STORAGE_MANAGED) data_free(block_return);
+    return chain_data->running_ind + 1;
+}
+
+#define jit_emit_bytes(jit, ...) do { \
+    unsigned char bytes[] = { __VA_ARGS__ }; \
+    for (size_t _i = 0; _i < sizeof(bytes); _i++) vector_add(&(jit)->code, bytes[_i]); \
+} while (0)
+
+void jit_emit_u32(ScrJitEmitter* jit, uint32_t value) {
+    for (int i = 0; i < 4; i++) vector_add(&jit->code, (value >> (i * 8)) & 0xff);
+}
+
+void jit_emit_u64(ScrJitEmitter* jit, uint64_t value) {
+    for (int i = 0; i < 8; i++) vector_add(&jit->code, (value >> (i * 8)) & 0xff);
+}
+
+size_t jit_new_label(ScrJitEmitter* jit) {
+    vector_add(&jit->labels, (size_t)-1);
+    return vector_size(jit->labels) - 1;
+}
+
+void jit_bind(ScrJitEmitter* jit, size_t label) {
+    jit->labels[label] = vector_size(jit->code);
+}
+
+// rel32 to label from the end of these 4 bytes, patched once all labels are bound
+void jit_emit_label_offset(ScrJitEmitter* jit, size_t label) {
+    ScrJitFixup* fixup = vector_add_dst(&jit->fixups);
+    fixup->at = vector_size(jit->code);
+    fixup->label = label;
+    jit_emit_u32(jit, 0);
+}
+
+void jit_emit_jump(ScrJitEmitter* jit, unsigned char condition, size_t label) {
+    if (condition == JIT_JMP) {
+        jit_emit_bytes(jit, 0xe9);
+    } else {
+        jit_emit_bytes(jit, 0x0f, condition);
+    }
+    jit_emit_label_offset(jit, label);
+}
+
+void jit_emit_mov_reg(ScrJitEmitter* jit, int dst, int src) {
+    // mov dst, src
+    jit_emit_bytes(jit, 0x48 | (src >> 3 << 2) | (dst >> 3), 0x89, 0xc0 | ((src & 7) << 3) | (dst & 7));
+}
+
+void jit_emit_mov_imm64(ScrJitEmitter* jit, int reg, uint64_t value) {
+    jit_emit_bytes(jit, 0x48 | (reg >> 3), 0xb8 | (reg & 7));
+    jit_emit_u64(jit, value);
+}
+
+void jit_emit_cmp_rax(ScrJitEmitter* jit, size_t value) {
+    // cmp rax, imm32
+    jit_emit_bytes(jit, 0x48, 0x3d);
+    jit_emit_u32(jit, value);
+}
+
+void jit_emit_chain(ScrJitEmitter* jit, ScrBlockChain* chain) {
+    size_t chain_len = vector_size(chain->blocks);
+    size_t* block_labels = vector_create();
+    for (size_t i = 0; i <= chain_len; i++) vector_add(&block_labels, jit_new_label(jit));
+    size_t dispatch_label = jit_new_label(jit);
+    size_t table_label = jit_new_label(jit);
+    size_t* openers = jit_block_openers(chain);
+
+    // push rbx; push r12; push r14; push r15; sub rsp, 8
+    jit_emit_bytes(jit, 0x53, 0x41, 0x54, 0x41, 0x56, 0x41, 0x57);
+    jit_emit_bytes(jit, 0x48, 0x83, 0xec, 0x08);
+    jit_emit_mov_reg(jit, JIT_RBX, JIT_RDI);
+    jit_emit_mov_imm64(jit, JIT_R12, (uintptr_t)chain);
+    jit_emit_mov_reg(jit, JIT_R14, JIT_RDX);
+    // lea r15, [rip + table]
+    jit_emit_bytes(jit, 0x4c, 0x8d, 0x3d);
+    jit_emit_label_offset(jit, table_label);
+    jit_emit_mov_reg(jit, JIT_RAX, JIT_RSI);
+    jit_emit_jump(jit, JIT_JMP, dispatch_label);
+
+    for (size_t i = 0; i < chain_len; i++) {
+        ScrBlockdef* blockdef = chain->blocks[i].blockdef;
+        bool normal = blockdef->type == BLOCKTYPE_NORMAL && blockdef->func && chain->loop_jumps[i].unwind < 0;
+        jit_bind(jit, block_labels[i]);
+        jit_emit_mov_reg(jit, JIT_RDI, JIT_RBX);
+        jit_emit_mov_reg(jit, JIT_RSI, JIT_R12);
+        jit_emit_mov_imm64(jit, JIT_RDX, i);
+        jit_emit_mov_reg(jit, JIT_RCX, JIT_R14);
+        jit_emit_mov_imm64(jit, JIT_RAX, (uintptr_t)(normal ? jit_run_normal : exec_run_block));
+        // call rax
+        jit_emit_bytes(jit, 0xff, 0xd0);
+
+        // End of a loop usually goes back to the start of its body
+        size_t opener = openers[i];
+        if (blockdef->type == BLOCKTYPE_END && opener != (size_t)-1 && chain->blocks[opener].blockdef->builtin == BUILTIN_LOOP) {
+            jit_emit_cmp_rax(jit, opener + 1);
+            jit_emit_jump(jit, JIT_JE, block_labels[opener + 1]);
+        }
+        jit_emit_cmp_rax(jit, i + 1);
+        jit_emit_jump(jit, JIT_JNE, dispatch_label);
+    }
+
+    // Past the end of the chain or (size_t)-1, rax is returned as is
+    jit_bind(jit, block_labels[chain_len]);
+    // add rsp, 8; pop r15; pop r14; pop r12; pop rbx; ret
+    jit_emit_bytes(jit, 0x48, 0x83, 0xc4, 0x08);
+    jit_emit_bytes(jit, 0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5c, 0x5b, 0xc3);
+
+    // Jumps to the block with index in rax
+    jit_bind(jit, dispatch_label);
+    jit_emit_cmp_rax(jit, chain_len);
+    jit_emit_jump(jit, JIT_JAE, block_labels[chain_len]);
+    // movsxd rax, dword [r15 + rax * 4]; add rax, r15; jmp rax
+    jit_emit_bytes(jit, 0x49, 0x63, 0x04, 0x87);
+    jit_emit_bytes(jit, 0x4c, 0x01, 0xf8);
+    jit_emit_bytes(jit, 0xff, 0xe0);
+
+    // Jump table with offsets of every block relative to the table
+    while (vector_size(jit->code) % 4) jit_emit_bytes(jit, 0xcc);
+    jit_bind(jit, table_label);
+    size_t table = vector_size(jit->code);
+    for (size_t i = 0; i < chain_len; i++) jit_emit_u32(jit, jit->labels[block_labels[i]] - table);
+
+    for (size_t i = 0; i < vector_size(jit->fixups); i++) {
+        int32_t offset = (int32_t)(jit->labels[jit->fixups[i].label] - (jit->fixups[i].at + 4));
+        memcpy(&jit->code[jit->fixups[i].at], &offset, sizeof(offset));
+    }
+
+    vector_free(openers);
+    vector_free(block_labels);
+}
+
+void jit_compile(ScrBlockChain* chain) {
+    if (vector_size(chain->blocks) >= INT32_MAX / 64) return;
+
+    ScrJitEmitter jit = {
+        .code = vector_create(),
+        .labels = vector_create(),
+        .fixups = vector_create(),
+    };
+    jit_emit_chain(&jit, chain);
+    vector_free(jit.labels);
+    vector_free(jit.fixups);
+
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t size = (vector_size(jit.code) + page_size - 1) / page_size * page_size;
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        vector_free(jit.code);
+        return;
+    }
+    memcpy(mem, jit.code, vector_size(jit.code));
+    vector_free(jit.code);
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC)) {
+        munmap(mem, size);
+        return;
+    }
+
+    chain->jit.func = (ScrJitFunc)mem;
+    chain->jit.size = size;
+}
+
+void jit_free(ScrJitCode* jit) {
+    if (jit->func) munmap((void*)jit->func, jit->size);
+    jit->func = NULL;
+    jit->size = 0;
+    jit->runs = 0;
+}
@@ -0,0 +1,732 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains ahead of time compiler from scrap projects to C.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Usage: scrap-aot <project.scrp> [output.c]
+//
+// Every chain that runs becomes a C function. Its blocks are written out in
+// order and jump to each other with goto, argument ops call the same helpers
+// as the interpreter, block functions are called through blockdefs looked up
+// by id at startup and custom blocks call the function of their chain. The
+// generated file only includes vm.h and is linked with scrap.c built in
+// headless mode:
+//     gcc -O2 -I<scrap dir> project.c <scrap dir>/scrap.c -DSCRAP_HEADLESS -o project -lm -lpthread
+// Anything that can't be translated, like an END that closes nothing or a
+// custom block without definition, is an error
+
+#define SCRAP_HEADLESS
+#define SCRVM_NO_JIT
+#include "scrap.c"
+
+// Fused op written to aot_ops, with indices into aot_values and aot_blocks
+// instead of pointers, (size_t)-1 if not set
+typedef struct {
+    ScrPostfixOpType type;
+    int argc;
+    size_t block;
+    size_t value;
+    size_t index;
+    size_t inner;
+} AotOp;
+
+typedef struct {
+    ScrBlockChain* code;
+    // Chain that defines every custom blockdef
+    ScrBlockdef** custom_blockdefs;
+    size_t* custom_chains;
+    // What aot_blocks, aot_values and aot_ops of generated file are made from
+    ScrBlockdef** blockdefs;
+    ScrData** values;
+    AotOp* ops;
+    bool uses_control;
+
+    // Chain that is being translated, code of its current block goes to out
+    FILE* out;
+    ScrBlockChain* chain;
+    size_t chain_ind;
+    size_t* openers;
+    // Blocks that are jumped to with goto
+    bool* labels;
+    size_t exec_count;
+    bool uses_omit_args;
+    bool uses_argv;
+} AotEmitter;
+
+// Index of the control block closed by every block, (size_t)-1 if there is none
+size_t* aot_block_openers(ScrBlockChain* chain) {
+    size_t* openers = vector_create();
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) vector_add(&openers, (size_t)-1);
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) {
+        if (chain->block_ends[i] != (size_t)-1) openers[chain->block_ends[i]] = i;
+    }
+    return openers;
+}
+
+bool aot_is_custom_definition(ScrBlockChain* chain) {
+    ScrBlock* block = &chain->blocks[0];
+    for (size_t i = 0; i < vector_size(block->arguments); i++) {
+        if (block->arguments[i].type == ARGUMENT_BLOCKDEF) return true;
+    }
+    return false;
+}
+
+// Same chains as exec_thread_entry runs
+bool aot_is_main(ScrBlockChain* chain) {
+    return vector_size(chain->blocks) > 0 && chain->blocks[0].blockdef->type == BLOCKTYPE_HAT && !aot_is_custom_definition(chain);
+}
+
+// Returns (size_t)-1 if blockdef has no definition
+size_t aot_custom_chain(AotEmitter* aot, ScrBlockdef* blockdef) {
+    for (size_t i = 0; i < vector_size(aot->custom_blockdefs); i++) {
+        if (aot->custom_blockdefs[i] == blockdef) return aot->custom_chains[i];
+    }
+    return (size_t)-1;
+}
+
+void aot_mark_used(AotEmitter* aot, bool* used, size_t** pending, ScrBlockdef* blockdef) {
+    if (blockdef->func != block_exec_custom) return;
+    size_t chain = aot_custom_chain(aot, blockdef);
+    if (chain == (size_t)-1 || used[chain]) return;
+    used[chain] = true;
+    vector_add(pending, chain);
+}
+
+// Main chains and definitions of custom blocks they call, directly or not
+bool* aot_used_chains(AotEmitter* aot) {
+    bool* used = calloc(vector_size(aot->code) + 1, sizeof(bool));
+    size_t* pending = vector_create();
+    for (size_t i = 0; i < vector_size(aot->code); i++) {
+        if (!aot_is_main(&aot->code[i])) continue;
+        used[i] = true;
+        vector_add(&pending, i);
+    }
+    while (vector_size(pending) > 0) {
+        ScrBlockChain* chain = &aot->code[pending[vector_size(pending) - 1]];
+        vector_pop(pending);
+        for (size_t i = 0; i < vector_size(chain->blocks); i++) aot_mark_used(aot, used, &pending, chain->blocks[i].blockdef);
+        for (size_t i = 0; i < vector_size(chain->postfix); i++) {
+            if (chain->postfix[i].type == POSTFIX_CALL) aot_mark_used(aot, used, &pending, chain->postfix[i].block->blockdef);
+        }
+    }
+    vector_free(pending);
+    return used;
+}
+
+void aot_error(AotEmitter* aot, size_t block_ind, const char* message) {
+    fprintf(stderr, "[AOT] Chain %zu, block %zu (%s): %s\n", aot->chain_ind, block_ind, aot->chain->blocks[block_ind].blockdef->id, message);
+}
+
+void aot_emit_string(FILE* out, const char* str) {
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20 || *c >= 0x7f) {
+            fprintf(out, "\\%03o", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Custom blocks are translated separately, anything else has to be a registered
+// block as generated code looks it up by id. Returns index in aot_blocks
+size_t aot_block_index(AotEmitter* aot, size_t block_ind, ScrBlockdef* blockdef) {
+    if (!blockdef->func || blockdef_find(&vm, blockdef->id) != blockdef) {
+        aot_error(aot, block_ind, "unknown block");
+        return (size_t)-1;
+    }
+    for (size_t i = 0; i < vector_size(aot->blockdefs); i++) {
+        if (aot->blockdefs[i] == blockdef) return i;
+    }
+    vector_add(&aot->blockdefs, blockdef);
+    return vector_size(aot->blockdefs) - 1;
+}
+
+// Returns index in aot_values
+size_t aot_value_index(AotEmitter* aot, size_t block_ind, ScrData* value) {
+    bool is_static = value->storage.type == DATA_STORAGE_STATIC;
+    if (!is_static || (value->type != DATA_NOTHING && value->type != DATA_INT && value->type != DATA_DOUBLE && value->type != DATA_STR)) {
+        aot_error(aot, block_ind, "argument value can't be written to C");
+        return (size_t)-1;
+    }
+    vector_add(&aot->values, value);
+    return vector_size(aot->values) - 1;
+}
+
+void aot_emit_goto(AotEmitter* aot, size_t target, const char* indent) {
+    if (target >= vector_size(aot->chain->blocks)) {
+        fprintf(aot->out, "%sreturn true;\n", indent);
+        return;
+    }
+    aot->labels[target] = true;
+    fprintf(aot->out, "%sgoto aot_block_%zu;\n", indent, target);
+}
+
+const char* aot_compare_op(ScrBuiltin builtin) {
+    switch (builtin) {
+    case BUILTIN_LESS: return "<";
+    case BUILTIN_LESS_EQ: return "<=";
+    case BUILTIN_MORE: return ">";
+    case BUILTIN_MORE_EQ: return ">=";
+    case BUILTIN_EQ: return "==";
+    case BUILTIN_NOT_EQ: return "!=";
+    default: return NULL;
+    }
+}
+
+const char* aot_arith_op(ScrBuiltin builtin) {
+    switch (builtin) {
+    case BUILTIN_PLUS: return "+";
+    case BUILTIN_MINUS: return "-";
+    case BUILTIN_MULT: return "*";
+    default: return NULL;
+    }
+}
+
+const char* aot_op_type_name(ScrPostfixOpType type) {
+    switch (type) {
+    case POSTFIX_PUSH: return "POSTFIX_PUSH";
+    case POSTFIX_CALL: return "POSTFIX_CALL";
+    case POSTFIX_SKIP_IF_FALSE: return "POSTFIX_SKIP_IF_FALSE";
+    case POSTFIX_SKIP_IF_TRUE: return "POSTFIX_SKIP_IF_TRUE";
+    case POSTFIX_GET_VAR: return "POSTFIX_GET_VAR";
+    case POSTFIX_LIST_GET_VAR: return "POSTFIX_LIST_GET_VAR";
+    case POSTFIX_COMPARE: return "POSTFIX_COMPARE";
+    case POSTFIX_ARITH: return "POSTFIX_ARITH";
+    case POSTFIX_INC_VAR: return "POSTFIX_INC_VAR";
+    case POSTFIX_APPEND_VAR: return "POSTFIX_APPEND_VAR";
+    case POSTFIX_SET_VAR: return "POSTFIX_SET_VAR";
+    default: return "POSTFIX_END";
+    }
+}
+
+const char* aot_fused_block_func(ScrPostfixOpType type) {
+    switch (type) {
+    case POSTFIX_INC_VAR: return "exec_inc_var";
+    case POSTFIX_APPEND_VAR: return "exec_append_var";
+    default: return "exec_set_var";
+    }
+}
+
+// Adds op to aot_ops. Only fields used by its type are set, the rest can be
+// left over from ops it was fused from. Returns its index or (size_t)-1 on error
+size_t aot_op_index(AotEmitter* aot, size_t block_ind, ScrPostfixOp* op) {
+    bool has_value = op->type != POSTFIX_COMPARE && op->type != POSTFIX_ARITH;
+    bool has_block = op->type != POSTFIX_GET_VAR;
+    bool has_index = op->type == POSTFIX_LIST_GET_VAR;
+    bool has_inner = op->type == POSTFIX_INC_VAR || op->type == POSTFIX_APPEND_VAR;
+    AotOp aot_op = {
+        .type = op->type,
+        .argc = op->argc,
+        .block = (size_t)-1,
+        .value = (size_t)-1,
+        .index = (size_t)-1,
+        .inner = (size_t)-1,
+    };
+    if (has_block && (aot_op.block = aot_block_index(aot, block_ind, op->block->blockdef)) == (size_t)-1) return (size_t)-1;
+    if (has_inner && (aot_op.inner = aot_block_index(aot, block_ind, op->inner->blockdef)) == (size_t)-1) return (size_t)-1;
+    if (has_value && (aot_op.value = aot_value_index(aot, block_ind, op->value)) == (size_t)-1) return (size_t)-1;
+    if (has_index && (aot_op.index = aot_value_index(aot, block_ind, op->index)) == (size_t)-1) return (size_t)-1;
+    vector_add(&aot->ops, aot_op);
+    return vector_size(aot->ops) - 1;
+}
+
+// Same as exec_eval_postfix with every op written out. Labels are prefixed
+// with exec_ind, as arguments of control blocks are written out twice
+bool aot_emit_args(AotEmitter* aot, size_t block_ind, size_t exec_ind, const char* indent, bool* fused) {
+    ScrPostfixOp* ops = &aot->chain->postfix[aot->chain->postfix_start[block_ind]];
+    size_t ops_len = 1;
+    while (ops[ops_len - 1].type != POSTFIX_END) ops_len++;
+    bool* targets = calloc(ops_len, sizeof(bool));
+    for (size_t i = 0; i < ops_len; i++) {
+        if (ops[i].type == POSTFIX_SKIP_IF_FALSE || ops[i].type == POSTFIX_SKIP_IF_TRUE) targets[i + ops[i].skip + 1] = true;
+    }
+
+    FILE* out = aot->out;
+    bool ok = true;
+    for (size_t i = 0; ok && i < ops_len; i++) {
+        ScrPostfixOp* op = &ops[i];
+        size_t ind = 0;
+        if (targets[i]) fprintf(out, "aot_%zu_%zu: ;\n", exec_ind, i);
+        switch (op->type) {
+        case POSTFIX_PUSH:
+            if ((ind = aot_value_index(aot, block_ind, op->value)) == (size_t)-1) ok = false;
+            fprintf(out, "%sarg_stack_push_arg(exec, aot_values[%zu]);\n", indent, ind);
+            break;
+        case POSTFIX_CALL: {
+            ScrBlockdef* blockdef = op->block->blockdef;
+            if (blockdef->func == block_exec_custom) {
+                if ((ind = aot_custom_chain(aot, blockdef)) == (size_t)-1) {
+                    aot_error(aot, block_ind, "custom block has no definition");
+                    ok = false;
+                }
+                fprintf(out, "%sif (!exec_call_compiled(exec, aot_chain_%zu, %d)) return false;\n", indent, ind, op->argc);
+            } else if (blockdef->func == block_custom_arg) {
+                if (op->argc != 0) {
+                    aot_error(aot, block_ind, "custom argument has arguments");
+                    ok = false;
+                }
+                fprintf(out, "%sarg_stack_push_arg(exec, exec_custom_arg(exec, %d));\n", indent, blockdef->arg_id);
+            } else {
+                if ((ind = aot_block_index(aot, block_ind, blockdef)) == (size_t)-1) ok = false;
+                fprintf(out, "%sif (!exec_call_block(exec, &aot_blocks[%zu], %d)) return false;\n", indent, ind, op->argc);
+            }
+            break;
+        }
+        case POSTFIX_SKIP_IF_FALSE:
+        case POSTFIX_SKIP_IF_TRUE:
+            fprintf(out, "%sif (exec_short_circuit(exec, %s)) goto aot_%zu_%zu;\n", indent, op->type == POSTFIX_SKIP_IF_TRUE ? "true" : "false", exec_ind, i + op->skip + 1);
+            break;
+        case POSTFIX_GET_VAR:
+            if ((ind = aot_op_index(aot, block_ind, op)) == (size_t)-1) ok = false;
+            fprintf(out, "%sexec_push_var(exec, &aot_ops[%zu]);\n", indent, ind);
+            break;
+        case POSTFIX_LIST_GET_VAR:
+            if ((ind = aot_op_index(aot, block_ind, op)) == (size_t)-1) ok = false;
+            fprintf(out, "%sif (!exec_list_get_var(exec, &aot_ops[%zu])) return false;\n", indent, ind);
+            break;
+        case POSTFIX_COMPARE:
+            if ((ind = aot_op_index(aot, block_ind, op)) == (size_t)-1) ok = false;
+            aot->uses_argv = true;
+            fprintf(out, "%sargv = &exec->arg_stack[exec->arg_stack_len - 2];\n", indent);
+            fprintf(out, "%sif (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {\n", indent);
+            fprintf(out, "%s    argv[0] = (ScrData) { .type = DATA_BOOL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = argv[0].data.int_arg %s argv[1].data.int_arg } };\n", indent, aot_compare_op(op->block->blockdef->builtin));
+            fprintf(out, "%s    exec->arg_stack_len--;\n", indent);
+            fprintf(out, "%s} else if (!exec_compare(exec, &aot_ops[%zu])) {\n", indent, ind);
+            fprintf(out, "%s    return false;\n", indent);
+            fprintf(out, "%s}\n", indent);
+            break;
+        case POSTFIX_ARITH:
+            if ((ind = aot_op_index(aot, block_ind, op)) == (size_t)-1) ok = false;
+            aot->uses_argv = true;
+            fprintf(out, "%sargv = &exec->arg_stack[exec->arg_stack_len - 2];\n", indent);
+            fprintf(out, "%sif (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {\n", indent);
+            fprintf(out, "%s    argv[0].data.int_arg = argv[0].data.int_arg %s argv[1].data.int_arg;\n", indent, aot_arith_op(op->block->blockdef->builtin));
+            fprintf(out, "%s    argv[0].storage.type = DATA_STORAGE_STATIC;\n", indent);
+            fprintf(out, "%s    exec->arg_stack_len--;\n", indent);
+            fprintf(out, "%s} else if (!exec_arith(exec, &aot_ops[%zu])) {\n", indent, ind);
+            fprintf(out, "%s    return false;\n", indent);
+            fprintf(out, "%s}\n", indent);
+            break;
+        case POSTFIX_INC_VAR:
+        case POSTFIX_APPEND_VAR:
+        case POSTFIX_SET_VAR:
+            if ((ind = aot_op_index(aot, block_ind, op)) == (size_t)-1) ok = false;
+            fprintf(out, "%sif (%s(exec, &aot_ops[%zu]) == POSTFIX_ERROR) return false;\n", indent, aot_fused_block_func(op->type), ind);
+            *fused = true;
+            break;
+        case POSTFIX_END:
+            break;
+        }
+    }
+    free(targets);
+    return ok;
+}
+
+// Same as exec_block for block at index block_ind, result goes into frame.block_return.
+// Control blocks get control_arg as frame.block_return too
+bool aot_emit_exec_block(AotEmitter* aot, size_t block_ind, bool from_end) {
+    FILE* out = aot->out;
+    ScrBlockdef* blockdef = aot->chain->blocks[block_ind].blockdef;
+    bool custom = blockdef->func == block_exec_custom || blockdef->func == block_custom_arg;
+    size_t ind = 0;
+    if (custom && blockdef->type != BLOCKTYPE_NORMAL) {
+        aot_error(aot, block_ind, "custom block is not a normal block");
+        return false;
+    }
+    if (blockdef->func == block_exec_custom && (ind = aot_custom_chain(aot, blockdef)) == (size_t)-1) {
+        aot_error(aot, block_ind, "custom block has no definition");
+        return false;
+    }
+    if (!custom && (ind = aot_block_index(aot, block_ind, blockdef)) == (size_t)-1) return false;
+
+    size_t exec_ind = aot->exec_count++;
+    fprintf(out, "    stack_begin = exec->arg_stack_len;\n");
+    if (blockdef->type == BLOCKTYPE_CONTROL || blockdef->type == BLOCKTYPE_CONTROLEND) {
+        aot->uses_control = true;
+        fprintf(out, "    arg_stack_push_arg(exec, %s);\n", from_end ? "aot_control_end" : "aot_control_begin");
+        if (!from_end && blockdef->type == BLOCKTYPE_CONTROLEND) fprintf(out, "    arg_stack_push_arg(exec, frame.block_return);\n");
+    }
+
+    bool fused = false;
+    if (from_end) {
+        fprintf(out, "    if (!omit_args) {\n");
+        if (!aot_emit_args(aot, block_ind, exec_ind, "        ", &fused)) return false;
+        fprintf(out, "    }\n");
+    } else {
+        if (!aot_emit_args(aot, block_ind, exec_ind, "    ", &fused)) return false;
+    }
+
+    // Fused op ran the whole block and left its result on top of the stack
+    if (fused && from_end) {
+        aot_error(aot, block_ind, "control block arguments end with a fused op");
+        return false;
+    }
+    if (fused) {
+        fprintf(out, "    frame.block_return = exec->arg_stack[--exec->arg_stack_len];\n");
+    } else if (blockdef->func == block_exec_custom) {
+        fprintf(out, "    if (!exec_run_compiled(exec, aot_chain_%zu, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin, &frame.block_return)) return false;\n", ind);
+    } else if (blockdef->func == block_custom_arg) {
+        fprintf(out, "    frame.block_return = exec_custom_arg(exec, %d);\n", blockdef->arg_id);
+    } else {
+        fprintf(out, "    frame.block_return = aot_blocks[%zu].blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);\n", ind);
+    }
+    fprintf(out, "    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);\n");
+    return true;
+}
+
+// Same as exec_block_layer for a control block, the body is skipped by going to its end
+void aot_emit_push_layer(AotEmitter* aot, size_t block_ind, const char* indent) {
+    fprintf(aot->out, "%sif (exec_push_layer(exec, &frame, %zu)) ", indent, block_ind);
+    aot_emit_goto(aot, aot->chain->block_ends[block_ind], "");
+}
+
+// Same as exec_run_block for blocks[i]. Which blocks close and open layers is
+// known here, so only loops are checked for at runtime
+bool aot_emit_block(AotEmitter* aot, size_t i) {
+    FILE* out = aot->out;
+    ScrBlockChain* chain = aot->chain;
+    ScrBlockdef* blockdef = chain->blocks[i].blockdef;
+    size_t opener = aot->openers[i];
+
+    fprintf(out, "    atomic_store_explicit(&chain_data->running_ind, %zu, memory_order_relaxed);\n", i);
+    fprintf(out, "    exec->arena_len = arena_base;\n");
+    fprintf(out, "    if (chain_data->is_returning) return true;\n");
+
+    if (chain->loop_jumps[i].unwind >= 0) {
+        fprintf(out, "    exec_unwind_layers(exec, %d);\n", chain->loop_jumps[i].unwind);
+        aot_emit_goto(aot, chain->loop_jumps[i].next, "    ");
+        return true;
+    }
+
+    switch (blockdef->type) {
+    case BLOCKTYPE_NORMAL:
+    case BLOCKTYPE_HAT:
+        if (!aot_emit_exec_block(aot, i, false)) return false;
+        fprintf(out, "    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);\n");
+        return true;
+    case BLOCKTYPE_CONTROL:
+        fprintf(out, "    frame.control_base = exec->control_stack_len;\n");
+        fprintf(out, "    frame.variable_base = exec->variable_stack_len;\n");
+        if (!aot_emit_exec_block(aot, i, false)) return false;
+        aot_emit_push_layer(aot, i, "    ");
+        return true;
+    case BLOCKTYPE_END:
+    case BLOCKTYPE_CONTROLEND:
+        break;
+    }
+
+    // CONTROLEND outside of any layer does nothing
+    if (opener == (size_t)-1) {
+        if (blockdef->type == BLOCKTYPE_CONTROLEND) return true;
+        aot_error(aot, i, "end block does not close any block");
+        return false;
+    }
+
+    aot->uses_omit_args = true;
+    fprintf(out, "    omit_args = exec_pop_layer(exec, &frame);\n");
+    if (!aot_emit_exec_block(aot, opener, true)) return false;
+    // Loops move the running index back to themselves
+    fprintf(out, "    if (chain_data->running_ind != %zu) {\n", i);
+    fprintf(out, "        pthread_testcancel();\n");
+    aot_emit_push_layer(aot, opener, "        ");
+    aot_emit_goto(aot, opener + 1, "        ");
+    fprintf(out, "    }\n");
+
+    if (blockdef->type == BLOCKTYPE_END) {
+        fprintf(out, "    if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);\n");
+        return true;
+    }
+    // Block that was closed gets its result as control argument
+    fprintf(out, "    frame.control_base = exec->control_stack_len;\n");
+    fprintf(out, "    frame.variable_base = exec->variable_stack_len;\n");
+    if (!aot_emit_exec_block(aot, i, false)) return false;
+    aot_emit_push_layer(aot, i, "    ");
+    return true;
+}
+
+bool aot_emit_chain(AotEmitter* aot, FILE* out, size_t chain_ind) {
+    ScrBlockChain* chain = &aot->code[chain_ind];
+    size_t len = vector_size(chain->blocks);
+    aot->chain = chain;
+    aot->chain_ind = chain_ind;
+    aot->openers = aot_block_openers(chain);
+    aot->labels = calloc(len, sizeof(bool));
+    aot->uses_omit_args = false;
+    aot->uses_argv = false;
+    char** blocks = calloc(len, sizeof(char*));
+    size_t* block_sizes = calloc(len, sizeof(size_t));
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < len; i++) {
+        aot->out = open_memstream(&blocks[i], &block_sizes[i]);
+        if (!aot->out) {
+            fprintf(stderr, "[AOT] Could not allocate memory\n");
+            ok = false;
+            break;
+        }
+        ok = aot_emit_block(aot, i);
+        fclose(aot->out);
+    }
+
+    if (ok) {
+        fprintf(out, "static bool aot_chain_%zu(ScrExec* exec, size_t arena_base) {\n", chain_ind);
+        fprintf(out, "    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];\n");
+        fprintf(out, "    ScrBlockFrame frame;\n");
+        fprintf(out, "    size_t stack_begin;\n");
+        if (aot->uses_omit_args) fprintf(out, "    bool omit_args;\n");
+        if (aot->uses_argv) fprintf(out, "    ScrData* argv;\n");
+        for (size_t i = 0; i < len; i++) {
+            fprintf(out, "\n");
+            if (aot->labels[i]) fprintf(out, "aot_block_%zu:\n", i);
+            fwrite(blocks[i], 1, block_sizes[i], out);
+        }
+        fprintf(out, "    return true;\n");
+        fprintf(out, "}\n\n");
+    }
+
+    for (size_t i = 0; i < len; i++) free(blocks[i]);
+    free(blocks);
+    free(block_sizes);
+    free(aot->labels);
+    vector_free(aot->openers);
+    return ok;
+}
+
+void aot_emit_tables(AotEmitter* aot, FILE* out) {
+    if (aot->uses_control) {
+        fprintf(out, "static const ScrData aot_control_begin = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_BEGIN } };\n");
+        fprintf(out, "static const ScrData aot_control_end = { .type = DATA_CONTROL, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .control_arg = CONTROL_ARG_END } };\n\n");
+    }
+
+    // Blockdefs are looked up by id at startup
+    if (vector_size(aot->blockdefs) > 0) {
+        fprintf(out, "static ScrBlock aot_blocks[%zu];\n", vector_size(aot->blockdefs));
+        fprintf(out, "static const char* const aot_blockdef_ids[%zu] = {\n", vector_size(aot->blockdefs));
+        for (size_t i = 0; i < vector_size(aot->blockdefs); i++) {
+            fprintf(out, "    ");
+            aot_emit_string(out, aot->blockdefs[i]->id);
+            fprintf(out, ",\n");
+        }
+        fprintf(out, "};\n\n");
+    }
+
+    // Text is interned at startup, as the vm expects it to be
+    if (vector_size(aot->values) > 0) {
+        fprintf(out, "static ScrData aot_values[%zu] = {\n", vector_size(aot->values));
+        for (size_t i = 0; i < vector_size(aot->values); i++) {
+            ScrData* value = aot->values[i];
+            switch (value->type) {
+            case DATA_INT:
+                fprintf(out, "    { .type = DATA_INT, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = %d } },\n", value->data.int_arg);
+                break;
+            case DATA_DOUBLE:
+                fprintf(out, "    { .type = DATA_DOUBLE, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .double_arg = %.17g } },\n", value->data.double_arg);
+                break;
+            case DATA_STR:
+                fprintf(out, "    { .type = DATA_STR, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .str_arg = NULL } },\n");
+                break;
+            default:
+                fprintf(out, "    { .type = DATA_NOTHING, .storage = { DATA_STORAGE_STATIC, 0 }, .data = { .int_arg = 0 } },\n");
+                break;
+            }
+        }
+        fprintf(out, "};\n");
+        fprintf(out, "static const char* const aot_value_texts[%zu] = {\n", vector_size(aot->values));
+        for (size_t i = 0; i < vector_size(aot->values); i++) {
+            fprintf(out, "    ");
+            if (aot->values[i]->type == DATA_STR) {
+                aot_emit_string(out, aot->values[i]->data.str_arg);
+            } else {
+                fprintf(out, "NULL");
+            }
+            fprintf(out, ",\n");
+        }
+        fprintf(out, "};\n\n");
+    }
+
+    if (vector_size(aot->ops) > 0) {
+        fprintf(out, "static ScrPostfixOp aot_ops[%zu] = {\n", vector_size(aot->ops));
+        for (size_t i = 0; i < vector_size(aot->ops); i++) {
+            AotOp* op = &aot->ops[i];
+            fprintf(out, "    { .type = %s, .argc = %d, .var_version = (size_t)-1", aot_op_type_name(op->type), op->argc);
+            if (op->block != (size_t)-1) fprintf(out, ", .block = &aot_blocks[%zu]", op->block);
+            if (op->value != (size_t)-1) fprintf(out, ", .value = &aot_values[%zu]", op->value);
+            if (op->index != (size_t)-1) fprintf(out, ", .index = &aot_values[%zu]", op->index);
+            if (op->inner != (size_t)-1) fprintf(out, ", .inner = &aot_blocks[%zu]", op->inner);
+            fprintf(out, " },\n");
+        }
+        fprintf(out, "};\n\n");
+    }
+}
+
+void aot_emit_main(AotEmitter* aot, FILE* out, bool* used) {
+    // Last entry only keeps the array non empty
+    size_t main_count = 0;
+    fprintf(out, "static ScrCompiledChain aot_main_chains[] = {\n");
+    for (size_t i = 0; i < vector_size(aot->code); i++) {
+        if (!used[i] || !aot_is_main(&aot->code[i])) continue;
+        fprintf(out, "    aot_chain_%zu,\n", i);
+        main_count++;
+    }
+    fprintf(out, "    NULL,\n};\n\n");
+
+    fprintf(out,
+        "int main(int argc, char** argv) {\n"
+        "    unsigned int seed = time(NULL);\n"
+        "    int opt;\n"
+        "    while ((opt = getopt(argc, argv, \"s:\")) != -1) {\n"
+        "        if (opt != 's') break;\n"
+        "        seed = strtoul(optarg, NULL, 10);\n"
+        "    }\n"
+        "    if (opt != -1 || optind != argc) {\n"
+        "        printf(\"Usage: %%s [-s seed]\\n\", argv[0]);\n"
+        "        return 2;\n"
+        "    }\n"
+        "\n"
+        "    srand(seed);\n"
+        "    term_init(80, 25);\n"
+        "    register_blocks();\n");
+    if (vector_size(aot->blockdefs) > 0) {
+        fprintf(out,
+            "    for (size_t i = 0; i < %zu; i++) {\n"
+            "        aot_blocks[i].blockdef = blockdef_find(&vm, aot_blockdef_ids[i]);\n"
+            "        if (aot_blocks[i].blockdef) continue;\n"
+            "        printf(\"[AOT] Block %%s is not registered\\n\", aot_blockdef_ids[i]);\n"
+            "        vm_free(&vm);\n"
+            "        return 2;\n"
+            "    }\n", vector_size(aot->blockdefs));
+    }
+    if (vector_size(aot->values) > 0) {
+        fprintf(out,
+            "    for (size_t i = 0; i < %zu; i++) {\n"
+            "        if (aot_value_texts[i]) aot_values[i].data.str_arg = intern_str(aot_value_texts[i]);\n"
+            "    }\n", vector_size(aot->values));
+    }
+    fprintf(out,
+        "\n"
+        "    bool ok = headless_run_compiled(aot_main_chains, %zu);\n"
+        "    vm_free(&vm);\n"
+        "    return ok ? 0 : 1;\n"
+        "}\n", main_count);
+}
+
+bool aot_emit_program(FILE* out, const char* file_path, ScrBlockChain* code) {
+    AotEmitter aot = {
+        .code = code,
+        .custom_blockdefs = vector_create(),
+        .custom_chains = vector_create(),
+        .blockdefs = vector_create(),
+        .values = vector_create(),
+        .ops = vector_create(),
+        .uses_control = false,
+    };
+    // Same as exec_thread_entry gives custom blocks their chains
+    for (size_t i = 0; i < vector_size(code); i++) {
+        if (vector_size(code[i].blocks) == 0 || code[i].blocks[0].blockdef->type != BLOCKTYPE_HAT) continue;
+        ScrBlock* block = &code[i].blocks[0];
+        for (size_t j = 0; j < vector_size(block->arguments); j++) {
+            if (block->arguments[j].type != ARGUMENT_BLOCKDEF) continue;
+            vector_add(&aot.custom_blockdefs, block->arguments[j].data.blockdef);
+            vector_add(&aot.custom_chains, i);
+        }
+    }
+    bool* used = aot_used_chains(&aot);
+
+    char* chains;
+    size_t chains_size;
+    FILE* chains_out = open_memstream(&chains, &chains_size);
+    bool ok = chains_out != NULL;
+    for (size_t i = 0; ok && i < vector_size(code); i++) {
+        if (used[i]) ok = aot_emit_chain(&aot, chains_out, i);
+    }
+    if (chains_out) fclose(chains_out);
+
+    if (ok) {
+        fprintf(out, "// Generated by scrap-aot from %s\n", file_path);
+        fprintf(out, "// Link with scrap.c built with -DSCRAP_HEADLESS\n\n");
+        fprintf(out, "#include <stdlib.h>\n");
+        fprintf(out, "#include <time.h>\n");
+        fprintf(out, "#include <unistd.h>\n");
+        fprintf(out, "#include \"vm.h\"\n\n");
+        fprintf(out, "// Defined in scrap.c\n");
+        fprintf(out, "extern ScrVm vm;\n");
+        fprintf(out, "void term_init(int char_w, int char_h);\n");
+        fprintf(out, "void register_blocks(void);\n");
+        fprintf(out, "bool headless_run_compiled(ScrCompiledChain* chains, size_t len);\n\n");
+        aot_emit_tables(&aot, out);
+        for (size_t i = 0; i < vector_size(code); i++) {
+            if (used[i]) fprintf(out, "static bool aot_chain_%zu(ScrExec* exec, size_t arena_base);\n", i);
+        }
+        fprintf(out, "\n");
+        fwrite(chains, 1, chains_size, out);
+        aot_emit_main(&aot, out, used);
+    }
+
+    if (chains_out) free(chains);
+    free(used);
+    vector_free(aot.custom_blockdefs);
+    vector_free(aot.custom_chains);
+    vector_free(aot.blockdefs);
+    vector_free(aot.values);
+    vector_free(aot.ops);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <project.scrp> [output.c]\n", argv[0]);
+        return 1;
+    }
+
+    // Generated code goes to the original stdout, anything printed while
+    // loading the project ends up on stderr instead of inside the C file
+    FILE* out = NULL;
+    if (argc == 2) {
+        int out_fd = dup(STDOUT_FILENO);
+        if (out_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0 || !(out = fdopen(out_fd, "w"))) {
+            fprintf(stderr, "[AOT] Could not open stdout\n");
+            return 1;
+        }
+        setvbuf(stdout, NULL, _IOLBF, 0);
+    }
+
+    register_blocks();
+    ScrBlockChain* code = load_code(argv[1]);
+    if (!code) {
+        fprintf(stderr, "[AOT] Could not load %s\n", argv[1]);
+        vm_free(&vm);
+        return 1;
+    }
+    for (size_t i = 0; i < vector_size(code); i++) blockchain_compile(&code[i]);
+
+    if (argc == 3 && !(out = fopen(argv[2], "w"))) {
+        fprintf(stderr, "[AOT] Could not open %s\n", argv[2]);
+        return 1;
+    }
+    bool ok = aot_emit_program(out, argv[1], code);
+    if (fclose(out)) ok = false;
+    // Nothing is left half written
+    if (!ok && argc == 3) remove(argv[2]);
+
+    for (size_t i = 0; i < vector_size(code); i++) blockchain_free(&code[i]);
+    vector_free(code);
+    vm_free(&vm);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains benchmark runner for scrap projects.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Usage: scrap-bench [-r runs] [-t seconds] [project.scrp...]
+//
+// Runs projects headlessly and prints wall time, executed blocks per second
+// and peak memory of each one as JSON. Without projects runs examples/*.scrp
+// and bench/*.scrp from the current directory. Every run happens in its own
+// process with terminal output thrown away, projects that are still running
+// after the time limit are stopped and reported as "timeout".
+//
+// Blocks are only counted by the interpreter, so JIT is disabled here and
+// the numbers describe the interpreter alone. Built with SCRAP_BENCH_JIT
+// (make scrap-bench-jit) hot chains are compiled as usual and blocks are not counted
+
+#define _GNU_SOURCE
+#define SCRAP_HEADLESS
+#ifndef SCRAP_BENCH_JIT
+#define SCRVM_COUNT_BLOCKS
+#endif
+#include "scrap.c"
+#include <time.h>
+#include <glob.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+typedef enum {
+    BENCH_FINISHED = 0,
+    BENCH_ERROR,
+    BENCH_TIMEOUT,
+    BENCH_LOAD_FAILED,
+    BENCH_CRASHED,
+} BenchStatus;
+
+typedef struct {
+    BenchStatus status;
+    double seconds;
+    size_t blocks;
+    long peak_kb;
+} BenchRun;
+
+// Input given to projects that wait for it, others read end of file
+typedef struct {
+    const char* name;
+    const char* input;
+} BenchInput;
+
+// Guesses every number in order, so the game ends whatever number it picks
+static char guess_input[512];
+
+static BenchInput bench_inputs[] = {
+    { "guess.scrp", guess_input },
+};
+
+const char* bench_status_name(BenchStatus status) {
+    switch (status) {
+    case BENCH_FINISHED: return "finished";
+    case BENCH_ERROR: return "error";
+    case BENCH_TIMEOUT: return "timeout";
+    case BENCH_LOAD_FAILED: return "load_failed";
+    case BENCH_CRASHED: return "crashed";
+    default: return "unknown";
+    }
+}
+
+const char* bench_find_input(const char* path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    for (size_t i = 0; i < sizeof(bench_inputs) / sizeof(bench_inputs[0]); i++) {
+        if (!strcmp(bench_inputs[i].name, name)) return bench_inputs[i].input;
+    }
+    return "";
+}
+
+double bench_time(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// Replaces stdin with a pipe holding input and stdout with /dev/null
+bool bench_redirect(const char* input) {
+    int input_pipe[2];
+    if (pipe(input_pipe)) return false;
+    size_t len = strlen(input);
+    if (write(input_pipe[1], input, len) != (ssize_t)len) return false;
+    close(input_pipe[1]);
+    if (dup2(input_pipe[0], STDIN_FILENO) < 0) return false;
+    close(input_pipe[0]);
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd < 0) return false;
+    if (dup2(null_fd, STDOUT_FILENO) < 0) return false;
+    close(null_fd);
+    return true;
+}
+
+// Runs inside the forked process, peak memory is filled in by the parent
+BenchRun bench_child(const char* path, double time_limit) {
+    BenchRun run = { .status = BENCH_LOAD_FAILED };
+    if (!bench_redirect(bench_find_input(path))) return run;
+
+    ScrBlockChain* code = load_code(path);
+    if (!code) return run;
+
+    double start = bench_time();
+    exec = exec_new();
+    exec_copy_code(&vm, &exec, code);
+    if (!exec_start(&vm, &exec)) {
+        run.status = BENCH_ERROR;
+        return run;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)time_limit;
+    deadline.tv_nsec += (long)((time_limit - (time_t)time_limit) * 1e9);
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    void* return_code;
+    if (pthread_timedjoin_np(exec.thread, &return_code, &deadline)) {
+        exec_stop(&vm, &exec);
+        pthread_join(exec.thread, &return_code);
+        run.status = BENCH_TIMEOUT;
+    } else {
+        run.status = return_code == (void*)1 ? BENCH_FINISHED : BENCH_ERROR;
+    }
+    run.seconds = bench_time() - start;
+    run.blocks = exec.block_count;
+    return run;
+}
+
+BenchRun bench_run(const char* path, double time_limit) {
+    BenchRun run = { .status = BENCH_CRASHED };
+    int result_pipe[2];
+    if (pipe(result_pipe)) return run;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(result_pipe[0]);
+        close(result_pipe[1]);
+        return run;
+    }
+    if (pid == 0) {
+        close(result_pipe[0]);
+        BenchRun child_run = bench_child(path, time_limit);
+        if (write(result_pipe[1], &child_run, sizeof(child_run)) != sizeof(child_run)) _exit(1);
+        // Skip atexit handlers and stdio flushing, the vm thread may have been cancelled while holding a lock
+        _exit(0);
+    }
+
+    close(result_pipe[1]);
+    if (read(result_pipe[0], &run, sizeof(run)) != sizeof(run)) run.status = BENCH_CRASHED;
+    close(result_pipe[0]);
+
+    int status;
+    struct rusage usage = {0};
+    if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status)) run.status = BENCH_CRASHED;
+    run.peak_kb = usage.ru_maxrss;
+    return run;
+}
+
+int bench_compare_runs(const void* left, const void* right) {
+    double diff = ((const BenchRun*)left)->seconds - ((const BenchRun*)right)->seconds;
+    return (diff > 0) - (diff < 0);
+}
+
+void bench_print_string(const char* str) {
+    putchar('"');
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') putchar('\\');
+        putchar(*c);
+    }
+    putchar('"');
+}
+
+// Reports median run by wall time. Peak memory is the largest one across runs
+void bench_print_result(const char* path, BenchRun* runs, int runs_count) {
+    qsort(runs, runs_count, sizeof(BenchRun), bench_compare_runs);
+    BenchRun* median = &runs[runs_count / 2];
+    long peak_kb = 0;
+    BenchStatus status = BENCH_FINISHED;
+    for (int i = 0; i < runs_count; i++) {
+        if (runs[i].peak_kb > peak_kb) peak_kb = runs[i].peak_kb;
+        if (runs[i].status > status) status = runs[i].status;
+    }
+
+    printf("    {\"project\": ");
+    bench_print_string(path);
+    printf(", \"status\": \"%s\"", bench_status_name(status));
+    printf(", \"wall_seconds\": %.6f", median->seconds);
+    printf(", \"min_wall_seconds\": %.6f", runs[0].seconds);
+    printf(", \"max_wall_seconds\": %.6f", runs[runs_count - 1].seconds);
+#ifdef SCRVM_COUNT_BLOCKS
+    printf(", \"blocks\": %zu", median->blocks);
+    printf(", \"blocks_per_second\": %.0f", median->seconds > 0 ? median->blocks / median->seconds : 0.0);
+#endif
+    printf(", \"peak_memory_kb\": %ld}", peak_kb);
+}
+
+int main(int argc, char** argv) {
+    int runs_count = 3;
+    double time_limit = 2.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:t:")) != -1) {
+        switch (opt) {
+        case 'r':
+            runs_count = atoi(optarg);
+            break;
+        case 't':
+            time_limit = atof(optarg);
+            break;
+        default:
+            runs_count = 0;
+            break;
+        }
+    }
+    if (runs_count <= 0 || time_limit <= 0) {
+        fprintf(stderr, "Usage: %s [-r runs] [-t seconds] [project.scrp...]\n", argv[0]);
+        return 2;
+    }
+
+    for (int i = 1, len = 0; i <= 100; i++) len += sprintf(guess_input + len, "%d\n", i);
+
+    glob_t projects = {0};
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++) glob(argv[i], GLOB_NOCHECK | (i > optind ? GLOB_APPEND : 0), NULL, &projects);
+    } else {
+        glob("examples/*.scrp", 0, NULL, &projects);
+        glob("bench/*.scrp", GLOB_APPEND, NULL, &projects);
+    }
+    if (projects.gl_pathc == 0) {
+        fprintf(stderr, "[BENCH] No projects found\n");
+        return 2;
+    }
+
+    srand(1);
+    term_init(80, 25);
+    register_blocks();
+    fflush(stdout);
+
+    BenchRun* runs = malloc(runs_count * sizeof(BenchRun));
+#ifdef SCRAP_BENCH_JIT
+    bool jit = true;
+#else
+    bool jit = false;
+#endif
+    printf("{\n  \"runs\": %d,\n  \"time_limit_seconds\": %.3f,\n  \"jit\": %s,\n  \"results\": [\n", runs_count, time_limit, jit ? "true" : "false");
+    for (size_t i = 0; i < projects.gl_pathc; i++) {
+        fprintf(stderr, "[BENCH] %s\n", projects.gl_pathv[i]);
+        // Children inherit stdout buffer, so anything printed before fork is printed twice
+        fflush(stdout);
+        for (int j = 0; j < runs_count; j++) runs[j] = bench_run(projects.gl_pathv[i], time_limit);
+        bench_print_result(projects.gl_pathv[i], runs, runs_count);
+        printf(i + 1 < projects.gl_pathc ? ",\n" : "\n");
+    }
+    printf("  ]\n}\n");
+
+    free(runs);
+    globfree(&projects);
+    vm_free(&vm);
+    return 0;
+}
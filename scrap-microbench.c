@@ -0,0 +1,378 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains microbenchmarks for interpreter primitives.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Usage: scrap-microbench [-n samples] [-s sample_ms] [filter...]
+//
+// Times single vm.h primitives in a loop and prints ns per operation as JSON.
+// Each benchmark is calibrated so one sample takes about sample_ms, then the
+// median, mean, standard deviation and 95% confidence interval of the mean are
+// reported over all samples. Filters run only benchmarks whose name contains one of them
+
+#define SCRAP_HEADLESS
+#include "scrap.c"
+#include <time.h>
+
+typedef struct {
+    const char* name;
+    size_t param;
+    void (*setup)(size_t param);
+    void (*run)(size_t iters);
+    void (*cleanup)(void);
+} MicroBench;
+
+typedef struct {
+    double median;
+    double mean;
+    double stddev;
+    double ci95;
+    size_t iters;
+} MicroStats;
+
+static ScrBlockChain micro_chain;
+static ScrBlockChain micro_detached;
+static ScrBlock micro_block;
+static ScrData micro_data;
+static const char* micro_name;
+static size_t micro_pos;
+
+// Keeps the compiler from throwing away results it thinks are unused
+#define micro_keep(value) __asm__ volatile("" : : "g"(value) : "memory")
+
+double micro_time(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+ScrBlock micro_block_new(const char* id) {
+    ScrBlockdef* blockdef = find_blockdef(vm.blockdefs, intern_str(id));
+    assert(blockdef != NULL);
+    return block_new(blockdef);
+}
+
+void micro_exec_setup(void) {
+    exec = exec_new();
+    chain_stack_push(&exec, (ScrChainStackData) {
+        .skip_block = false,
+        .layer = 0,
+        .running_ind = 0,
+        .custom_argc = -1,
+        .custom_argv = NULL,
+        .is_returning = false,
+        .return_arg = (ScrData) {0},
+    });
+}
+
+// Same cleanup as when exec thread exits, so values left on stacks don't pile up between benchmarks
+void micro_exec_cleanup(void) {
+    variable_stack_cleanup(&exec);
+    arg_stack_undo_args(&exec, exec.arg_stack_len);
+    exec_free(&exec);
+}
+
+// Chain with a single block, so its postfix program can be run by exec_block
+void micro_exec_block_setup(size_t param) {
+    (void) param;
+    micro_exec_setup();
+    micro_chain = blockchain_new();
+    blockchain_add_block(&micro_chain, micro_block_new(micro_name));
+    blockchain_compile(&micro_chain);
+}
+
+void micro_exec_nothing_setup(size_t param) {
+    micro_name = "nothing";
+    micro_exec_block_setup(param);
+}
+
+void micro_exec_plus_setup(size_t param) {
+    micro_name = "plus";
+    micro_exec_block_setup(param);
+}
+
+void micro_exec_block_run(size_t iters) {
+    ScrBlock block = micro_chain.blocks[0];
+    ScrPostfixOp* args = &micro_chain.postfix[micro_chain.postfix_start[0]];
+    for (size_t i = 0; i < iters; i++) {
+        ScrData block_return;
+        exec_block(&exec, block, args, &block_return, false, false, (ScrData) {0});
+        if (block_return.storage.type == DATA_STORAGE_MANAGED) data_free(block_return);
+        exec.arena_len = 0;
+        micro_keep(block_return.data.int_arg);
+    }
+}
+
+void micro_chain_cleanup(void) {
+    blockchain_free(&micro_chain);
+    micro_exec_cleanup();
+}
+
+// param live variables, looks up the oldest one so the whole stack is searched
+void micro_variables_setup(size_t param) {
+    micro_exec_setup();
+    for (size_t i = 0; i < param; i++) {
+        variable_stack_push_var(&exec, intern_str(TextFormat("var%zu", i)), (ScrData) {
+            .type = DATA_INT,
+            .storage = DATA_STORAGE_STATIC,
+            .data = (ScrDataContents) { .int_arg = i },
+        });
+    }
+    micro_name = intern_str("var0");
+}
+
+void micro_variables_run(size_t iters) {
+    for (size_t i = 0; i < iters; i++) {
+        ScrVariable* var = variable_stack_get_variable(&exec, micro_name);
+        micro_keep(var);
+    }
+}
+
+
+// List of param lists with param ints each, built the same way list blocks do it
+void micro_nested_list_setup(size_t param) {
+    micro_data = block_create_list(NULL, 0, NULL);
+    list_resize(&micro_data, param);
+    for (size_t i = 0; i < param; i++) {
+        ScrData inner = block_create_list(NULL, 0, NULL);
+        list_resize(&inner, param);
+        for (size_t j = 0; j < param; j++) {
+            inner.data.list_arg.items[j] = (ScrData) {
+                .type = DATA_INT,
+                .storage = DATA_STORAGE_STATIC,
+                .data = (ScrDataContents) { .int_arg = j },
+            };
+        }
+        inner.storage.type = DATA_STORAGE_UNMANAGED;
+        micro_data.data.list_arg.items[i] = inner;
+    }
+}
+
+void micro_data_copy_run(size_t iters) {
+    for (size_t i = 0; i < iters; i++) {
+        ScrData copy = data_copy(micro_data);
+        micro_keep(copy.data.list_arg.items);
+        data_free(copy);
+    }
+}
+
+// Copies are shared until changed, this measures the copy made on first change
+void micro_list_unshare_run(size_t iters) {
+    for (size_t i = 0; i < iters; i++) {
+        ScrData copy = data_copy(micro_data);
+        list_unshare(&copy.data.list_arg);
+        micro_keep(copy.data.list_arg.items);
+        data_free(copy);
+    }
+}
+
+void micro_data_cleanup(void) {
+    data_free(micro_data);
+}
+
+void micro_arg_stack_setup(size_t param) {
+    (void) param;
+    micro_exec_setup();
+}
+
+// One push and one undo per operation, in batches of 8 like a block with many arguments
+void micro_arg_stack_run(size_t iters) {
+    ScrData arg = {
+        .type = DATA_INT,
+        .storage = DATA_STORAGE_STATIC,
+        .data = (ScrDataContents) { .int_arg = 1 },
+    };
+    for (size_t i = 0; i < iters; i += 8) {
+        for (int j = 0; j < 8; j++) arg_stack_push_arg(&exec, arg);
+        micro_keep(exec.arg_stack_len);
+        arg_stack_undo_args(&exec, 8);
+    }
+}
+
+// println (join (get var "name") (join "a" "b"))
+void micro_block_copy_setup(size_t param) {
+    (void) param;
+    micro_block = micro_block_new("println");
+    argument_set_block(&micro_block.arguments[0], micro_block_new("join"));
+    ScrBlock* join = &micro_block.arguments[0].data.block;
+    argument_set_block(&join->arguments[0], micro_block_new("get_var"));
+    argument_set_block(&join->arguments[1], micro_block_new("join"));
+    block_update_all_links(&micro_block);
+}
+
+void micro_block_copy_run(size_t iters) {
+    for (size_t i = 0; i < iters; i++) {
+        ScrBlock copy = block_copy(&micro_block, NULL);
+        micro_keep(copy.arguments);
+        block_free(&copy);
+    }
+}
+
+void micro_block_copy_cleanup(void) {
+    block_free(&micro_block);
+}
+
+// Chain of param blocks, which are detached from the middle and inserted back
+void micro_long_chain_setup(size_t param) {
+    micro_chain = blockchain_new();
+    micro_detached = blockchain_new();
+    blockchain_add_block(&micro_chain, micro_block_new("on_start"));
+    for (size_t i = 1; i < param; i++) vector_add(&micro_chain.blocks, micro_block_new("println"));
+    blockchain_update_parent_links(&micro_chain);
+    micro_pos = param / 2;
+}
+
+void micro_detach_single_run(size_t iters) {
+    for (size_t i = 0; i < iters; i++) {
+        blockchain_detach_single(&micro_detached, &micro_chain, micro_pos);
+        blockchain_insert(&micro_chain, &micro_detached, micro_pos - 1);
+    }
+}
+
+// Moves the second half of the chain out and back
+void micro_detach_tail_run(size_t iters) {
+    for (size_t i = 0; i < iters; i++) {
+        blockchain_detach(&micro_detached, &micro_chain, micro_pos);
+        blockchain_insert(&micro_chain, &micro_detached, micro_pos - 1);
+    }
+}
+
+void micro_long_chain_cleanup(void) {
+    blockchain_free(&micro_chain);
+    blockchain_free(&micro_detached);
+}
+
+static MicroBench micro_benches[] = {
+    { "exec_block nothing", 0, micro_exec_nothing_setup, micro_exec_block_run, micro_chain_cleanup },
+    { "exec_block plus", 0, micro_exec_plus_setup, micro_exec_block_run, micro_chain_cleanup },
+    { "variable_stack_get_variable", 1, micro_variables_setup, micro_variables_run, micro_exec_cleanup },
+    { "variable_stack_get_variable", 16, micro_variables_setup, micro_variables_run, micro_exec_cleanup },
+    { "variable_stack_get_variable", 256, micro_variables_setup, micro_variables_run, micro_exec_cleanup },
+    { "data_copy nested list", 16, micro_nested_list_setup, micro_data_copy_run, micro_data_cleanup },
+    { "list_unshare nested list", 16, micro_nested_list_setup, micro_list_unshare_run, micro_data_cleanup },
+    { "list_unshare nested list", 256, micro_nested_list_setup, micro_list_unshare_run, micro_data_cleanup },
+    { "arg_stack push and undo", 0, micro_arg_stack_setup, micro_arg_stack_run, micro_exec_cleanup },
+    { "block_copy", 0, micro_block_copy_setup, micro_block_copy_run, micro_block_copy_cleanup },
+    { "blockchain detach and insert single", 1000, micro_long_chain_setup, micro_detach_single_run, micro_long_chain_cleanup },
+    { "blockchain detach and insert single", 10000, micro_long_chain_setup, micro_detach_single_run, micro_long_chain_cleanup },
+    { "blockchain detach and insert tail", 1000, micro_long_chain_setup, micro_detach_tail_run, micro_long_chain_cleanup },
+    { "blockchain detach and insert tail", 10000, micro_long_chain_setup, micro_detach_tail_run, micro_long_chain_cleanup },
+};
+
+// Two sided 95% quantiles of Student's t distribution for 1 to 30 degrees of freedom
+static const double micro_t95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+int micro_compare_doubles(const void* left, const void* right) {
+    double diff = *(const double*)left - *(const double*)right;
+    return (diff > 0) - (diff < 0);
+}
+
+double micro_sample(MicroBench* bench, size_t iters) {
+    double start = micro_time();
+    bench->run(iters);
+    return micro_time() - start;
+}
+
+MicroStats micro_measure(MicroBench* bench, int samples_count, double sample_time) {
+    MicroStats stats = {0};
+    // Doubles iterations until a sample is long enough, which also warms up caches
+    size_t iters = 8;
+    double time;
+    while ((time = micro_sample(bench, iters)) < sample_time / 2) iters *= 2;
+    iters = (size_t)(iters * sample_time / time);
+    if (iters < 8) iters = 8;
+    stats.iters = iters;
+
+    double* samples = malloc(samples_count * sizeof(double));
+    for (int i = 0; i < samples_count; i++) {
+        samples[i] = micro_sample(bench, iters) * 1e9 / iters;
+        stats.mean += samples[i];
+    }
+    stats.mean /= samples_count;
+    for (int i = 0; i < samples_count; i++) stats.stddev += (samples[i] - stats.mean) * (samples[i] - stats.mean);
+    if (samples_count > 1) {
+        stats.stddev = sqrt(stats.stddev / (samples_count - 1));
+        double t = samples_count - 1 <= 30 ? micro_t95[samples_count - 2] : 1.960;
+        stats.ci95 = t * stats.stddev / sqrt(samples_count);
+    } else {
+        stats.stddev = 0;
+    }
+
+    qsort(samples, samples_count, sizeof(double), micro_compare_doubles);
+    stats.median = samples_count % 2 ? samples[samples_count / 2] : (samples[samples_count / 2 - 1] + samples[samples_count / 2]) / 2;
+    free(samples);
+    return stats;
+}
+
+bool micro_matches(MicroBench* bench, char** filters, int filters_count) {
+    if (filters_count == 0) return true;
+    for (int i = 0; i < filters_count; i++) {
+        if (strstr(bench->name, filters[i])) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    int samples_count = 31;
+    double sample_ms = 10.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            samples_count = atoi(optarg);
+            break;
+        case 's':
+            sample_ms = atof(optarg);
+            break;
+        default:
+            samples_count = 0;
+            break;
+        }
+    }
+    if (samples_count < 2 || sample_ms <= 0) {
+        fprintf(stderr, "Usage: %s [-n samples] [-s sample_ms] [filter...]\n", argv[0]);
+        return 2;
+    }
+
+    term_init(80, 25);
+    register_blocks();
+
+    printf("{\n  \"samples\": %d,\n  \"sample_ms\": %.3f,\n  \"results\": [", samples_count, sample_ms);
+    bool first = true;
+    for (size_t i = 0; i < sizeof(micro_benches) / sizeof(micro_benches[0]); i++) {
+        MicroBench* bench = &micro_benches[i];
+        if (!micro_matches(bench, argv + optind, argc - optind)) continue;
+        fprintf(stderr, "[BENCH] %s %zu\n", bench->name, bench->param);
+
+        bench->setup(bench->param);
+        MicroStats stats = micro_measure(bench, samples_count, sample_ms / 1000.0);
+        if (bench->cleanup) bench->cleanup();
+
+        printf("%s\n    {\"name\": \"%s\", \"param\": %zu", first ? "" : ",", bench->name, bench->param);
+        printf(", \"ns_per_op\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f", stats.median, stats.mean, stats.stddev);
+        printf(", \"ci95_ns\": %.3f, \"iterations\": %zu}", stats.ci95, stats.iters);
+        fflush(stdout);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+
+    vm_free(&vm);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains command line runner for scrap projects.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Usage: scrap-run [-p profile.folded] [-t trace.json] [-s seed] <project.scrp>
+//
+// Runs on_start chains of the project without a window. Terminal output goes
+// to stdout and input is read from stdin, the program stops once stdin ends.
+// Exits with 0 on success, 1 if the program stopped with an error and 2 if
+// the project could not be loaded. With -p the run is sampled and written as
+// folded stacks, which flamegraph tools can turn into a flame graph. With -t
+// custom block calls, input waits, sleeps and terminal locking are written as
+// chrome trace, which can be opened in chrome://tracing or Perfetto. With -s
+// random numbers are seeded with the given seed instead of current time, so
+// runs can be compared
+
+#define SCRAP_HEADLESS
+#include "scrap.c"
+#include <time.h>
+
+void write_output(const char* path, const char* text) {
+    FILE* file = fopen(path, "w");
+    if (!file || fputs(text, file) < 0) printf("[RUN] Could not write %s\n", path);
+    if (file) fclose(file);
+}
+
+int main(int argc, char** argv) {
+    const char* profile_path = NULL;
+    const char* trace_path = NULL;
+    unsigned int seed = time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:s:")) != -1) {
+        if (opt == 'p') {
+            profile_path = optarg;
+        } else if (opt == 't') {
+            trace_path = optarg;
+        } else if (opt == 's') {
+            seed = strtoul(optarg, NULL, 10);
+        } else {
+            break;
+        }
+    }
+    if (opt != -1 || optind != argc - 1) {
+        printf("Usage: %s [-p profile.folded] [-t trace.json] [-s seed] <project.scrp>\n", argv[0]);
+        return 2;
+    }
+
+    srand(seed);
+    term_init(80, 25);
+    register_blocks();
+    ScrBlockChain* code = load_code(argv[optind]);
+    if (!code) {
+        printf("[LOAD] Could not load %s\n", argv[optind]);
+        vm_free(&vm);
+        return 2;
+    }
+
+    ScrSampler sampler = {0};
+    if (trace_path) trace_start();
+    bool ok = headless_run(code, profile_path ? &sampler : NULL);
+    if (profile_path) {
+        char* folded = sampler_folded(&sampler);
+        write_output(profile_path, folded);
+        free(folded);
+        sampler_free(&sampler);
+    }
+    if (trace_path) {
+        trace_stop();
+        char* trace = trace_json();
+        write_output(trace_path, trace);
+        free(trace);
+    }
+
+    for (size_t i = 0; i < vector_size(code); i++) blockchain_free(&code[i]);
+    vector_free(code);
+    vm_free(&vm);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// Scrap is a project that allows anyone to build software using simple, block based interface.
+// This file contains command line tool that dumps wasm modules of web JIT.
+//
+// Copyright (C) 2024 Grisshink
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Usage: scrap-wasm <project.scrp> <output prefix>
+//
+// Compiles every chain of the project with the wasm emitter of the web build
+// and writes the modules as <output prefix>.<chain>.wasm, importing shared
+// memory like the threaded web build does, and <output prefix>.<chain>.unshared.wasm.
+// Struct offsets and pointers come from the native build, so the modules can
+// be validated and instantiated with wasm-validate.js but not run
+
+#define SCRAP_HEADLESS
+#define SCRVM_WASM_EMITTER
+#include "scrap.c"
+
+bool wasm_write_module(const char* path, unsigned char* code) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "[WASM] Could not open %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(code, 1, vector_size(code), file) == vector_size(code);
+    if (fclose(file)) ok = false;
+    if (!ok) fprintf(stderr, "[WASM] Could not write %s\n", path);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <project.scrp> <output prefix>\n", argv[0]);
+        return 1;
+    }
+
+    register_blocks();
+    int size;
+    unsigned char* data = LoadFileData(argv[1], &size);
+    if (!data) {
+        fprintf(stderr, "[WASM] Could not read %s\n", argv[1]);
+        return 1;
+    }
+    ScrBlockChain* code = load_code_from_memory(data, size);
+    UnloadFileData(data);
+    if (!code) {
+        fprintf(stderr, "[WASM] Could not load %s\n", argv[1]);
+        return 1;
+    }
+
+    bool ok = true;
+    size_t compiled = 0;
+    char path[1024];
+    for (size_t i = 0; ok && i < vector_size(code); i++) {
+        blockchain_compile(&code[i]);
+        for (int shared = 1; ok && shared >= 0; shared--) {
+            unsigned char* module = wasm_compile_chain(&code[i], shared);
+            if (!module) break;
+            snprintf(path, sizeof(path), shared ? "%s.%zu.wasm" : "%s.%zu.unshared.wasm", argv[2], i);
+            ok = wasm_write_module(path, module);
+            vector_free(module);
+            if (shared) compiled++;
+        }
+    }
+    if (ok) fprintf(stderr, "[WASM] %s: compiled %zu of %zu chains\n", argv[1], compiled, vector_size(code));
+
+    for (size_t i = 0; i < vector_size(code); i++) blockchain_free(&code[i]);
+    vector_free(code);
+    vm_free(&vm);
+    return ok ? 0 : 1;
+}
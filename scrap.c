@@ -25,15 +25,22 @@
 #include <stddef.h>
 #include <assert.h>
 #include <string.h>
+#include <stdarg.h>
 #include <math.h>
 #include <semaphore.h>
 #include <unistd.h>
+// Headless builds only keep the VM, blocks and project loading, for tools
+// that run projects without a window
+#ifndef SCRAP_HEADLESS
 #include "raylib.h"
 #define RAYLIB_NUKLEAR_IMPLEMENTATION
 #include "external/raylib-nuklear.h"
 #include "external/tinyfiledialogs.h"
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#endif
+#endif
 
 #define ARRLEN(x) (sizeof(x)/sizeof(x[0]))
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
@@ -60,11 +67,15 @@
 #define DROP_TEX_WIDTH ((float)(conf.font_size - BLOCK_OUTLINE_SIZE * 4) / (float)drop_tex.height * (float)drop_tex.width)
 #define TERM_CHAR_SIZE (conf.font_size * 0.6)
 
+#ifndef SCRAP_HEADLESS
 typedef struct {
     int font_size;
     int side_bar_size;
     int fps_limit;
     int block_size_threshold;
+    bool profile_blocks;
+    bool sample_profile;
+    bool trace_execution;
     char font_symbols[FONT_SYMBOLS_MAX_SIZE];
     char font_path[FONT_PATH_MAX_SIZE];
     char font_bold_path[FONT_PATH_MAX_SIZE];
@@ -193,6 +204,14 @@ typedef struct {
     int buf_start;
     int buf_end;
 } OutputWindow;
+#else
+// Output goes straight to stdout, cursor is only tracked for the cursor blocks
+typedef struct {
+    pthread_mutex_t lock;
+    int char_w, char_h;
+    int cursor_pos;
+} OutputWindow;
+#endif
 
 typedef struct {
     void* ptr;
@@ -201,6 +220,7 @@ typedef struct {
     size_t max_size;
 } SaveArena;
 
+#ifndef SCRAP_HEADLESS
 char* top_bar_buttons_text[] = {
     "File",
     "Settings",
@@ -211,11 +231,13 @@ char* tab_bar_buttons_text[] = {
     "Code",
     "Output",
 };
+#endif
 
 char scrap_ident[] = "SCRAP";
 ScrBlockdef** save_blockdefs = NULL;
 const char** save_block_ids = NULL;
 
+#ifndef SCRAP_HEADLESS
 Config conf;
 Config gui_conf;
 
@@ -249,11 +271,26 @@ float shader_time = 0.0;
 int shader_time_loc;
 
 TabType current_tab = TAB_CODE;
+#else
+// Blocks only keep pointers to their images
+int run_tex, term_tex, special_tex, list_tex;
+#endif
 
 ScrVm vm;
 ScrExec exec = {0};
+OutputWindow out_win = {0};
+
+#ifndef SCRAP_HEADLESS
 ScrBlockChain mouse_blockchain = {0};
 ScrBlockChain* editor_code = {0};
+// Filled while the code runs if conf.profile_blocks is set
+ScrProfile block_profile = {0};
+ScrSampler exec_sampler = {0};
+// Folded stacks of the last run sampled by exec_sampler. Names are resolved
+// when the run ends, since chains may move once the code is edited
+char* sampled_profile = NULL;
+// Chrome trace of the last run, recorded if conf.trace_execution is set
+char* recorded_trace = NULL;
 
 DrawStack* draw_stack = NULL;
 HoverInfo hover_info = {0};
@@ -262,7 +299,6 @@ BlockCode block_code = {0};
 Dropdown dropdown = {0};
 ActionBar actionbar;
 NuklearGui gui = {0};
-OutputWindow out_win = {0};
 
 Vector2 camera_pos = {0};
 Vector2 camera_click_pos = {0};
@@ -295,23 +331,46 @@ const char* line_shader_fragment =
     "    float diff = clamp(1.0 - abs(coord.x + coord.y - pos), 0.0, 1.0);\n"
     "    finalColor = vec4(fragColor.xyz, pow(diff, 2.0));\n"
     "}";
+#endif
+
+// block_math receives these as indices into block_math_list
+typedef enum {
+    MATH_SQRT = 0, MATH_ROUND, MATH_FLOOR, MATH_CEIL,
+    MATH_SIN, MATH_COS, MATH_TAN,
+    MATH_ASIN, MATH_ACOS, MATH_ATAN,
+    MATH_LIST_LEN,
+} MathOperation;
 
-#define MATH_LIST_LEN 10
 char* block_math_list[MATH_LIST_LEN] = {
     "sqrt", "round", "floor", "ceil",
     "sin", "cos", "tan",
     "asin", "acos", "atan",
 };
 
+// Order matches ScrArrayType
+char* block_array_type_list[] = { "int", "float" };
+
+typedef enum {
+    LIST_SORT_NUMBERS = 0,
+    LIST_SORT_TEXT,
+} ListSortOrder;
+
+char* block_list_sort_list[] = { "numbers", "text" };
+
+#ifndef SCRAP_HEADLESS
 void save_config(Config* config);
 void apply_config(Config* dst, Config* src);
 void set_default_config(Config* config);
+#endif
 void update_measurements(ScrBlock* block, ScrPlacementStrategy placement);
 void term_input_put_char(char ch);
+void term_lock(void);
+void term_unlock(void);
 int term_print_str(const char* str);
 void term_clear(void);
 void save_code(const char* file_path, ScrBlockChain* code);
 ScrBlockChain* load_code(const char* file_path);
+ScrBlockChain* load_code_from_memory(void* data, int size);
 ScrData block_exec_custom(ScrExec* exec, int argc, ScrData* argv);
 ScrData block_custom_arg(ScrExec* exec, int argc, ScrData* argv);
 void save_block(SaveArena* save, ScrBlock* block);
@@ -320,6 +379,57 @@ void save_blockdef(SaveArena* save, ScrBlockdef* blockdef);
 ScrBlockdef* load_blockdef(SaveArena* save);
 int save_find_id(const char* id);
 const char* into_data_path(const char* path);
+ScrData block_eq(ScrExec* exec, int argc, ScrData* argv);
+
+#ifdef SCRAP_HEADLESS
+// Stand-ins for the few raylib functions that project loading and blocks use
+int GetRandomValue(int min, int max) {
+    if (min > max) {
+        int temp = min;
+        min = max;
+        max = temp;
+    }
+    return min + rand() % ((unsigned int)max - min + 1);
+}
+
+const char* TextFormat(const char* text, ...) {
+    static char buf[1024];
+    va_list args;
+    va_start(args, text);
+    vsnprintf(buf, sizeof(buf), text, args);
+    va_end(args);
+    return buf;
+}
+
+unsigned char* LoadFileData(const char* file_name, int* data_size) {
+    FILE* file = fopen(file_name, "rb");
+    if (!file) return NULL;
+    unsigned char* data = NULL;
+    long size;
+    if (fseek(file, 0, SEEK_END) || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET)) goto done;
+    data = malloc(size ? size : 1);
+    if (fread(data, 1, size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+        goto done;
+    }
+    *data_size = size;
+done:
+    fclose(file);
+    return data;
+}
+
+void UnloadFileData(unsigned char* data) {
+    free(data);
+}
+
+bool SaveFileData(const char* file_name, void* data, int data_size) {
+    FILE* file = fopen(file_name, "wb");
+    if (!file) return false;
+    bool ok = fwrite(data, 1, data_size, file) == (size_t)data_size;
+    return !fclose(file) && ok;
+}
+#endif
 
 char** math_list_access(ScrBlock* block, size_t* list_len) {
     (void) block;
@@ -327,6 +437,19 @@ char** math_list_access(ScrBlock* block, size_t* list_len) {
     return block_math_list;
 }
 
+char** array_type_list_access(ScrBlock* block, size_t* list_len) {
+    (void) block;
+    *list_len = ARRLEN(block_array_type_list);
+    return block_array_type_list;
+}
+
+char** list_sort_list_access(ScrBlock* block, size_t* list_len) {
+    (void) block;
+    *list_len = ARRLEN(block_list_sort_list);
+    return block_list_sort_list;
+}
+
+#ifndef SCRAP_HEADLESS
 ScrVec as_scr_vec(Vector2 vec) {
     return (ScrVec) { vec.x, vec.y };
 }
@@ -956,10 +1079,25 @@ void block_update_collisions(Vector2 position, ScrBlock* block) {
     }
 }
 
+// Tints block red by the share of time spent in the block itself, relative to the slowest block
+Color block_heat_color(ScrBlock* block) {
+    Color color = as_rl_color(block->blockdef->color);
+    ScrBlockProfile* profile = profile_get(&block_profile, block);
+    if (!profile || !profile->count || !block_profile.max_exclusive_ns) return color;
+
+    float heat = sqrtf((float)profile->exclusive_ns / (float)block_profile.max_exclusive_ns) * 0.8;
+    return (Color) {
+        color.r + (0xff - color.r) * heat,
+        color.g * (1.0 - heat),
+        color.b * (1.0 - heat),
+        color.a,
+    };
+}
+
 void draw_block(Vector2 position, ScrBlock* block, bool force_outline, bool force_collision) {
     ScrBlockdef* blockdef = block->blockdef;
     bool collision = (hover_info.block == block && hover_info.editor.part == EDITOR_NONE) || force_collision;
-    Color color = as_rl_color(blockdef->color);
+    Color color = block_heat_color(block);
     Color outline_color = force_collision ? YELLOW : ColorBrightness(color, collision ? 0.5 : -0.2);
     Color block_color = ColorBrightness(color, collision ? 0.3 : 0.0);
 
@@ -1255,19 +1393,18 @@ void draw_block_chain(ScrBlockChain* chain, Vector2 camera_pos, bool chain_highl
         if ((blockdef->type == BLOCKTYPE_END || blockdef->type == BLOCKTYPE_CONTROLEND) && vector_size(draw_stack) > 0) {
             pos.x -= BLOCK_CONTROL_INDENT;
             DrawStack prev_block = draw_stack[vector_size(draw_stack) - 1];
-            ScrBlockdef* prev_blockdef = prev_block.block->blockdef;
 
             Rectangle rect;
             rect.x = prev_block.pos.x;
             rect.y = prev_block.pos.y + prev_block.block->ms.size.y;
             rect.width = BLOCK_CONTROL_INDENT;
             rect.height = pos.y - (prev_block.pos.y + prev_block.block->ms.size.y);
-            DrawRectangleRec(rect, as_rl_color(prev_blockdef->color));
+            DrawRectangleRec(rect, block_heat_color(prev_block.block));
 
             bool touching_block = hover_info.block == &chain->blocks[i];
-            Color outline_color = ColorBrightness(as_rl_color(prev_blockdef->color), hover_info.block == prev_block.block || touching_block ? 0.5 : -0.2);
+            Color outline_color = ColorBrightness(block_heat_color(prev_block.block), hover_info.block == prev_block.block || touching_block ? 0.5 : -0.2);
             if (blockdef->type == BLOCKTYPE_END) {
-                Color end_color = ColorBrightness(as_rl_color(prev_blockdef->color), exec_highlight || touching_block ? 0.3 : 0.0);
+                Color end_color = ColorBrightness(block_heat_color(prev_block.block), exec_highlight || touching_block ? 0.3 : 0.0);
                 DrawRectangle(pos.x, pos.y, prev_block.block->ms.size.x, conf.font_size, end_color);
                 draw_control_outline(&prev_block, pos, outline_color, true);
             } else if (blockdef->type == BLOCKTYPE_CONTROLEND) {
@@ -1293,7 +1430,6 @@ void draw_block_chain(ScrBlockChain* chain, Vector2 camera_pos, bool chain_highl
     Rectangle rect;
     for (vec_size_t i = 0; i < vector_size(draw_stack); i++) {
         DrawStack prev_block = draw_stack[i];
-        ScrBlockdef* prev_blockdef = prev_block.block->blockdef;
 
         pos.x = prev_block.pos.x;
 
@@ -1302,8 +1438,8 @@ void draw_block_chain(ScrBlockChain* chain, Vector2 camera_pos, bool chain_highl
         rect.width = BLOCK_CONTROL_INDENT;
         rect.height = pos.y - (prev_block.pos.y + prev_block.block->ms.size.y);
 
-        DrawRectangleRec(rect, as_rl_color(prev_blockdef->color));
-        draw_control_outline(&prev_block, pos, ColorBrightness(as_rl_color(prev_blockdef->color), hover_info.block == prev_block.block ? 0.5 : -0.2), false);
+        DrawRectangleRec(rect, block_heat_color(prev_block.block));
+        draw_control_outline(&prev_block, pos, ColorBrightness(block_heat_color(prev_block.block), hover_info.block == prev_block.block ? 0.5 : -0.2), false);
     }
 }
 
@@ -1419,12 +1555,19 @@ void draw_top_bar(void) {
 
 void draw_tooltip(void) {
     if (hover_info.time_at_last_pos < 0.5 || !hover_info.block) return;
+    ScrBlockProfile* profile = profile_get(&block_profile, hover_info.block);
+    if (!profile || !profile->count) return;
 
     Vector2 pos = GetMousePosition();
     pos.x += 10.0;
     pos.y += 10.0;
 
-    char* text = "Amog";
+    const char* text = TextFormat(
+        "Runs: %zu\nTime: %.3f ms\nSelf time: %.3f ms",
+        profile->count,
+        profile->inclusive_ns / 1e6,
+        profile->exclusive_ns / 1e6
+    );
     Vector2 ms = MeasureTextEx(font_cond, text, conf.font_size * 0.5, 0);   
     DrawRectangle(pos.x - 5, pos.y - 5, ms.x + 10, ms.y + 10, (Color) { 0x00, 0x00, 0x00, 0x80 });
     DrawTextEx(font_cond, text, pos, conf.font_size * 0.5, 0, WHITE);
@@ -1553,7 +1696,7 @@ void draw_sidebar(void) {
 }
 
 void draw_term(void) {
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     DrawRectangleRec(out_win.size, BLACK);
     BeginShaderMode(line_shader);
     DrawRectangleLinesEx(out_win.size, 2.0, (Color) { 0x60, 0x60, 0x60, 0xff });
@@ -1578,7 +1721,7 @@ void draw_term(void) {
         }
     }
 
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
 }
 
 // https://easings.net/#easeOutExpo
@@ -1642,6 +1785,25 @@ void gui_restart_warning(void) {
         nk_tooltip(gui.ctx, "Needs restart for changes to take effect ");
 }
 
+// Web build downloads the file, native one asks where to save it
+void save_text_file(const char* text, const char* file_name, const char* filter, const char* description) {
+#ifdef __EMSCRIPTEN__
+    (void) filter;
+    (void) description;
+    EM_ASM({
+        const link = document.createElement('a');
+        link.href = URL.createObjectURL(new Blob([UTF8ToString($0)], { type: 'text/plain' }));
+        link.download = UTF8ToString($1);
+        link.click();
+        setTimeout(() => URL.revokeObjectURL(link.href), 0);
+    }, text, file_name);
+#else
+    char const* filters[] = {filter};
+    char* save_path = tinyfd_saveFileDialog(NULL, file_name, ARRLEN(filters), filters, description);
+    if (save_path) SaveFileText(save_path, (char*)text);
+#endif
+}
+
 void handle_gui(void) {
     if (gui.is_hiding) {
         gui.shown = false;
@@ -1720,6 +1882,24 @@ void handle_gui(void) {
             nk_property_int(gui.ctx, "#", 200, &gui_conf.block_size_threshold, 8000, 10, 10.0);
             nk_spacer(gui.ctx);
 
+            nk_spacer(gui.ctx);
+            nk_label(gui.ctx, "Profile blocks", NK_TEXT_RIGHT);
+            nk_spacer(gui.ctx);
+            nk_checkbox_label(gui.ctx, "", &gui_conf.profile_blocks);
+            nk_spacer(gui.ctx);
+
+            nk_spacer(gui.ctx);
+            nk_label(gui.ctx, "Sampling profiler", NK_TEXT_RIGHT);
+            nk_spacer(gui.ctx);
+            nk_checkbox_label(gui.ctx, "", &gui_conf.sample_profile);
+            nk_spacer(gui.ctx);
+
+            nk_spacer(gui.ctx);
+            nk_label(gui.ctx, "Trace execution", NK_TEXT_RIGHT);
+            nk_spacer(gui.ctx);
+            nk_checkbox_label(gui.ctx, "", &gui_conf.trace_execution);
+            nk_spacer(gui.ctx);
+
             nk_spacer(gui.ctx);
             nk_label(gui.ctx, "Font path", NK_TEXT_RIGHT);
             gui_restart_warning();
@@ -1813,7 +1993,7 @@ void handle_gui(void) {
         break;
     case GUI_TYPE_FILE:
         gui_size.x = 150 * conf.font_size / 32.0;
-        gui_size.y = conf.font_size * 2;
+        gui_size.y = conf.font_size * (2 + (sampled_profile != NULL) + (recorded_trace != NULL));
         gui.ctx->style.window.spacing = nk_vec2(0, 0);
         gui.ctx->style.button.text_alignment = NK_TEXT_LEFT;
 
@@ -1838,6 +2018,7 @@ void handle_gui(void) {
                     if (!chain) {
                         actionbar_show("File load failed :(");
                     } else {
+                        profile_free(&block_profile);
                         for (size_t i = 0; i < vector_size(editor_code); i++) blockchain_free(&editor_code[i]);
                         vector_free(editor_code);
                         editor_code = chain;
@@ -1850,6 +2031,12 @@ void handle_gui(void) {
                     }
                 }
             }
+            if (sampled_profile && nk_button_label(gui.ctx, "Export profile")) {
+                save_text_file(sampled_profile, "profile.folded", "*.folded", "Folded stacks (.folded)");
+            }
+            if (recorded_trace && nk_button_label(gui.ctx, "Export trace")) {
+                save_text_file(recorded_trace, "trace.json", "*.json", "Chrome trace files (.json)");
+            }
         }
         nk_end(gui.ctx);
         break;
@@ -1888,7 +2075,18 @@ bool handle_top_bar_click(void) {
             term_clear();
             exec = exec_new();
             exec_copy_code(&vm, &exec, editor_code);
+            profile_free(&block_profile);
+            if (conf.profile_blocks) {
+                profile_init(&block_profile, editor_code);
+                exec.profile = &block_profile;
+            }
             if (exec_start(&vm, &exec)) {
+                free(sampled_profile);
+                sampled_profile = NULL;
+                if (conf.sample_profile) sampler_start(&exec_sampler, &exec, VM_SAMPLE_INTERVAL_US);
+                free(recorded_trace);
+                recorded_trace = NULL;
+                if (conf.trace_execution) trace_start();
                 actionbar_show("Started successfully!");
                 if (current_tab != TAB_OUTPUT) {
                     shader_time = 0.0;
@@ -2208,6 +2406,8 @@ bool handle_mouse_click(void) {
     if (vm.is_running) return false;
 
     bool mouse_empty = vector_size(mouse_blockchain.blocks) == 0;
+    // Profile points to blocks by address, which may change after the click
+    if (!mouse_empty || hover_info.block) profile_free(&block_profile);
 
     if (hover_info.sidebar) return handle_sidebar_click(mouse_empty);
 
@@ -2396,21 +2596,47 @@ void check_block_collisions(void) {
 }
 
 void term_input_put_char(char ch) {
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     out_win.input_buf[out_win.buf_end] = ch;
     out_win.buf_end = (out_win.buf_end + 1) % TERM_INPUT_BUF_SIZE;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     sem_post(&out_win.input_sem);
 }
 
 char term_input_get_char(void) {
+    trace_begin("term_input_get_char");
     sem_wait(&out_win.input_sem);
-    pthread_mutex_lock(&out_win.lock);
+    trace_end("term_input_get_char");
+    term_lock();
     int out = out_win.input_buf[out_win.buf_start];
     out_win.buf_start = (out_win.buf_start + 1) % TERM_INPUT_BUF_SIZE;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     return out;
 }
+#else
+// Program is stopped once stdin runs out, same as if stop button was pressed
+char term_input_get_char(void) {
+    fflush(stdout);
+    trace_begin("term_input_get_char");
+    int ch = getchar();
+    trace_end("term_input_get_char");
+    if (ch == EOF) pthread_exit((void*)0);
+    return ch;
+}
+#endif
+
+// Both threads print to the terminal, so waiting for the lock and holding it are traced separately
+void term_lock(void) {
+    trace_begin("term_lock_wait");
+    pthread_mutex_lock(&out_win.lock);
+    trace_end("term_lock_wait");
+    trace_begin("term_lock_held");
+}
+
+void term_unlock(void) {
+    trace_end("term_lock_held");
+    pthread_mutex_unlock(&out_win.lock);
+}
 
 int leading_ones(unsigned char byte) {
     int out = 0;
@@ -2421,16 +2647,17 @@ int leading_ones(unsigned char byte) {
     return out;
 }
 
+#ifndef SCRAP_HEADLESS
 void term_scroll_down(void) {
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     memmove(out_win.buffer, out_win.buffer + out_win.char_w, out_win.char_w * (out_win.char_h - 1) * sizeof(*out_win.buffer));
     for (int i = out_win.char_w * (out_win.char_h - 1); i < out_win.char_w * out_win.char_h; i++) strncpy(out_win.buffer[i], " ", ARRLEN(*out_win.buffer));
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
 }
 
 int term_print_str(const char* str) {
     int len = 0;
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     while (*str) {
         if (out_win.cursor_pos >= out_win.char_w * out_win.char_h) {
             out_win.cursor_pos = out_win.char_w * out_win.char_h - out_win.char_w;
@@ -2461,10 +2688,29 @@ int term_print_str(const char* str) {
         out_win.cursor_pos++;
         len++;
     }
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
 
     return len;
 }
+#else
+int term_print_str(const char* str) {
+    int len = 0;
+    term_lock();
+    fputs(str, stdout);
+    for (; *str; str++) {
+        if (*str == '\n') {
+            if (out_win.cursor_pos + out_win.char_w < out_win.char_w * out_win.char_h) out_win.cursor_pos += out_win.char_w;
+        } else if (*str == '\r') {
+            out_win.cursor_pos -= out_win.cursor_pos % out_win.char_w;
+        } else if ((*str & 0xc0) != 0x80) {
+            if (out_win.cursor_pos < out_win.char_w * out_win.char_h - 1) out_win.cursor_pos++;
+            len++;
+        }
+    }
+    term_unlock();
+    return len;
+}
+#endif
 
 int term_print_int(int value) {
     char converted[12];
@@ -2478,15 +2724,16 @@ int term_print_double(double value) {
     return term_print_str(converted);
 }
 
+#ifndef SCRAP_HEADLESS
 void term_clear(void) {
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     for (int i = 0; i < out_win.char_w * out_win.char_h; i++) strncpy(out_win.buffer[i], " ", ARRLEN(*out_win.buffer));
     out_win.cursor_pos = 0;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
 }
 
 void term_resize(void) {
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     Vector2 screen_size = (Vector2) { GetScreenWidth() - 20, GetScreenHeight() - conf.font_size * 2.2 - 20 };
     out_win.size = (Rectangle) { 0, 0, 16, 9 };
     if (out_win.size.width / out_win.size.height > screen_size.x / screen_size.y) {
@@ -2513,7 +2760,7 @@ void term_resize(void) {
         out_win.buffer = malloc(buf_size);
         term_clear();
     }
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
 }
 
 void sanitize_block(ScrBlock* block) {
@@ -2546,6 +2793,9 @@ void set_default_config(Config* config) {
     config->side_bar_size = 300;
     config->fps_limit = 60;
     config->block_size_threshold = 1000;
+    config->profile_blocks = false;
+    config->sample_profile = false;
+    config->trace_execution = false;
     strncpy(config->font_symbols, "qwertyuiopasdfghjklzxcvbnmQWERTYUIOPASDFGHJKLZXCVBNMйцукенгшщзхъфывапролджэячсмитьбюёЙЦУКЕНГШЩЗХЪФЫВАПРОЛДЖЭЯЧСМИТЬБЮЁ ,./;'\\[]=-0987654321`~!@#$%^&*()_+{}:\"|<>?", sizeof(config->font_symbols) - 1);
     const char* path = into_data_path("nk57-cond.otf");
     strncpy(config->font_path, path, sizeof(config->font_path) - 1);
@@ -2560,6 +2810,9 @@ void apply_config(Config* dst, Config* src) {
     SetTargetFPS(dst->fps_limit);
     dst->block_size_threshold = src->block_size_threshold;
     dst->side_bar_size = src->side_bar_size;
+    dst->profile_blocks = src->profile_blocks;
+    dst->sample_profile = src->sample_profile;
+    dst->trace_execution = src->trace_execution;
 }
 
 void save_config(Config* config) {
@@ -2569,6 +2822,9 @@ void save_config(Config* config) {
     file_size += ARRLEN("SIDE_BAR_SIZE") + 10 + 1;
     file_size += ARRLEN("FPS_LIMIT") + 10 + 1;
     file_size += ARRLEN("BLOCK_SIZE_THRESHOLD") + 10 + 1;
+    file_size += ARRLEN("PROFILE_BLOCKS") + 1 + 1;
+    file_size += ARRLEN("SAMPLE_PROFILE") + 1 + 1;
+    file_size += ARRLEN("TRACE_EXECUTION") + 1 + 1;
     file_size += ARRLEN("FONT_SYMBOLS") + strlen(config->font_symbols) + 1;
     file_size += ARRLEN("FONT_PATH") + strlen(config->font_path) + 1;
     file_size += ARRLEN("FONT_BOLD_PATH") + strlen(config->font_bold_path) + 1;
@@ -2581,6 +2837,9 @@ void save_config(Config* config) {
     cursor += sprintf(file_str + cursor, "SIDE_BAR_SIZE=%u\n", config->side_bar_size);
     cursor += sprintf(file_str + cursor, "FPS_LIMIT=%u\n", config->fps_limit);
     cursor += sprintf(file_str + cursor, "BLOCK_SIZE_THRESHOLD=%u\n", config->block_size_threshold);
+    cursor += sprintf(file_str + cursor, "PROFILE_BLOCKS=%u\n", config->profile_blocks);
+    cursor += sprintf(file_str + cursor, "SAMPLE_PROFILE=%u\n", config->sample_profile);
+    cursor += sprintf(file_str + cursor, "TRACE_EXECUTION=%u\n", config->trace_execution);
     cursor += sprintf(file_str + cursor, "FONT_SYMBOLS=%s\n", config->font_symbols);
     cursor += sprintf(file_str + cursor, "FONT_PATH=%s\n", config->font_path);
     cursor += sprintf(file_str + cursor, "FONT_BOLD_PATH=%s\n", config->font_bold_path);
@@ -2629,6 +2888,12 @@ void load_config(Config* config) {
         } else if (!strcmp(field, "BLOCK_SIZE_THRESHOLD")) {
             int val = atoi(value);
             config->block_size_threshold = val ? val : config->block_size_threshold;
+        } else if (!strcmp(field, "PROFILE_BLOCKS")) {
+            config->profile_blocks = atoi(value) != 0;
+        } else if (!strcmp(field, "SAMPLE_PROFILE")) {
+            config->sample_profile = atoi(value) != 0;
+        } else if (!strcmp(field, "TRACE_EXECUTION")) {
+            config->trace_execution = atoi(value) != 0;
         } else if (!strcmp(field, "FONT_SYMBOLS")) {
             strncpy(config->font_symbols, value, sizeof(config->font_symbols) - 1);
         } else if (!strcmp(field, "FONT_PATH")) {
@@ -2644,6 +2909,51 @@ void load_config(Config* config) {
 
     UnloadFileText(file);
 }
+#else
+void term_clear(void) {
+    term_lock();
+    if (isatty(STDOUT_FILENO)) fputs("\x1b[2J\x1b[H", stdout);
+    out_win.cursor_pos = 0;
+    term_unlock();
+}
+
+// Size reported by the cursor blocks, output itself is not limited by it
+void term_init(int char_w, int char_h) {
+    pthread_mutex_init(&out_win.lock, NULL);
+    out_win.char_w = char_w;
+    out_win.char_h = char_h;
+    out_win.cursor_pos = 0;
+}
+
+bool headless_wait(ScrSampler* sampler) {
+    if (sampler) sampler_start(sampler, &exec, VM_SAMPLE_INTERVAL_US);
+    // exec_join expects exec to still be running, but here it may have already finished
+    void* return_code;
+    pthread_join(exec.thread, &return_code);
+    if (sampler) sampler_stop(sampler);
+    vm.is_running = false;
+    exec_free(&exec);
+    fflush(stdout);
+    return return_code == (void*)1;
+}
+
+// Runs on_start chains of code and waits for them to finish. Returns false
+// if exec could not start or stopped with an error
+// Samples the run into sampler unless it is NULL
+bool headless_run(ScrBlockChain* code, ScrSampler* sampler) {
+    exec = exec_new();
+    exec_copy_code(&vm, &exec, code);
+    if (!exec_start(&vm, &exec)) return false;
+    return headless_wait(sampler);
+}
+
+// Same as headless_run for chains of a project compiled by scrap-aot
+bool headless_run_compiled(ScrCompiledChain* chains, size_t len) {
+    exec = exec_new();
+    if (!exec_start_compiled(&vm, &exec, chains, len)) return false;
+    return headless_wait(NULL);
+}
+#endif
 
 SaveArena new_save(size_t size) {
     void* ptr = malloc(size); 
@@ -2758,7 +3068,7 @@ void save_block_arguments(SaveArena* save, ScrArgument* arg) {
     switch (arg->type) {
     case ARGUMENT_TEXT:
     case ARGUMENT_CONST_STRING:
-        save_add_varint(save, save_find_id(arg->data.text));
+        save_add_varint(save, save_find_id(intern_str(arg->data.text)));
         break;
     case ARGUMENT_BLOCK:
         save_block(save, &arg->data.block);
@@ -2799,9 +3109,10 @@ void rename_blockdef(ScrBlockdef* blockdef, int id) {
     }
 }
 
+// id must be interned
 int save_find_id(const char* id) {
     for (size_t i = 0; i < vector_size(save_block_ids); i++) {
-        if (!strcmp(save_block_ids[i], id)) return i;
+        if (save_block_ids[i] == id) return i;
     }
     return -1;
 }
@@ -2817,7 +3128,7 @@ void block_collect_ids(ScrBlock* block) {
         switch (block->arguments[i].type) {
         case ARGUMENT_TEXT:
         case ARGUMENT_CONST_STRING:
-            save_add_id(block->arguments[i].data.text);
+            save_add_id(intern_str(block->arguments[i].data.text));
             break;
         case ARGUMENT_BLOCK:
             block_collect_ids(&block->arguments[i].data.block);
@@ -2878,9 +3189,10 @@ void save_code(const char* file_path, ScrBlockChain* code) {
     free_save(&save);
 }
 
+// id must be interned
 ScrBlockdef* find_blockdef(ScrBlockdef** blockdefs, const char* id) {
     for (size_t i = 0; i < vector_size(blockdefs); i++) {
-        if (!strcmp(id, blockdefs[i]->id)) return blockdefs[i];
+        if (blockdefs[i]->id == id) return blockdefs[i];
     }
     return NULL;
 }
@@ -2949,9 +3261,11 @@ ScrBlockdef* load_blockdef(SaveArena* save) {
     if (!save_read_varint(save, &input_count)) return NULL;
 
     ScrBlockdef* blockdef = malloc(sizeof(ScrBlockdef));
-    blockdef->id = strcpy(malloc(id_len * sizeof(char)), id);
+    blockdef->id = intern_str(id);
     blockdef->color = *color;
     blockdef->type = type;
+    blockdef->short_circuit = SHORT_CIRCUIT_NONE;
+    blockdef->builtin = BUILTIN_NONE;
     blockdef->ms = (ScrMeasurement) {0};
     blockdef->hidden = false;
     blockdef->ref_count = 0;
@@ -2981,6 +3295,7 @@ bool load_block_argument(SaveArena* save, ScrArgument* arg) {
 
     arg->type = arg_type;
     arg->input_id = input_id;
+    arg->value = (ScrData) {0};
 
     switch (arg_type) {
     case ARGUMENT_TEXT:
@@ -3050,7 +3365,9 @@ bool load_block(SaveArena* save, ScrBlock* block) {
         vector_add(&block->arguments, arg);
     }
 
+#ifndef SCRAP_HEADLESS
     update_measurements(block, PLACEMENT_HORIZONTAL);
+#endif
     return true;
 }
 
@@ -3077,19 +3394,15 @@ bool load_blockchain(SaveArena* save, ScrBlockChain* chain) {
     return true;
 }
 
-ScrBlockChain* load_code(const char* file_path) {
+ScrBlockChain* load_code_from_memory(void* data, int size) {
     ScrBlockChain* code = vector_create();
     save_blockdefs = vector_create();
     save_block_ids = vector_create();
 
-    int save_size;
-    void* file_data = LoadFileData(file_path, &save_size);
-    if (!file_data) goto load_fail;
-
     SaveArena save;
-    save.ptr = file_data;
-    save.next = file_data;
-    save.max_size = save_size;
+    save.ptr = data;
+    save.next = data;
+    save.max_size = size;
     save.used_size = 0;
 
     unsigned int ver;
@@ -3118,7 +3431,7 @@ ScrBlockChain* load_code(const char* file_path) {
         if (id_len == 0) goto load_fail;
         if (id[id_len - 1] != 0) goto load_fail;
 
-        vector_add(&save_block_ids, id);
+        vector_add(&save_block_ids, intern_str(id));
     }
 
     unsigned int custom_block_len;
@@ -3137,13 +3450,11 @@ ScrBlockChain* load_code(const char* file_path) {
         if (!load_blockchain(&save, &chain)) goto load_fail;
         vector_add(&code, chain);
     }
-    UnloadFileData(file_data);
     vector_free(save_block_ids);
     vector_free(save_blockdefs);
     return code;
 
 load_fail:
-    if (file_data) UnloadFileData(file_data);
     for (size_t i = 0; i < vector_size(code); i++) blockchain_free(&code[i]);
     vector_free(code);
     vector_free(save_block_ids);
@@ -3151,6 +3462,15 @@ load_fail:
     return NULL;
 }
 
+ScrBlockChain* load_code(const char* file_path) {
+    int save_size;
+    void* file_data = LoadFileData(file_path, &save_size);
+    if (!file_data) return NULL;
+    ScrBlockChain* code = load_code_from_memory(file_data, save_size);
+    UnloadFileData(file_data);
+    return code;
+}
+
 ScrData block_noop(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     (void) argc;
@@ -3270,6 +3590,91 @@ ScrData block_repeat(ScrExec* exec, int argc, ScrData* argv) {
     RETURN_OMIT_ARGS;
 }
 
+typedef struct {
+    size_t running_ind;
+    size_t var_ind;
+    int counter;
+    int end;
+    int step;
+} ForLoop;
+
+void for_set_counter(ScrExec* exec, size_t var_ind, int counter) {
+    if (var_ind == (size_t)-1) return;
+    exec->variable_stack[var_ind].value = (ScrData) {
+        .type = DATA_INT,
+        .storage = DATA_STORAGE_STATIC,
+        .data = (ScrDataContents) {
+            .int_arg = counter,
+        },
+    };
+}
+
+// Visualization of control stack (stack grows downwards):
+// - ForLoop, updated in place on every iteration
+// - 1 <- indicator for end block to do looping
+//
+// If the loop should not loop then the stack will look like this:
+// - 0 <- indicator for end block that it should stop immediately
+//
+// The loop variable is read only, so it always holds the counter
+ScrData block_for(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 1) RETURN_OMIT_ARGS;
+    if (argv[0].type != DATA_CONTROL) RETURN_OMIT_ARGS;
+
+    if (argv[0].data.control_arg == CONTROL_ARG_BEGIN) {
+        if (argc < 5) RETURN_OMIT_ARGS;
+        ForLoop loop = {
+            .running_ind = exec->chain_stack[exec->chain_stack_len - 1].running_ind,
+            .var_ind = (size_t)-1,
+            .counter = data_to_int(argv[2]),
+            .end = data_to_int(argv[3]),
+            .step = data_to_int(argv[4]),
+        };
+        if (loop.step == 0 || (loop.step > 0 && loop.counter > loop.end) || (loop.step < 0 && loop.counter < loop.end)) {
+            exec_set_skip_block(exec);
+            control_stack_push_data((int)0, int) // This indicates the end block that it should NOT loop
+            RETURN_OMIT_ARGS;
+        }
+
+        if (argv[1].type == DATA_STR && argv[1].storage.type == DATA_STORAGE_STATIC) {
+            ScrData value = { .type = DATA_NOTHING, .storage.type = DATA_STORAGE_STATIC };
+            if (variable_stack_push_var(exec, argv[1].data.str_arg, value)) {
+                loop.var_ind = exec->variable_stack_len - 1;
+                exec->variable_stack[loop.var_ind].read_only = true;
+            }
+        }
+        for_set_counter(exec, loop.var_ind, loop.counter);
+
+        control_stack_push_data(loop, ForLoop)
+        control_stack_push_data((int)1, int) // This indicates the end block that it should loop
+    } else if (argv[0].data.control_arg == CONTROL_ARG_END) {
+        if (exec->control_stack_len < sizeof(int)) {
+            printf("[VM] CRITICAL: Control stack underflow\n");
+            pthread_exit((void*)0);
+        }
+        if (!*(int*)(exec->control_stack + exec->control_stack_len - sizeof(int))) {
+            exec->control_stack_len -= sizeof(int);
+            RETURN_BOOL(0);
+        }
+        ForLoop* loop = (ForLoop*)(exec->control_stack + exec->control_stack_len - sizeof(int) - sizeof(ForLoop));
+
+        // Wraps instead of overflowing, so the loop still stops at INT_MAX
+        int next = (int)((unsigned int)loop->counter + (unsigned int)loop->step);
+        bool done = loop->step > 0 ? (next > loop->end || next < loop->counter) : (next < loop->end || next > loop->counter);
+        if (done) {
+            // Loop body variables are gone by now, so the loop variable is on top
+            if (loop->var_ind != (size_t)-1) exec->variable_stack_len = loop->var_ind;
+            exec->control_stack_len -= sizeof(int) + sizeof(ForLoop);
+            RETURN_BOOL(1);
+        }
+        loop->counter = next;
+        for_set_counter(exec, loop->var_ind, next);
+        atomic_store_explicit(&exec->chain_stack[exec->chain_stack_len - 1].running_ind, loop->running_ind, memory_order_relaxed);
+    }
+
+    RETURN_OMIT_ARGS;
+}
+
 ScrData block_while(ScrExec* exec, int argc, ScrData* argv) {
     if (argc < 2) RETURN_BOOL(0);
     if (argv[0].type != DATA_CONTROL) RETURN_BOOL(0);
@@ -3300,7 +3705,10 @@ ScrData block_sleep(ScrExec* exec, int argc, ScrData* argv) {
     if (argc < 1) RETURN_INT(0);
     int usecs = data_to_int(argv[0]);
     if (usecs < 0) RETURN_INT(0);
-    if (usleep(usecs)) RETURN_INT(0);
+    trace_begin("sleep");
+    int result = usleep(usecs);
+    trace_end("sleep");
+    if (result) RETURN_INT(0);
     RETURN_INT(usecs);
 }
 
@@ -3308,8 +3716,7 @@ ScrData block_declare_var(ScrExec* exec, int argc, ScrData* argv) {
     if (argc < 2) RETURN_NOTHING;
     if (argv[0].type != DATA_STR || argv[0].storage.type != DATA_STORAGE_STATIC) RETURN_NOTHING;
 
-    ScrData var_value = data_copy(argv[1]);
-    if (var_value.storage.type == DATA_STORAGE_MANAGED) var_value.storage.type = DATA_STORAGE_UNMANAGED;
+    ScrData var_value = data_take(&argv[1]);
 
     variable_stack_push_var(exec, argv[0].data.str_arg, var_value);
     return var_value;
@@ -3317,7 +3724,7 @@ ScrData block_declare_var(ScrExec* exec, int argc, ScrData* argv) {
 
 ScrData block_get_var(ScrExec* exec, int argc, ScrData* argv) {
     if (argc < 1) RETURN_NOTHING;
-    ScrVariable* var = variable_stack_get_variable(exec, data_to_str(argv[0]));
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
     if (!var) RETURN_NOTHING;
     return var->value;
 }
@@ -3325,11 +3732,10 @@ ScrData block_get_var(ScrExec* exec, int argc, ScrData* argv) {
 ScrData block_set_var(ScrExec* exec, int argc, ScrData* argv) {
     if (argc < 2) RETURN_NOTHING;
 
-    ScrVariable* var = variable_stack_get_variable(exec, data_to_str(argv[0]));
-    if (!var) RETURN_NOTHING;
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
+    if (!var || var->read_only) RETURN_NOTHING;
 
-    ScrData new_value = data_copy(argv[1]);
-    if (new_value.storage.type == DATA_STORAGE_MANAGED) new_value.storage.type = DATA_STORAGE_UNMANAGED;
+    ScrData new_value = data_take(&argv[1]);
 
     if (var->value.storage.type == DATA_STORAGE_UNMANAGED) {
         data_free(var->value);
@@ -3350,6 +3756,7 @@ ScrData block_create_list(ScrExec* exec, int argc, ScrData* argv) {
     out.storage.storage_len = 0;
     out.data.list_arg.items = NULL;
     out.data.list_arg.len = 0;
+    out.data.list_arg.buffer = NULL;
     return out;
 }
 
@@ -3357,35 +3764,338 @@ ScrData block_list_add(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc < 2) RETURN_NOTHING;
 
-    ScrVariable* var = variable_stack_get_variable(exec, data_to_str(argv[0]));
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
     if (!var) RETURN_NOTHING;
     if (var->value.type != DATA_LIST) RETURN_NOTHING;
 
-    if (!var->value.data.list_arg.items) {
-        var->value.data.list_arg.items = malloc(sizeof(ScrData));
-        var->value.data.list_arg.len = 1;
+    // Take the value first, it may point into the buffer that is about to be resized
+    ScrData new_value = data_take(&argv[1]);
+    list_resize(&var->value, var->value.data.list_arg.len + 1);
+    ScrData* list_item = &var->value.data.list_arg.items[var->value.data.list_arg.len - 1];
+    *list_item = new_value;
+
+    return *list_item;
+}
+
+ScrDataList* block_get_list(ScrExec* exec, ScrData name) {
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(name));
+    if (!var) return NULL;
+    if (var->value.type != DATA_LIST) return NULL;
+    return &var->value.data.list_arg;
+}
+
+int list_item_cmp(ScrData a, ScrData b, ListSortOrder order) {
+    if (order == LIST_SORT_NUMBERS) {
+        double a_num = data_to_double(a), b_num = data_to_double(b);
+        return (a_num > b_num) - (a_num < b_num);
+    }
+
+    // data_to_str reuses one buffer for numbers, so keep a copy of the left side
+    char buf[32];
+    const char* a_str = data_to_str(a);
+    if (a.type != DATA_STR) {
+        snprintf(buf, sizeof(buf), "%s", a_str);
+        a_str = buf;
+    }
+    return strcmp(a_str, data_to_str(b));
+}
+
+void list_insertion_sort(ScrData* items, size_t len, ListSortOrder order) {
+    for (size_t i = 1; i < len; i++) {
+        ScrData item = items[i];
+        size_t j = i;
+        while (j > 0 && list_item_cmp(items[j - 1], item, order) > 0) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = item;
+    }
+}
+
+void list_sift_down(ScrData* items, size_t root, size_t len, ListSortOrder order) {
+    ScrData item = items[root];
+    while (root * 2 + 1 < len) {
+        size_t child = root * 2 + 1;
+        if (child + 1 < len && list_item_cmp(items[child], items[child + 1], order) < 0) child++;
+        if (list_item_cmp(item, items[child], order) >= 0) break;
+        items[root] = items[child];
+        root = child;
+    }
+    items[root] = item;
+}
+
+void list_heap_sort(ScrData* items, size_t len, ListSortOrder order) {
+    for (size_t i = len / 2; i > 0; i--) list_sift_down(items, i - 1, len, order);
+    for (size_t i = len - 1; i > 0; i--) {
+        ScrData tmp = items[0];
+        items[0] = items[i];
+        items[i] = tmp;
+        list_sift_down(items, 0, i, order);
+    }
+}
+
+// Introsort: quicksort with median of three pivot, falling back to heapsort
+// when recursion gets too deep and to insertion sort for short ranges
+void list_intro_sort(ScrData* items, size_t len, int depth, ListSortOrder order) {
+    while (len > 16) {
+        if (depth-- == 0) {
+            list_heap_sort(items, len, order);
+            return;
+        }
+
+        ScrData* a = &items[0];
+        ScrData* b = &items[len / 2];
+        ScrData* c = &items[len - 1];
+        ScrData* pivot_ptr;
+        if (list_item_cmp(*a, *b, order) < 0) {
+            if (list_item_cmp(*b, *c, order) < 0) pivot_ptr = b;
+            else pivot_ptr = list_item_cmp(*a, *c, order) < 0 ? c : a;
+        } else {
+            if (list_item_cmp(*a, *c, order) < 0) pivot_ptr = a;
+            else pivot_ptr = list_item_cmp(*b, *c, order) < 0 ? c : b;
+        }
+        ScrData pivot = *pivot_ptr;
+
+        size_t i = 0, j = len - 1;
+        for (;;) {
+            while (list_item_cmp(items[i], pivot, order) < 0) i++;
+            while (list_item_cmp(pivot, items[j], order) < 0) j--;
+            if (i >= j) break;
+            ScrData tmp = items[i];
+            items[i] = items[j];
+            items[j] = tmp;
+            i++;
+            j--;
+        }
+
+        // Recurse into the smaller half to keep the stack shallow
+        size_t left_len = j + 1;
+        if (left_len < len - left_len) {
+            list_intro_sort(items, left_len, depth, order);
+            items += left_len;
+            len -= left_len;
+        } else {
+            list_intro_sort(items + left_len, len - left_len, depth, order);
+            len = left_len;
+        }
+    }
+    list_insertion_sort(items, len, order);
+}
+
+ScrData block_list_sort(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrDataList* list = block_get_list(exec, argv[0]);
+    if (!list || !list->items) RETURN_NOTHING;
+    if (argv[1].type != DATA_INT || argv[1].data.int_arg < 0) RETURN_NOTHING;
+    list_unshare(list);
+
+    int depth = 0;
+    for (size_t n = list->len; n > 1; n >>= 1) depth += 2;
+    list_intro_sort(list->items, list->len, depth, argv[1].data.int_arg);
+    RETURN_NOTHING;
+}
+
+ScrData block_list_reverse(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 1) RETURN_NOTHING;
+    ScrDataList* list = block_get_list(exec, argv[0]);
+    if (!list || list->len < 2) RETURN_NOTHING;
+    list_unshare(list);
+
+    for (size_t i = 0, j = list->len - 1; i < j; i++, j--) {
+        ScrData tmp = list->items[i];
+        list->items[i] = list->items[j];
+        list->items[j] = tmp;
+    }
+    RETURN_NOTHING;
+}
+
+ScrData block_list_index_of(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_INT(-1);
+    if (argv[1].type != DATA_LIST) RETURN_INT(-1);
+
+    ScrDataList* list = &argv[1].data.list_arg;
+    for (size_t i = 0; i < list->len; i++) {
+        ScrData pair[2] = { argv[0], list->items[i] };
+        if (block_eq(exec, 2, pair).data.int_arg) RETURN_INT(i);
+    }
+    RETURN_INT(-1);
+}
+
+ScrData block_list_slice(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 3) return block_create_list(exec, 0, NULL);
+    if (argv[0].type != DATA_LIST) return block_create_list(exec, 0, NULL);
+
+    int start = data_to_int(argv[1]);
+    int end = data_to_int(argv[2]);
+    if (start < 0) start = 0;
+    if (end > (int)argv[0].data.list_arg.len) end = argv[0].data.list_arg.len;
+    if (start >= end) return block_create_list(exec, 0, NULL);
+
+    return list_view(argv[0], start, end - start);
+}
+
+ScrData block_list_concat(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) return block_create_list(exec, 0, NULL);
+    if (argv[0].type != DATA_LIST || argv[1].type != DATA_LIST) return block_create_list(exec, 0, NULL);
+
+    // Reuse the left list's buffer when it is a temporary
+    ScrData out;
+    if (argv[0].storage.type == DATA_STORAGE_MANAGED) {
+        out = argv[0];
+        argv[0].storage.type = DATA_STORAGE_UNMANAGED;
     } else {
-        var->value.data.list_arg.items = realloc(var->value.data.list_arg.items, ++var->value.data.list_arg.len * sizeof(ScrData));
+        out = data_copy(argv[0]);
     }
-    var->value.storage.storage_len = var->value.data.list_arg.len * sizeof(ScrData);
-    ScrData* list_item = &var->value.data.list_arg.items[var->value.data.list_arg.len - 1];
-    if (argv[1].storage.type == DATA_STORAGE_MANAGED) {
+
+    size_t left_len = out.data.list_arg.len;
+    size_t right_len = argv[1].data.list_arg.len;
+    if (right_len == 0) return out;
+    list_resize(&out, left_len + right_len);
+
+    ScrListBuffer* right_buffer = argv[1].data.list_arg.buffer;
+    if (argv[1].storage.type == DATA_STORAGE_MANAGED && right_buffer->refs == 1 && right_buffer->len == right_len) {
+        memcpy(out.data.list_arg.items + left_len, right_buffer->items, right_len * sizeof(ScrData));
+        free(right_buffer);
         argv[1].storage.type = DATA_STORAGE_UNMANAGED;
-        *list_item = argv[1];
     } else {
-        *list_item = data_copy(argv[1]);
-        if (list_item->storage.type == DATA_STORAGE_MANAGED) list_item->storage.type = DATA_STORAGE_UNMANAGED;
+        for (size_t i = 0; i < right_len; i++) out.data.list_arg.items[left_len + i] = data_take(&argv[1].data.list_arg.items[i]);
     }
+    return out;
+}
 
-    return *list_item;
+ScrData block_list_insert(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 3) RETURN_NOTHING;
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
+    if (!var) RETURN_NOTHING;
+    if (var->value.type != DATA_LIST) RETURN_NOTHING;
+
+    size_t len = var->value.data.list_arg.len;
+    int index = data_to_int(argv[1]);
+    if (index < 0 || (size_t)index > len) RETURN_NOTHING;
+
+    ScrData new_value = data_take(&argv[2]);
+    list_resize(&var->value, len + 1);
+    ScrData* items = var->value.data.list_arg.items;
+    memmove(&items[index + 1], &items[index], (len - index) * sizeof(ScrData));
+    items[index] = new_value;
+    return items[index];
+}
+
+ScrData block_list_remove(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
+    if (!var) RETURN_NOTHING;
+    if (var->value.type != DATA_LIST) RETURN_NOTHING;
+
+    size_t len = var->value.data.list_arg.len;
+    int index = data_to_int(argv[1]);
+    if (index < 0 || (size_t)index >= len) RETURN_NOTHING;
+
+    list_unshare(&var->value.data.list_arg);
+    ScrData* items = var->value.data.list_arg.items;
+    data_free(items[index]);
+    memmove(&items[index], &items[index + 1], (len - index - 1) * sizeof(ScrData));
+    list_resize(&var->value, len - 1);
+    RETURN_NOTHING;
+}
+
+ScrDataMap* block_get_map(ScrExec* exec, ScrData name) {
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(name));
+    if (!var) return NULL;
+    if (var->value.type != DATA_MAP) return NULL;
+    return &var->value.data.map_arg;
+}
+
+ScrData block_create_map(ScrExec* exec, int argc, ScrData* argv) {
+    (void) exec;
+    (void) argc;
+    (void) argv;
+    return data_map_new();
+}
+
+ScrData block_map_put(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 3) RETURN_NOTHING;
+    if (!map_key_valid(argv[1])) RETURN_NOTHING;
+
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
+    if (!var) RETURN_NOTHING;
+    if (var->value.type != DATA_MAP) RETURN_NOTHING;
+
+    ScrData key = data_take(&argv[1]);
+    ScrData value = data_take(&argv[2]);
+    map_put(&var->value, key, value);
+    RETURN_NOTHING;
+}
+
+ScrData block_map_get(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrDataMap* map = block_get_map(exec, argv[0]);
+    if (!map) RETURN_NOTHING;
+
+    ScrData* value = map_get(map, argv[1]);
+    if (!value) RETURN_NOTHING;
+    return *value;
+}
+
+ScrData block_map_has(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_BOOL(0);
+    ScrDataMap* map = block_get_map(exec, argv[0]);
+    if (!map) RETURN_BOOL(0);
+    RETURN_BOOL(map_get(map, argv[1]) != NULL);
+}
+
+ScrData block_map_remove(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrDataMap* map = block_get_map(exec, argv[0]);
+    if (!map) RETURN_NOTHING;
+    map_remove(map, argv[1]);
+    RETURN_NOTHING;
+}
+
+ScrData block_map_keys(ScrExec* exec, int argc, ScrData* argv) {
+    ScrData out = block_create_list(exec, 0, NULL);
+    if (argc < 1) return out;
+    if (argv[0].type != DATA_MAP || argv[0].data.map_arg.len == 0) return out;
+
+    ScrDataMap* map = &argv[0].data.map_arg;
+    list_resize(&out, map->len);
+    size_t len = 0;
+    for (size_t i = 0; i < map->cap; i++) {
+        if (map->entries[i].key.type == DATA_NOTHING) continue;
+        out.data.list_arg.items[len++] = data_take(&map->entries[i].key);
+    }
+    return out;
+}
+
+ScrData array_get_item(ScrDataArray* array, int index) {
+    if (index < 0 || (size_t)index >= array->len) RETURN_NOTHING;
+    if (array->type == ARRAY_INT) RETURN_INT(((int*)array->items)[index]);
+    RETURN_DOUBLE(((double*)array->items)[index]);
+}
+
+void array_set_item(ScrDataArray* array, int index, ScrData value) {
+    if (index < 0 || (size_t)index >= array->len) return;
+    if (array->type == ARRAY_INT) {
+        ((int*)array->items)[index] = data_to_int(value);
+    } else {
+        ((double*)array->items)[index] = data_to_double(value);
+    }
+}
+
+ScrDataArray* block_get_array(ScrExec* exec, ScrData name) {
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(name));
+    if (!var) return NULL;
+    if (var->value.type != DATA_ARRAY) return NULL;
+    return &var->value.data.array_arg;
 }
 
 ScrData block_list_get(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc < 2) RETURN_NOTHING;
 
-    ScrVariable* var = variable_stack_get_variable(exec, data_to_str(argv[0]));
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
     if (!var) RETURN_NOTHING;
+    if (var->value.type == DATA_ARRAY) return array_get_item(&var->value.data.array_arg, data_to_int(argv[1]));
     if (var->value.type != DATA_LIST) RETURN_NOTHING;
     if (!var->value.data.list_arg.items || var->value.data.list_arg.len == 0) RETURN_NOTHING;
     int index = data_to_int(argv[1]);
@@ -3398,15 +4108,19 @@ ScrData block_list_set(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc < 3) RETURN_NOTHING;
 
-    ScrVariable* var = variable_stack_get_variable(exec, data_to_str(argv[0]));
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(argv[0]));
     if (!var) RETURN_NOTHING;
+    if (var->value.type == DATA_ARRAY) {
+        array_set_item(&var->value.data.array_arg, data_to_int(argv[1]), argv[2]);
+        return array_get_item(&var->value.data.array_arg, data_to_int(argv[1]));
+    }
     if (var->value.type != DATA_LIST) RETURN_NOTHING;
     if (!var->value.data.list_arg.items || var->value.data.list_arg.len == 0) RETURN_NOTHING;
     int index = data_to_int(argv[1]);
     if (index < 0 || (size_t)index >= var->value.data.list_arg.len) RETURN_NOTHING;
 
-    ScrData new_value = data_copy(argv[2]);
-    if (new_value.storage.type == DATA_STORAGE_MANAGED) new_value.storage.type = DATA_STORAGE_UNMANAGED;
+    ScrData new_value = data_take(&argv[2]);
+    list_unshare(&var->value.data.list_arg);
 
     if (var->value.data.list_arg.items[index].storage.type == DATA_STORAGE_UNMANAGED) {
         data_free(var->value.data.list_arg.items[index]);
@@ -3415,6 +4129,124 @@ ScrData block_list_set(ScrExec* exec, int argc, ScrData* argv) {
     return var->value.data.list_arg.items[index];
 }
 
+ScrData block_create_array(ScrExec* exec, int argc, ScrData* argv) {
+    (void) exec;
+    if (argc < 2) RETURN_NOTHING;
+    if (argv[0].type != DATA_INT || argv[0].data.int_arg < 0) RETURN_NOTHING;
+
+    int len = data_to_int(argv[1]);
+    if (len < 0) len = 0;
+    return data_array_new(argv[0].data.int_arg, len);
+}
+
+ScrData block_array_fill(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrDataArray* array = block_get_array(exec, argv[0]);
+    if (!array) RETURN_NOTHING;
+
+    if (array->type == ARRAY_INT) {
+        array_int_fill(array->items, array->len, data_to_int(argv[1]));
+    } else {
+        array_double_fill(array->items, array->len, data_to_double(argv[1]));
+    }
+    RETURN_NOTHING;
+}
+
+ScrData block_array_add(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrDataArray* array = block_get_array(exec, argv[0]);
+    if (!array) RETURN_NOTHING;
+
+    if (argv[1].type == DATA_ARRAY) {
+        ScrDataArray* src = &argv[1].data.array_arg;
+        size_t len = src->len < array->len ? src->len : array->len;
+        if (array->type == src->type) {
+            if (array->type == ARRAY_INT) {
+                array_int_add(array->items, src->items, len);
+            } else {
+                array_double_add(array->items, src->items, len);
+            }
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                ScrData sum = array_get_item(array, i);
+                ScrData item = array_get_item(src, i);
+                sum.data.double_arg = data_to_double(sum) + data_to_double(item);
+                sum.type = DATA_DOUBLE;
+                array_set_item(array, i, sum);
+            }
+        }
+        RETURN_NOTHING;
+    }
+
+    if (array->type == ARRAY_INT) {
+        array_int_add_scalar(array->items, array->len, data_to_int(argv[1]));
+    } else {
+        array_double_add_scalar(array->items, array->len, data_to_double(argv[1]));
+    }
+    RETURN_NOTHING;
+}
+
+ScrData block_array_mul(ScrExec* exec, int argc, ScrData* argv) {
+    if (argc < 2) RETURN_NOTHING;
+    ScrDataArray* array = block_get_array(exec, argv[0]);
+    if (!array) RETURN_NOTHING;
+
+    if (array->type == ARRAY_INT) {
+        array_int_mul_scalar(array->items, array->len, data_to_int(argv[1]));
+    } else {
+        array_double_mul_scalar(array->items, array->len, data_to_double(argv[1]));
+    }
+    RETURN_NOTHING;
+}
+
+ScrData block_array_dot(ScrExec* exec, int argc, ScrData* argv) {
+    (void) exec;
+    if (argc < 2) RETURN_NOTHING;
+    if (argv[0].type != DATA_ARRAY || argv[1].type != DATA_ARRAY) RETURN_NOTHING;
+
+    ScrDataArray* a = &argv[0].data.array_arg;
+    ScrDataArray* b = &argv[1].data.array_arg;
+    size_t len = a->len < b->len ? a->len : b->len;
+    if (a->type == b->type) {
+        if (a->type == ARRAY_INT) RETURN_INT(array_int_dot(a->items, b->items, len));
+        RETURN_DOUBLE(array_double_dot(a->items, b->items, len));
+    }
+
+    double out = 0.0;
+    for (size_t i = 0; i < len; i++) out += data_to_double(array_get_item(a, i)) * data_to_double(array_get_item(b, i));
+    RETURN_DOUBLE(out);
+}
+
+ScrData block_array_sum(ScrExec* exec, int argc, ScrData* argv) {
+    (void) exec;
+    if (argc < 1) RETURN_NOTHING;
+    if (argv[0].type != DATA_ARRAY) RETURN_NOTHING;
+
+    ScrDataArray* array = &argv[0].data.array_arg;
+    if (array->type == ARRAY_INT) RETURN_INT(array_int_sum(array->items, array->len));
+    RETURN_DOUBLE(array_double_sum(array->items, array->len));
+}
+
+ScrData block_array_min(ScrExec* exec, int argc, ScrData* argv) {
+    (void) exec;
+    if (argc < 1) RETURN_NOTHING;
+    if (argv[0].type != DATA_ARRAY || argv[0].data.array_arg.len == 0) RETURN_NOTHING;
+
+    ScrDataArray* array = &argv[0].data.array_arg;
+    if (array->type == ARRAY_INT) RETURN_INT(array_int_min(array->items, array->len));
+    RETURN_DOUBLE(array_double_min(array->items, array->len));
+}
+
+ScrData block_array_max(ScrExec* exec, int argc, ScrData* argv) {
+    (void) exec;
+    if (argc < 1) RETURN_NOTHING;
+    if (argv[0].type != DATA_ARRAY || argv[0].data.array_arg.len == 0) RETURN_NOTHING;
+
+    ScrDataArray* array = &argv[0].data.array_arg;
+    if (array->type == ARRAY_INT) RETURN_INT(array_int_max(array->items, array->len));
+    RETURN_DOUBLE(array_double_max(array->items, array->len));
+}
+
 ScrData block_print(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc >= 1) {
@@ -3442,6 +4274,27 @@ ScrData block_print(ScrExec* exec, int argc, ScrData* argv) {
             }
             bytes_sent += term_print_str("]");
             break;
+        case DATA_MAP:
+            bytes_sent += term_print_str("{");
+            for (size_t i = 0; i < argv[0].data.map_arg.cap; i++) {
+                ScrMapEntry* entry = &argv[0].data.map_arg.entries[i];
+                if (entry->key.type == DATA_NOTHING) continue;
+                bytes_sent += block_print(exec, 1, &entry->key).data.int_arg;
+                bytes_sent += term_print_str(": ");
+                bytes_sent += block_print(exec, 1, &entry->value).data.int_arg;
+                bytes_sent += term_print_str(", ");
+            }
+            bytes_sent += term_print_str("}");
+            break;
+        case DATA_ARRAY:
+            bytes_sent += term_print_str("[");
+            for (size_t i = 0; i < argv[0].data.array_arg.len; i++) {
+                ScrData item = array_get_item(&argv[0].data.array_arg, i);
+                bytes_sent += block_print(exec, 1, &item).data.int_arg;
+                bytes_sent += term_print_str(", ");
+            }
+            bytes_sent += term_print_str("]");
+            break;
         default:
             break;
         }
@@ -3460,9 +4313,9 @@ ScrData block_cursor_x(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     (void) argv;
     (void) argc;
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     int cur_x = out_win.cursor_pos % out_win.char_w;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     RETURN_INT(cur_x);
 }
 
@@ -3470,9 +4323,9 @@ ScrData block_cursor_y(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     (void) argv;
     (void) argc;
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     int cur_y = out_win.cursor_pos / out_win.char_w;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     RETURN_INT(cur_y);
 }
 
@@ -3480,9 +4333,9 @@ ScrData block_cursor_max_x(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     (void) argv;
     (void) argc;
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     int cur_max_x = out_win.char_w;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     RETURN_INT(cur_max_x);
 }
 
@@ -3490,20 +4343,20 @@ ScrData block_cursor_max_y(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     (void) argv;
     (void) argc;
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     int cur_max_y = out_win.char_h;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     RETURN_INT(cur_max_y);
 }
 
 ScrData block_set_cursor(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc < 2) RETURN_NOTHING;
-    pthread_mutex_lock(&out_win.lock);
+    term_lock();
     int x = CLAMP(data_to_int(argv[0]), 0, out_win.char_w - 1);
     int y = CLAMP(data_to_int(argv[1]), 0, out_win.char_h - 1);
     out_win.cursor_pos = x + y * out_win.char_w;
-    pthread_mutex_unlock(&out_win.lock);
+    term_unlock();
     RETURN_NOTHING;
 }
 
@@ -3567,12 +4420,19 @@ ScrData block_random(ScrExec* exec, int argc, ScrData* argv) {
 }
 
 ScrData block_join(ScrExec* exec, int argc, ScrData* argv) {
-    (void) exec;
     if (argc < 2) RETURN_NOTHING;
 
-    ScrString string = string_new(0);
-    string_add(&string, data_to_str(argv[0]));
-    string_add(&string, data_to_str(argv[1]));
+    // Nested joins hand us their own result on the left, which nobody else can
+    // see, so keep appending to it instead of copying it over again
+    if (argv[0].type == DATA_STR && argv[0].storage.type == DATA_STORAGE_MANAGED) {
+        ScrString string = string_take(&argv[0]);
+        string_add_data(&string, argv[1]);
+        return string_make_managed(&string);
+    }
+
+    ScrString string = string_new_temp(exec, data_str_len(argv[0]) + data_str_len(argv[1]));
+    string_add_data(&string, argv[0]);
+    string_add_data(&string, argv[1]);
     return string_make_managed(&string);
 }
 
@@ -3580,15 +4440,9 @@ ScrData block_length(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc < 1) RETURN_INT(0);
     if (argv[0].type == DATA_LIST) RETURN_INT(argv[0].data.list_arg.len);
-    int len = 0;
-    const char* str = data_to_str(argv[0]);
-    while (*str) {
-        int mb_size = leading_ones(*str);
-        if (mb_size == 0) mb_size = 1;
-        str += mb_size;
-        len++;
-    }
-    RETURN_INT(len);
+    if (argv[0].type == DATA_ARRAY) RETURN_INT(argv[0].data.array_arg.len);
+    if (argv[0].type == DATA_MAP) RETURN_INT(argv[0].data.map_arg.len);
+    RETURN_INT(data_str_char_len(argv[0]));
 }
 
 ScrData block_unix_time(ScrExec* exec, int argc, ScrData* argv) {
@@ -3611,10 +4465,12 @@ ScrData block_convert_float(ScrExec* exec, int argc, ScrData* argv) {
 }
 
 ScrData block_convert_str(ScrExec* exec, int argc, ScrData* argv) {
-    (void) exec;
-    ScrString string = string_new(0);
-    if (argc < 1) return string_make_managed(&string);
-    string_add(&string, data_to_str(argv[0]));
+    if (argc < 1) {
+        ScrString string = string_new_temp(exec, 0);
+        return string_make_managed(&string);
+    }
+    ScrString string = string_new_temp(exec, data_str_len(argv[0]));
+    string_add_data(&string, argv[0]);
     return string_make_managed(&string);
 }
 
@@ -3685,30 +4541,20 @@ ScrData block_pow(ScrExec* exec, int argc, ScrData* argv) {
 ScrData block_math(ScrExec* exec, int argc, ScrData* argv) {
     (void) exec;
     if (argc < 2) RETURN_DOUBLE(0.0);
-    if (argv[0].type != DATA_STR) RETURN_DOUBLE(0.0);
-
-    if (!strcmp(argv[0].data.str_arg, "sin")) {
-        RETURN_DOUBLE(sin(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "cos")) {
-        RETURN_DOUBLE(cos(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "tan")) {
-        RETURN_DOUBLE(tan(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "asin")) {
-        RETURN_DOUBLE(asin(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "acos")) {
-        RETURN_DOUBLE(acos(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "atan")) {
-        RETURN_DOUBLE(atan(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "sqrt")) {
-        RETURN_DOUBLE(sqrt(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "round")) {
-        RETURN_DOUBLE(round(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "floor")) {
-        RETURN_DOUBLE(floor(data_to_double(argv[1])));
-    } else if (!strcmp(argv[0].data.str_arg, "ceil")) {
-        RETURN_DOUBLE(ceil(data_to_double(argv[1])));
-    } else {
-        RETURN_DOUBLE(0.0);
+    if (argv[0].type != DATA_INT) RETURN_DOUBLE(0.0);
+
+    switch (argv[0].data.int_arg) {
+    case MATH_SIN: RETURN_DOUBLE(sin(data_to_double(argv[1])));
+    case MATH_COS: RETURN_DOUBLE(cos(data_to_double(argv[1])));
+    case MATH_TAN: RETURN_DOUBLE(tan(data_to_double(argv[1])));
+    case MATH_ASIN: RETURN_DOUBLE(asin(data_to_double(argv[1])));
+    case MATH_ACOS: RETURN_DOUBLE(acos(data_to_double(argv[1])));
+    case MATH_ATAN: RETURN_DOUBLE(atan(data_to_double(argv[1])));
+    case MATH_SQRT: RETURN_DOUBLE(sqrt(data_to_double(argv[1])));
+    case MATH_ROUND: RETURN_DOUBLE(round(data_to_double(argv[1])));
+    case MATH_FLOOR: RETURN_DOUBLE(floor(data_to_double(argv[1])));
+    case MATH_CEIL: RETURN_DOUBLE(ceil(data_to_double(argv[1])));
+    default: RETURN_DOUBLE(0.0);
     }
 }
 
@@ -3843,7 +4689,7 @@ ScrData block_eq(ScrExec* exec, int argc, ScrData* argv) {
     case DATA_DOUBLE:
         RETURN_BOOL(argv[0].data.double_arg == argv[1].data.double_arg);
     case DATA_STR:
-        RETURN_BOOL(!strcmp(argv[0].data.str_arg, argv[1].data.str_arg));
+        RETURN_BOOL(data_str_eq(argv[0], argv[1]));
     case DATA_NOTHING:
         RETURN_BOOL(1);
     default:
@@ -3868,8 +4714,7 @@ ScrData block_exec_custom(ScrExec* exec, int argc, ScrData* argv) {
 ScrData block_custom_arg(ScrExec* exec, int argc, ScrData* argv) {
     if (argc < 1) RETURN_NOTHING;
     if (argv[0].type != DATA_INT) RETURN_NOTHING;
-    if (argv[0].data.int_arg >= exec->chain_stack[exec->chain_stack_len - 1].custom_argc) RETURN_NOTHING;
-    return data_copy(exec->chain_stack[exec->chain_stack_len - 1].custom_argv[argv[0].data.int_arg]);
+    return exec_custom_arg(exec, argv[0].data.int_arg);
 }
 
 ScrData block_return(ScrExec* exec, int argc, ScrData* argv) {
@@ -3879,6 +4724,7 @@ ScrData block_return(ScrExec* exec, int argc, ScrData* argv) {
     RETURN_NOTHING;
 }
 
+#ifndef SCRAP_HEADLESS
 Texture2D load_svg(const char* path) {
     Image svg_img = LoadImageSvg(path, conf.font_size, conf.font_size);
     Texture2D texture = LoadTextureFromImage(svg_img);
@@ -3891,45 +4737,9 @@ const char* into_data_path(const char* path) {
     return TextFormat("%s%s%s", GetApplicationDirectory(), DATA_PATH, path);
 }
 
-void setup(void) {
-    run_tex = LoadTexture(into_data_path("run.png"));
-    SetTextureFilter(run_tex, TEXTURE_FILTER_BILINEAR);
-    drop_tex = LoadTexture(into_data_path("drop.png"));
-    SetTextureFilter(drop_tex, TEXTURE_FILTER_BILINEAR);
-    close_tex = LoadTexture(into_data_path("close.png"));
-    SetTextureFilter(close_tex, TEXTURE_FILTER_BILINEAR);
-
-    logo_img = LoadImageSvg(into_data_path("logo.svg"), conf.font_size, conf.font_size);
-    logo_tex = LoadTextureFromImage(logo_img);
-    SetTextureFilter(logo_tex, TEXTURE_FILTER_BILINEAR);
-
-    warn_tex = load_svg(into_data_path("warning.svg"));
-    stop_tex = load_svg(into_data_path("stop.svg"));
-    edit_tex = load_svg(into_data_path("edit.svg"));
-    close_tex = load_svg(into_data_path("close.svg"));
-    term_tex = load_svg(into_data_path("term.svg"));
-    add_arg_tex = load_svg(into_data_path("add_arg.svg"));
-    del_arg_tex = load_svg(into_data_path("del_arg.svg"));
-    add_text_tex = load_svg(into_data_path("add_text.svg"));
-    special_tex = load_svg(into_data_path("special.svg"));
-    list_tex = load_svg(into_data_path("list.svg"));
-    logo_tex_nuc = TextureToNuklear(logo_tex);
-    warn_tex_nuc = TextureToNuklear(warn_tex);
-
-    int codepoints_count;
-    int *codepoints = LoadCodepoints(conf.font_symbols, &codepoints_count);
-    font_cond = LoadFontEx(conf.font_path, conf.font_size, codepoints, codepoints_count);
-    font_eb = LoadFontEx(conf.font_bold_path, conf.font_size, codepoints, codepoints_count);
-    font_mono = LoadFontEx(conf.font_mono_path, conf.font_size, codepoints, codepoints_count);
-    UnloadCodepoints(codepoints);
-
-    SetTextureFilter(font_cond.texture, TEXTURE_FILTER_BILINEAR);
-    SetTextureFilter(font_eb.texture, TEXTURE_FILTER_BILINEAR);
-    SetTextureFilter(font_mono.texture, TEXTURE_FILTER_BILINEAR);
-
-    line_shader = LoadShaderFromMemory(line_shader_vertex, line_shader_fragment);
-    shader_time_loc = GetShaderLocation(line_shader, "time");
+#endif
 
+void register_blocks(void) {
     vm = vm_new();
 
     ScrBlockdef* on_start = blockdef_new("on_start", BLOCKTYPE_HAT, (ScrColor) { 0xff, 0x77, 0x00, 0xFF }, block_noop);
@@ -3995,19 +4805,45 @@ void setup(void) {
 
     ScrBlockdef* sc_loop = blockdef_new("loop", BLOCKTYPE_CONTROL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_loop);
     blockdef_add_text(sc_loop, "Loop");
+    blockdef_set_builtin(sc_loop, BUILTIN_LOOP);
     blockdef_register(&vm, sc_loop);
 
     ScrBlockdef* sc_repeat = blockdef_new("repeat", BLOCKTYPE_CONTROL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_repeat);
     blockdef_add_text(sc_repeat, "Repeat");
     blockdef_add_argument(sc_repeat, "10", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_repeat, "times");
+    blockdef_set_builtin(sc_repeat, BUILTIN_LOOP);
     blockdef_register(&vm, sc_repeat);
 
+    ScrBlockdef* sc_for = blockdef_new("for", BLOCKTYPE_CONTROL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_for);
+    blockdef_add_text(sc_for, "For");
+    blockdef_add_argument(sc_for, "i", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_for, "from");
+    blockdef_add_argument(sc_for, "1", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_for, "to");
+    blockdef_add_argument(sc_for, "10", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_for, "step");
+    blockdef_add_argument(sc_for, "1", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_for, BUILTIN_LOOP);
+    blockdef_register(&vm, sc_for);
+
     ScrBlockdef* sc_while = blockdef_new("while", BLOCKTYPE_CONTROL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_while);
     blockdef_add_text(sc_while, "While");
     blockdef_add_argument(sc_while, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_while, BUILTIN_LOOP);
     blockdef_register(&vm, sc_while);
 
+    // Jumps are handled by the vm, the block itself only runs outside of loops
+    ScrBlockdef* sc_break = blockdef_new("break", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_noop);
+    blockdef_add_text(sc_break, "Break");
+    blockdef_set_builtin(sc_break, BUILTIN_BREAK);
+    blockdef_register(&vm, sc_break);
+
+    ScrBlockdef* sc_continue = blockdef_new("continue", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_noop);
+    blockdef_add_text(sc_continue, "Continue");
+    blockdef_set_builtin(sc_continue, BUILTIN_CONTINUE);
+    blockdef_register(&vm, sc_continue);
+
     ScrBlockdef* sc_if = blockdef_new("if", BLOCKTYPE_CONTROL, (ScrColor) { 0xff, 0x99, 0x00, 0xff }, block_if);
     blockdef_add_text(sc_if, "If");
     blockdef_add_argument(sc_if, "", BLOCKCONSTR_UNLIMITED);
@@ -4042,18 +4878,21 @@ void setup(void) {
     blockdef_add_argument(sc_plus, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_plus, "+");
     blockdef_add_argument(sc_plus, "10", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_plus, BUILTIN_PLUS);
     blockdef_register(&vm, sc_plus);
 
     ScrBlockdef* sc_minus = blockdef_new("minus", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_minus);
     blockdef_add_argument(sc_minus, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_minus, "-");
     blockdef_add_argument(sc_minus, "10", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_minus, BUILTIN_MINUS);
     blockdef_register(&vm, sc_minus);
 
     ScrBlockdef* sc_mult = blockdef_new("mult", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_mult);
     blockdef_add_argument(sc_mult, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_mult, "*");
     blockdef_add_argument(sc_mult, "10", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_mult, BUILTIN_MULT);
     blockdef_register(&vm, sc_mult);
 
     ScrBlockdef* sc_div = blockdef_new("div", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_div);
@@ -4069,7 +4908,7 @@ void setup(void) {
     blockdef_register(&vm, sc_pow);
 
     ScrBlockdef* sc_math = blockdef_new("math", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xff }, block_math);
-    blockdef_add_dropdown(sc_math, DROPDOWN_SOURCE_LISTREF, math_list_access);
+    blockdef_add_dropdown(sc_math, DROPDOWN_SOURCE_LISTREF_INDEX, math_list_access);
     blockdef_add_argument(sc_math, "", BLOCKCONSTR_UNLIMITED);
     blockdef_register(&vm, sc_math);
 
@@ -4110,36 +4949,42 @@ void setup(void) {
     blockdef_add_argument(sc_less, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_less, "<");
     blockdef_add_argument(sc_less, "11", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_less, BUILTIN_LESS);
     blockdef_register(&vm, sc_less);
 
     ScrBlockdef* sc_less_eq = blockdef_new("less_eq", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_less_eq);
     blockdef_add_argument(sc_less_eq, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_less_eq, "<=");
     blockdef_add_argument(sc_less_eq, "11", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_less_eq, BUILTIN_LESS_EQ);
     blockdef_register(&vm, sc_less_eq);
 
     ScrBlockdef* sc_eq = blockdef_new("eq", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_eq);
     blockdef_add_argument(sc_eq, "", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_eq, "=");
     blockdef_add_argument(sc_eq, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_eq, BUILTIN_EQ);
     blockdef_register(&vm, sc_eq);
 
     ScrBlockdef* sc_not_eq = blockdef_new("not_eq", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_not_eq);
     blockdef_add_argument(sc_not_eq, "", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_not_eq, "!=");
     blockdef_add_argument(sc_not_eq, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_not_eq, BUILTIN_NOT_EQ);
     blockdef_register(&vm, sc_not_eq);
 
     ScrBlockdef* sc_more_eq = blockdef_new("more_eq", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_more_eq);
     blockdef_add_argument(sc_more_eq, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_more_eq, ">=");
     blockdef_add_argument(sc_more_eq, "11", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_more_eq, BUILTIN_MORE_EQ);
     blockdef_register(&vm, sc_more_eq);
 
     ScrBlockdef* sc_more = blockdef_new("more", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_more);
     blockdef_add_argument(sc_more, "9", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_more, ">");
     blockdef_add_argument(sc_more, "11", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_more, BUILTIN_MORE);
     blockdef_register(&vm, sc_more);
 
     ScrBlockdef* sc_not = blockdef_new("not", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_not);
@@ -4151,12 +4996,14 @@ void setup(void) {
     blockdef_add_argument(sc_and, "", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_and, "and");
     blockdef_add_argument(sc_and, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_short_circuit(sc_and, SHORT_CIRCUIT_ON_FALSE);
     blockdef_register(&vm, sc_and);
 
     ScrBlockdef* sc_or = blockdef_new("or", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_or);
     blockdef_add_argument(sc_or, "", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_or, "or");
     blockdef_add_argument(sc_or, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_short_circuit(sc_or, SHORT_CIRCUIT_ON_TRUE);
     blockdef_register(&vm, sc_or);
 
     ScrBlockdef* sc_true = blockdef_new("true", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_true);
@@ -4178,6 +5025,7 @@ void setup(void) {
     blockdef_add_text(sc_join, "Join");
     blockdef_add_argument(sc_join, "абоба ", BLOCKCONSTR_UNLIMITED);
     blockdef_add_argument(sc_join, "мусор", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_join, BUILTIN_JOIN);
     blockdef_register(&vm, sc_join);
 
     ScrBlockdef* sc_length = blockdef_new("length", BLOCKTYPE_NORMAL, (ScrColor) { 0x00, 0xcc, 0x77, 0xFF }, block_length);
@@ -4228,6 +5076,7 @@ void setup(void) {
     ScrBlockdef* sc_get_var = blockdef_new("get_var", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x77, 0x00, 0xff }, block_get_var);
     blockdef_add_text(sc_get_var, "Get");
     blockdef_add_argument(sc_get_var, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_get_var, BUILTIN_GET_VAR);
     blockdef_register(&vm, sc_get_var);
 
     ScrBlockdef* sc_set_var = blockdef_new("set_var", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x77, 0x00, 0xff }, block_set_var);
@@ -4235,6 +5084,7 @@ void setup(void) {
     blockdef_add_argument(sc_set_var, "my variable", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_set_var, "=");
     blockdef_add_argument(sc_set_var, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_set_var, BUILTIN_SET_VAR);
     blockdef_register(&vm, sc_set_var);
 
     ScrBlockdef* sc_create_list = blockdef_new("create_list", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_create_list);
@@ -4255,6 +5105,7 @@ void setup(void) {
     blockdef_add_argument(sc_list_get, "my variable", BLOCKCONSTR_UNLIMITED);
     blockdef_add_text(sc_list_get, "get at");
     blockdef_add_argument(sc_list_get, "0", BLOCKCONSTR_UNLIMITED);
+    blockdef_set_builtin(sc_list_get, BUILTIN_LIST_GET);
     blockdef_register(&vm, sc_list_get);
 
     ScrBlockdef* sc_list_set = blockdef_new("list_set", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_set);
@@ -4266,6 +5117,158 @@ void setup(void) {
     blockdef_add_argument(sc_list_set, "", BLOCKCONSTR_UNLIMITED);
     blockdef_register(&vm, sc_list_set);
 
+    ScrBlockdef* sc_list_insert = blockdef_new("list_insert", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_insert);
+    blockdef_add_image(sc_list_insert, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_list_insert, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_insert, "insert at");
+    blockdef_add_argument(sc_list_insert, "0", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_insert, "value");
+    blockdef_add_argument(sc_list_insert, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_list_insert);
+
+    ScrBlockdef* sc_list_remove = blockdef_new("list_remove", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_remove);
+    blockdef_add_image(sc_list_remove, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_list_remove, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_remove, "remove at");
+    blockdef_add_argument(sc_list_remove, "0", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_list_remove);
+
+    ScrBlockdef* sc_list_sort = blockdef_new("list_sort", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_sort);
+    blockdef_add_image(sc_list_sort, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_list_sort, "Sort");
+    blockdef_add_argument(sc_list_sort, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_sort, "as");
+    blockdef_add_dropdown(sc_list_sort, DROPDOWN_SOURCE_LISTREF_INDEX, list_sort_list_access);
+    blockdef_register(&vm, sc_list_sort);
+
+    ScrBlockdef* sc_list_reverse = blockdef_new("list_reverse", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_reverse);
+    blockdef_add_image(sc_list_reverse, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_list_reverse, "Reverse");
+    blockdef_add_argument(sc_list_reverse, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_list_reverse);
+
+    ScrBlockdef* sc_list_index_of = blockdef_new("list_index_of", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_index_of);
+    blockdef_add_image(sc_list_index_of, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_list_index_of, "Index of");
+    blockdef_add_argument(sc_list_index_of, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_index_of, "in");
+    blockdef_add_argument(sc_list_index_of, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_list_index_of);
+
+    ScrBlockdef* sc_list_slice = blockdef_new("list_slice", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_slice);
+    blockdef_add_image(sc_list_slice, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_list_slice, "Slice");
+    blockdef_add_argument(sc_list_slice, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_slice, "from");
+    blockdef_add_argument(sc_list_slice, "0", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_slice, "to");
+    blockdef_add_argument(sc_list_slice, "1", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_list_slice);
+
+    ScrBlockdef* sc_list_concat = blockdef_new("list_concat", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_list_concat);
+    blockdef_add_image(sc_list_concat, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_list_concat, "Concat");
+    blockdef_add_argument(sc_list_concat, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_list_concat, "and");
+    blockdef_add_argument(sc_list_concat, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_list_concat);
+
+    ScrBlockdef* sc_create_map = blockdef_new("create_map", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_create_map);
+    blockdef_add_image(sc_create_map, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_create_map, "Empty map");
+    blockdef_register(&vm, sc_create_map);
+
+    ScrBlockdef* sc_map_put = blockdef_new("map_put", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_map_put);
+    blockdef_add_image(sc_map_put, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_map_put, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_map_put, "put");
+    blockdef_add_argument(sc_map_put, "key", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_map_put, "=");
+    blockdef_add_argument(sc_map_put, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_map_put);
+
+    ScrBlockdef* sc_map_get = blockdef_new("map_get", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_map_get);
+    blockdef_add_image(sc_map_get, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_map_get, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_map_get, "get");
+    blockdef_add_argument(sc_map_get, "key", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_map_get);
+
+    ScrBlockdef* sc_map_has = blockdef_new("map_has", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_map_has);
+    blockdef_add_image(sc_map_has, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_map_has, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_map_has, "has");
+    blockdef_add_argument(sc_map_has, "key", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_map_has);
+
+    ScrBlockdef* sc_map_remove = blockdef_new("map_remove", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_map_remove);
+    blockdef_add_image(sc_map_remove, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_map_remove, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_map_remove, "remove");
+    blockdef_add_argument(sc_map_remove, "key", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_map_remove);
+
+    ScrBlockdef* sc_map_keys = blockdef_new("map_keys", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_map_keys);
+    blockdef_add_image(sc_map_keys, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_map_keys, "Keys of");
+    blockdef_add_argument(sc_map_keys, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_map_keys);
+
+    ScrBlockdef* sc_create_array = blockdef_new("create_array", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_create_array);
+    blockdef_add_image(sc_create_array, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_create_array, "New");
+    blockdef_add_dropdown(sc_create_array, DROPDOWN_SOURCE_LISTREF_INDEX, array_type_list_access);
+    blockdef_add_text(sc_create_array, "array of size");
+    blockdef_add_argument(sc_create_array, "10", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_create_array);
+
+    ScrBlockdef* sc_array_fill = blockdef_new("array_fill", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_fill);
+    blockdef_add_image(sc_array_fill, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_array_fill, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_array_fill, "fill with");
+    blockdef_add_argument(sc_array_fill, "0", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_fill);
+
+    ScrBlockdef* sc_array_add = blockdef_new("array_add", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_add);
+    blockdef_add_image(sc_array_add, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_array_add, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_array_add, "+=");
+    blockdef_add_argument(sc_array_add, "1", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_add);
+
+    ScrBlockdef* sc_array_mul = blockdef_new("array_mul", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_mul);
+    blockdef_add_image(sc_array_mul, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_argument(sc_array_mul, "my variable", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_array_mul, "*=");
+    blockdef_add_argument(sc_array_mul, "2", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_mul);
+
+    ScrBlockdef* sc_array_dot = blockdef_new("array_dot", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_dot);
+    blockdef_add_image(sc_array_dot, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_array_dot, "Dot product of");
+    blockdef_add_argument(sc_array_dot, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_add_text(sc_array_dot, "and");
+    blockdef_add_argument(sc_array_dot, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_dot);
+
+    ScrBlockdef* sc_array_sum = blockdef_new("array_sum", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_sum);
+    blockdef_add_image(sc_array_sum, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_array_sum, "Sum of");
+    blockdef_add_argument(sc_array_sum, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_sum);
+
+    ScrBlockdef* sc_array_min = blockdef_new("array_min", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_min);
+    blockdef_add_image(sc_array_min, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_array_min, "Min of");
+    blockdef_add_argument(sc_array_min, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_min);
+
+    ScrBlockdef* sc_array_max = blockdef_new("array_max", BLOCKTYPE_NORMAL, (ScrColor) { 0xff, 0x44, 0x00, 0xff }, block_array_max);
+    blockdef_add_image(sc_array_max, (ScrImage) { .image_ptr = &list_tex });
+    blockdef_add_text(sc_array_max, "Max of");
+    blockdef_add_argument(sc_array_max, "", BLOCKCONSTR_UNLIMITED);
+    blockdef_register(&vm, sc_array_max);
+
     ScrBlockdef* sc_define_block = blockdef_new("define_block", BLOCKTYPE_HAT, (ScrColor) { 0x99, 0x00, 0xff, 0xff }, block_noop);
     blockdef_add_image(sc_define_block, (ScrImage) { .image_ptr = &special_tex });
     blockdef_add_text(sc_define_block, "Define");
@@ -4277,6 +5280,49 @@ void setup(void) {
     blockdef_add_text(sc_return, "Return");
     blockdef_add_argument(sc_return, "", BLOCKCONSTR_UNLIMITED);
     blockdef_register(&vm, sc_return);
+}
+
+#ifndef SCRAP_HEADLESS
+void setup(void) {
+    run_tex = LoadTexture(into_data_path("run.png"));
+    SetTextureFilter(run_tex, TEXTURE_FILTER_BILINEAR);
+    drop_tex = LoadTexture(into_data_path("drop.png"));
+    SetTextureFilter(drop_tex, TEXTURE_FILTER_BILINEAR);
+    close_tex = LoadTexture(into_data_path("close.png"));
+    SetTextureFilter(close_tex, TEXTURE_FILTER_BILINEAR);
+
+    logo_img = LoadImageSvg(into_data_path("logo.svg"), conf.font_size, conf.font_size);
+    logo_tex = LoadTextureFromImage(logo_img);
+    SetTextureFilter(logo_tex, TEXTURE_FILTER_BILINEAR);
+
+    warn_tex = load_svg(into_data_path("warning.svg"));
+    stop_tex = load_svg(into_data_path("stop.svg"));
+    edit_tex = load_svg(into_data_path("edit.svg"));
+    close_tex = load_svg(into_data_path("close.svg"));
+    term_tex = load_svg(into_data_path("term.svg"));
+    add_arg_tex = load_svg(into_data_path("add_arg.svg"));
+    del_arg_tex = load_svg(into_data_path("del_arg.svg"));
+    add_text_tex = load_svg(into_data_path("add_text.svg"));
+    special_tex = load_svg(into_data_path("special.svg"));
+    list_tex = load_svg(into_data_path("list.svg"));
+    logo_tex_nuc = TextureToNuklear(logo_tex);
+    warn_tex_nuc = TextureToNuklear(warn_tex);
+
+    int codepoints_count;
+    int *codepoints = LoadCodepoints(conf.font_symbols, &codepoints_count);
+    font_cond = LoadFontEx(conf.font_path, conf.font_size, codepoints, codepoints_count);
+    font_eb = LoadFontEx(conf.font_bold_path, conf.font_size, codepoints, codepoints_count);
+    font_mono = LoadFontEx(conf.font_mono_path, conf.font_size, codepoints, codepoints_count);
+    UnloadCodepoints(codepoints);
+
+    SetTextureFilter(font_cond.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureFilter(font_eb.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureFilter(font_mono.texture, TEXTURE_FILTER_BILINEAR);
+
+    line_shader = LoadShaderFromMemory(line_shader_vertex, line_shader_fragment);
+    shader_time_loc = GetShaderLocation(line_shader, "time");
+
+    register_blocks();
 
     mouse_blockchain = blockchain_new();
     draw_stack = vector_create();
@@ -4405,6 +5451,9 @@ void setup(void) {
 }
 
 void Update() {
+    // Trace is exported after this frame ends, so its own span is closed in it
+    bool export_trace = false;
+    trace_begin("frame");
     hover_info.sidebar = GetMouseX() < conf.side_bar_size && GetMouseY() > conf.font_size * 2.2;
     hover_info.block = NULL;
     hover_info.argument = NULL;
@@ -4499,6 +5548,10 @@ void Update() {
         } else {
             actionbar_show("Vm shitted and died :(");
         }
+        sampler_stop(&exec_sampler);
+        if (exec_sampler.sample_count > 0) sampled_profile = sampler_folded(&exec_sampler);
+        sampler_free(&exec_sampler);
+        export_trace = trace_enabled;
         exec_free(&exec);
     } else if (vm.is_running) {
         hover_info.exec_chain = exec.running_chain;
@@ -4606,9 +5659,17 @@ void Update() {
     draw_tooltip();
 
     EndDrawing();
+    trace_end("frame");
+
+    // Chains are named now, before the code can be edited in the next frame
+    if (export_trace) {
+        trace_stop();
+        recorded_trace = trace_json();
+    }
 }
 
 int main(void) {
+    trace_thread_name("render");
     set_default_config(&conf);
     load_config(&conf);
 
@@ -4620,7 +5681,11 @@ int main(void) {
     setup();
     SetWindowIcon(logo_img);
 
+#ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(Update, 0, 1);
+#else
+    while (!WindowShouldClose()) Update();
+#endif
 
     if (vm.is_running) {
         exec_stop(&vm, &exec);
@@ -4647,3 +5712,4 @@ int main(void) {
 
     return 0;
 }
+#endif // SCRAP_HEADLESS
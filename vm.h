@@ -17,6 +17,7 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <pthread.h>
 #include <stdbool.h>
@@ -26,8 +27,37 @@
 #define VM_CONTROL_STACK_SIZE 32768
 #define VM_VARIABLE_STACK_SIZE 1024
 #define VM_CHAIN_STACK_SIZE 1024
+#define VM_ARENA_SIZE 65536
+#define VM_SAMPLE_INTERVAL_US 1000
+#define VM_TRACE_BUFFER_SIZE 65536
+#define VM_TRACE_MAX_THREADS 16
+// Number of blocks interpreted in a chain before it gets compiled to native code
+#ifndef VM_JIT_THRESHOLD
+#define VM_JIT_THRESHOLD 1000
+#endif
+
+// Hot chains are compiled to machine code on x86-64 linux and to wasm modules
+// on the web, everything else stays interpreted.
+// Compiled chains skip the block counter, so SCRVM_COUNT_BLOCKS keeps everything interpreted
+#if !defined(SCRVM_NO_JIT) && !defined(SCRVM_COUNT_BLOCKS)
+#if defined(__x86_64__) && defined(__linux__)
+#define SCRVM_JIT
+#define SCRVM_JIT_X86_64
+#elif defined(__EMSCRIPTEN__)
+#define SCRVM_JIT
+#define SCRVM_JIT_WASM
+#endif
+#endif
+
+// Wasm module emitter does not depend on the platform. Define SCRVM_WASM_EMITTER
+// to build it elsewhere, e.g. to check its output with a standalone wasm runtime
+#ifdef SCRVM_JIT_WASM
+#define SCRVM_WASM_EMITTER
+#endif
 
 typedef struct ScrString ScrString;
+typedef struct ScrStringHeader ScrStringHeader;
+typedef struct ScrInternTable ScrInternTable;
 typedef struct ScrVec ScrVec;
 typedef struct ScrColor ScrColor;
 typedef struct ScrImage ScrImage;
@@ -50,21 +80,40 @@ typedef union ScrInputData ScrInputData;
 typedef struct ScrInput ScrInput;
 
 typedef enum ScrBlockdefType ScrBlockdefType;
+typedef enum ScrShortCircuit ScrShortCircuit;
+typedef enum ScrBuiltin ScrBuiltin;
 typedef struct ScrBlockdef ScrBlockdef;
 
 typedef enum ScrDataControlArgType ScrDataControlArgType;
 typedef enum ScrDataType ScrDataType;
 typedef enum ScrDataStorageType ScrDataStorageType;
 typedef struct ScrDataList ScrDataList;
+typedef struct ScrListBuffer ScrListBuffer;
+typedef struct ScrMapEntry ScrMapEntry;
+typedef struct ScrDataMap ScrDataMap;
+typedef enum ScrArrayType ScrArrayType;
+typedef struct ScrDataArray ScrDataArray;
 typedef union ScrDataContents ScrDataContents;
 typedef struct ScrDataStorage ScrDataStorage;
 typedef struct ScrData ScrData;
 
 typedef struct ScrBlockChain ScrBlockChain;
+typedef struct ScrLoopJump ScrLoopJump;
+typedef struct ScrPostfixOp ScrPostfixOp;
+typedef enum ScrPostfixOpType ScrPostfixOpType;
+typedef enum ScrPostfixResult ScrPostfixResult;
+typedef struct ScrJitCode ScrJitCode;
 typedef struct ScrVariable ScrVariable;
 typedef struct ScrExec ScrExec;
 typedef struct ScrVm ScrVm;
 typedef struct ScrChainStackData ScrChainStackData;
+typedef struct ScrBlockProfile ScrBlockProfile;
+typedef struct ScrProfile ScrProfile;
+typedef struct ScrSampleFrame ScrSampleFrame;
+typedef struct ScrSampleStack ScrSampleStack;
+typedef struct ScrSampler ScrSampler;
+typedef struct ScrTraceEvent ScrTraceEvent;
+typedef struct ScrTraceBuffer ScrTraceBuffer;
 
 typedef char** (*ScrListAccessor)(ScrBlock* block, size_t* list_len);
 typedef ScrData (*ScrBlockFunc)(ScrExec* exec, int argc, ScrData* argv);
@@ -73,6 +122,28 @@ struct ScrString {
     char* str;
     size_t len;
     size_t cap;
+    size_t char_len;
+    bool in_arena;
+};
+
+// Every string that is not DATA_STORAGE_STATIC is prefixed with this header
+struct ScrStringHeader {
+    size_t size; // Size is in bytes and does not include null terminator
+    size_t capacity;
+    size_t char_len; // Length in UTF-8 characters
+    unsigned int hash; // Computed on first use, 0 means the hash is not computed yet
+    bool in_arena; // Allocated from exec arena, freeing is a no-op
+    char str[];
+};
+
+// Every string passed to intern_str() is stored here exactly once, so interned
+// strings can be compared by pointer. Strings live until the program exits
+struct ScrInternTable {
+    const char** items; // Open addressing, NULL marks an empty slot
+    unsigned int* hashes;
+    size_t len;
+    size_t cap;
+    pthread_mutex_t lock;
 };
 
 struct ScrVec {
@@ -121,7 +192,8 @@ struct ScrInputArgument {
 };
 
 enum ScrInputDropdownSource {
-    DROPDOWN_SOURCE_LISTREF,
+    DROPDOWN_SOURCE_LISTREF, // Block receives selected string
+    DROPDOWN_SOURCE_LISTREF_INDEX, // Block receives index of selected string in the list as DATA_INT, or -1 if it's not there
 };
 
 struct ScrInputDropdown {
@@ -157,6 +229,38 @@ enum ScrBlockdefType {
     BLOCKTYPE_HAT,
 };
 
+// Lets the block skip evaluating its remaining arguments (and itself) once
+// the first argument has decided the result, like && and || in C
+enum ScrShortCircuit {
+    SHORT_CIRCUIT_NONE,
+    SHORT_CIRCUIT_ON_FALSE,
+    SHORT_CIRCUIT_ON_TRUE,
+};
+
+// Tells the compiler what a block does, so that it can fuse the block with
+// its arguments. Block function must still behave the same, as fused ops
+// fall back to it when their fast path does not apply.
+// BUILTIN_LOOP marks control blocks that break and continue can jump out of
+enum ScrBuiltin {
+    BUILTIN_NONE,
+    BUILTIN_GET_VAR,
+    BUILTIN_SET_VAR,
+    BUILTIN_PLUS,
+    BUILTIN_MINUS,
+    BUILTIN_MULT,
+    BUILTIN_JOIN,
+    BUILTIN_LIST_GET,
+    BUILTIN_LESS,
+    BUILTIN_LESS_EQ,
+    BUILTIN_MORE,
+    BUILTIN_MORE_EQ,
+    BUILTIN_EQ,
+    BUILTIN_NOT_EQ,
+    BUILTIN_LOOP,
+    BUILTIN_BREAK,
+    BUILTIN_CONTINUE,
+};
+
 struct ScrBlockdef {
     const char* id;
     int ref_count;
@@ -164,6 +268,8 @@ struct ScrBlockdef {
     int arg_id;
     ScrColor color;
     ScrBlockdefType type;
+    ScrShortCircuit short_circuit;
+    ScrBuiltin builtin;
     // TODO: Maybe remove hidden from here
     bool hidden;
     ScrMeasurement ms;
@@ -191,21 +297,36 @@ enum ScrArgumentType {
     ARGUMENT_BLOCKDEF,
 };
 
-struct ScrArgument {
-    ScrMeasurement ms;
-    int input_id;
-    ScrArgumentType type;
-    ScrArgumentData data;
-};
-
 enum ScrDataControlArgType {
     CONTROL_ARG_BEGIN,
     CONTROL_ARG_END,
 };
 
+// A list is a window into a refcounted buffer. Copies and slices share the
+// buffer and only get their own one when they are changed (see list_unshare)
 struct ScrDataList {
     ScrData* items;
     size_t len; // Length is NOT in bytes, if you want length in bytes, use data.storage.storage_len
+    ScrListBuffer* buffer;
+};
+
+enum ScrArrayType {
+    ARRAY_INT = 0,
+    ARRAY_DOUBLE,
+};
+
+// Packed array of numbers. Items are int or double depending on type
+struct ScrDataArray {
+    void* items;
+    size_t len;
+    ScrArrayType type;
+};
+
+// Open addressing hash table with linear probing. Slots with DATA_NOTHING key are empty
+struct ScrDataMap {
+    ScrMapEntry* entries;
+    size_t len;
+    size_t cap;
 };
 
 union ScrDataContents {
@@ -213,6 +334,8 @@ union ScrDataContents {
     double double_arg;
     const char* str_arg;
     ScrDataList list_arg;
+    ScrDataArray array_arg;
+    ScrDataMap map_arg;
     ScrDataControlArgType control_arg;
     const void* custom_arg;
     ScrBlockChain* chain_arg;
@@ -241,6 +364,8 @@ enum ScrDataType {
     DATA_STR,
     DATA_BOOL,
     DATA_LIST,
+    DATA_ARRAY,
+    DATA_MAP,
     DATA_CONTROL,
     DATA_OMIT_ARGS, // Marker for vm used in C-blocks that do not require argument recomputation
     DATA_CHAIN,
@@ -252,11 +377,108 @@ struct ScrData {
     ScrDataContents data;
 };
 
+struct ScrListBuffer {
+    size_t refs;
+    size_t len;
+    ScrData items[];
+};
+
+struct ScrMapEntry {
+    ScrData key;
+    ScrData value;
+    unsigned int hash;
+};
+
+struct ScrArgument {
+    ScrMeasurement ms;
+    int input_id;
+    ScrArgumentType type;
+    ScrArgumentData data;
+    ScrData value; // What exec pushes for text and dropdown arguments, filled in by exec_start()
+};
+
+enum ScrPostfixOpType {
+    POSTFIX_PUSH,
+    POSTFIX_CALL,
+    POSTFIX_SKIP_IF_FALSE,
+    POSTFIX_SKIP_IF_TRUE,
+    // Superinstructions made by peephole pass
+    POSTFIX_GET_VAR,
+    POSTFIX_LIST_GET_VAR,
+    POSTFIX_COMPARE,
+    POSTFIX_ARITH,
+    POSTFIX_INC_VAR,
+    POSTFIX_APPEND_VAR,
+    POSTFIX_SET_VAR,
+    POSTFIX_END,
+};
+
+enum ScrPostfixResult {
+    POSTFIX_ERROR,
+    // Block arguments are on arg stack
+    POSTFIX_ARGS_READY,
+    // Block was run by a fused op, its result is on top of arg stack
+    POSTFIX_BLOCK_DONE,
+};
+
+// Runs the chain from block start and returns where exec_run_chain should
+// continue, which is past the end of the chain or (size_t)-1 on error.
+// Wasm has no stack memory of its own, so there the caller provides the ScrBlockFrame
+#ifdef SCRVM_JIT_WASM
+typedef size_t (*ScrJitFunc)(ScrExec* exec, size_t start, size_t arena_base, void* frame);
+#else
+typedef size_t (*ScrJitFunc)(ScrExec* exec, size_t start, size_t arena_base);
+#endif
+
+// Chain translated to C by scrap-aot. Runs the whole chain and returns false on error
+typedef bool (*ScrCompiledChain)(ScrExec* exec, size_t arena_base);
+
+// Native code of a chain. func is NULL until the chain gets hot or if it
+// could not be compiled
+struct ScrJitCode {
+    ScrJitFunc func;
+    size_t size;
+    unsigned int runs;
+};
+
+// Argument blocks flattened into postfix order. PUSH pushes a compiled
+// argument value, CALL runs a block on the top argc values of arg stack.
+// SKIP_IF_* replace the top value with a bool and jump skip ops forward
+// past the CALL of a short circuiting block
+struct ScrPostfixOp {
+    ScrPostfixOpType type;
+    int argc;
+    ScrBlock* block;
+    ScrData* value;
+    ScrData* index;
+    size_t skip;
+    // Plus or join block inside of the set var block that INC_VAR or APPEND_VAR stands for
+    ScrBlock* inner;
+    // Where ops that use variable value last found it, see exec_op_variable
+    size_t var_slot;
+    size_t var_version;
+};
+
+// Break and continue drop unwind control layers and resume at block index next.
+// unwind is -1 if the block is not inside of a loop
+struct ScrLoopJump {
+    size_t next;
+    int unwind;
+};
+
 struct ScrBlockChain {
     ScrVec pos;
     ScrBlock* blocks;
     int custom_argc;
     ScrData* custom_argv;
+    // Filled by exec_start. Arguments of blocks[i] start at postfix[postfix_start[i]]
+    ScrPostfixOp* postfix;
+    size_t* postfix_start;
+    // Index of the END or CONTROLEND block closing blocks[i], (size_t)-1 if
+    // blocks[i] does not open a layer or is never closed
+    size_t* block_ends;
+    ScrLoopJump* loop_jumps;
+    ScrJitCode jit;
 };
 
 struct ScrVariable {
@@ -264,20 +486,102 @@ struct ScrVariable {
     ScrData value;
     size_t chain_layer;
     int layer;
+    // Set blocks leave read only variables, such as for loop counters, as is
+    bool read_only;
 };
 
+// running_ind and chain are also read by the sampler thread
 struct ScrChainStackData {
     bool skip_block;
     int layer;
-    size_t running_ind;
+    atomic_size_t running_ind;
     int custom_argc;
     ScrData* custom_argv;
     bool is_returning;
     ScrData return_arg;
+    _Atomic(ScrBlockChain*) chain;
+};
+
+// Every control layer leaves a frame on top of the data its block pushed.
+// Remembering the stack lengths allows dropping a layer without running its end block
+typedef struct {
+    ScrData block_return;
+    size_t block_ind;
+    // Control and variable stack lengths before the block
+    size_t control_base;
+    size_t variable_base;
+} ScrBlockFrame;
+
+struct ScrBlockProfile {
+    ScrBlock* block;
+    size_t count;
+    uint64_t inclusive_ns; // Including evaluation of the arguments
+    uint64_t exclusive_ns; // Only the block itself, without the body of a called custom block
+};
+
+// Per block counters, looked up by block address. Every block is added by
+// profile_init() so the table never grows while the code runs
+struct ScrProfile {
+    ScrBlockProfile* entries;
+    size_t cap;
+    uint64_t max_exclusive_ns;
+    // Total time spent running chains of custom blocks. Blocks subtract how much
+    // it grew during their call, so a custom block call does not count its body
+    uint64_t nested_ns;
+    // When evaluation of the value at the same position in arg stack has started
+    uint64_t arg_start[VM_ARG_STACK_SIZE];
+};
+
+struct ScrSampleFrame {
+    ScrBlockChain* chain;
+    size_t running_ind;
+};
+
+// Unique call stack, its frames are stored in ScrSampler.frames
+struct ScrSampleStack {
+    size_t frames_start;
+    size_t depth;
+    size_t count;
+    unsigned int hash;
+};
+
+// Snapshots chain stack of exec from its own thread, so the code itself runs
+// without any instrumentation. Samples with the same stack are counted together
+struct ScrSampler {
+    ScrExec* exec;
+    int interval_us;
+    ScrSampleFrame* frames;
+    ScrSampleStack* stacks;
+    // Open addressing table of indices into stacks plus one, 0 means empty slot
+    size_t* table;
+    size_t table_cap;
+    size_t sample_count;
+    pthread_t thread;
+    atomic_bool is_running;
+};
+
+struct ScrTraceEvent {
+    uint64_t time_ns;
+    // Custom block calls store their chain instead, it is named when the trace is dumped
+    const char* name;
+    ScrBlockChain* chain;
+    char phase; // 'B' for begin and 'E' for end, as in chrome trace format
+};
+
+// Ring buffer of events recorded by one thread. Only the owning thread writes
+// to it, events before head - VM_TRACE_BUFFER_SIZE are overwritten
+struct ScrTraceBuffer {
+    ScrTraceEvent events[VM_TRACE_BUFFER_SIZE];
+    atomic_size_t head;
+    atomic_bool in_use;
+    const char* thread_name;
 };
 
 struct ScrExec {
     ScrBlockChain* code;
+    // Chains started by exec_start_compiled instead of code
+    ScrCompiledChain* compiled;
+    size_t compiled_len;
 
     ScrData arg_stack[VM_ARG_STACK_SIZE];
     size_t arg_stack_len;
@@ -287,13 +591,26 @@ struct ScrExec {
 
     ScrVariable variable_stack[VM_VARIABLE_STACK_SIZE];
     size_t variable_stack_len;
+    // Changes every time a variable is declared
+    size_t variable_stack_version;
 
     ScrChainStackData chain_stack[VM_CHAIN_STACK_SIZE];
-    size_t chain_stack_len;
+    atomic_size_t chain_stack_len;
+    // Odd while a chain is pushed or popped, so the sampler can tell it read a changing stack
+    atomic_size_t chain_stack_seq;
+
+    // Bump allocator for temporaries. Everything allocated here is dropped
+    // when the block in the chain that allocated it finishes
+    unsigned char arena[VM_ARENA_SIZE];
+    size_t arena_len;
 
     pthread_t thread;
     atomic_bool is_running;
     ScrBlockChain* running_chain;
+    // Only counted when SCRVM_COUNT_BLOCKS is defined
+    size_t block_count;
+    // NULL if profiling is disabled
+    ScrProfile* profile;
 };
 
 struct ScrVm {
@@ -371,15 +688,146 @@ bool exec_join(ScrVm* vm, ScrExec* exec, size_t* return_code);
 bool exec_try_join(ScrVm* vm, ScrExec* exec, size_t* return_code);
 void exec_set_skip_block(ScrExec* exec);
 
+// C code generated by scrap-aot runs its chains with these instead of
+// going through the blocks of a ScrBlockChain
+bool exec_start_compiled(ScrVm* vm, ScrExec* exec, ScrCompiledChain* chains, size_t len);
+bool exec_run_compiled(ScrExec* exec, ScrCompiledChain chain, int argc, ScrData* argv, ScrData* return_val);
+bool exec_call_compiled(ScrExec* exec, ScrCompiledChain chain, int argc);
+ScrData exec_custom_arg(ScrExec* exec, int ind);
+bool exec_call_block(ScrExec* exec, ScrBlock* block, int argc);
+bool exec_short_circuit(ScrExec* exec, bool on_true);
+bool exec_list_get_var(ScrExec* exec, ScrPostfixOp* op);
+bool exec_compare(ScrExec* exec, ScrPostfixOp* op);
+bool exec_arith(ScrExec* exec, ScrPostfixOp* op);
+ScrPostfixResult exec_inc_var(ScrExec* exec, ScrPostfixOp* op);
+ScrPostfixResult exec_append_var(ScrExec* exec, ScrPostfixOp* op);
+ScrPostfixResult exec_set_var(ScrExec* exec, ScrPostfixOp* op);
+void exec_unwind_layers(ScrExec* exec, int count);
+bool exec_pop_layer(ScrExec* exec, ScrBlockFrame* frame);
+bool exec_push_layer(ScrExec* exec, ScrBlockFrame* frame, size_t block_ind);
+
+void profile_init(ScrProfile* profile, ScrBlockChain* code);
+void profile_free(ScrProfile* profile);
+// Returns NULL if the block was not there when the profile was made
+ScrBlockProfile* profile_get(ScrProfile* profile, ScrBlock* block);
+
+bool sampler_start(ScrSampler* sampler, ScrExec* exec, int interval_us);
+void sampler_stop(ScrSampler* sampler);
+void sampler_free(ScrSampler* sampler);
+// Returns one "frame;frame;block count" line per sampled stack, which is the
+// folded format read by flamegraph tools. Result should be freed with free()
+char* sampler_folded(ScrSampler* sampler);
+
+extern atomic_bool trace_enabled;
+#define trace_begin(name) do { if (trace_enabled) trace_event((name), NULL, 'B'); } while (0)
+#define trace_end(name) do { if (trace_enabled) trace_event((name), NULL, 'E'); } while (0)
+
+void trace_start(void);
+void trace_stop(void);
+void trace_event(const char* name, ScrBlockChain* chain, char phase);
+// Names the calling thread in the trace
+void trace_thread_name(const char* name);
+// Lets another thread take over the buffer of the calling thread
+void trace_thread_exit(void);
+// Returns recorded events in chrome trace format, which chrome://tracing and
+// Perfetto can open. Result should be freed with free()
+char* trace_json(void);
+
+// Variable names must be interned, see data_to_atom()
 bool variable_stack_push_var(ScrExec* exec, const char* name, ScrData data);
 ScrVariable* variable_stack_get_variable(ScrExec* exec, const char* name);
 
+const char* intern_str(const char* str);
+// Returns NULL if the string was never interned
+const char* intern_find(const char* str);
+
 int data_to_int(ScrData arg);
+double data_to_double(ScrData arg);
 int data_to_bool(ScrData arg);
 const char* data_to_str(ScrData arg);
+size_t data_str_len(ScrData arg);
+size_t data_str_char_len(ScrData arg);
+unsigned int data_str_hash(ScrData arg);
+bool data_str_eq(ScrData left, ScrData right);
+// Static strings pushed by the vm are already interned, anything else is looked up
+const char* data_to_atom(ScrData arg);
+void data_free(ScrData data);
+ScrData data_copy(ScrData arg);
+bool data_in_arena(ScrData arg);
+
+// Defined here, so code generated by scrap-aot inlines these the same way as the interpreter
+static inline void arg_stack_push_arg(ScrExec* exec, ScrData arg) {
+    if (exec->arg_stack_len >= VM_ARG_STACK_SIZE) {
+        printf("[VM] CRITICAL: Arg stack overflow\n");
+        pthread_exit((void*)0);
+    }
+    exec->arg_stack[exec->arg_stack_len++] = arg;
+}
+
+static inline void arg_stack_undo_args(ScrExec* exec, size_t count) {
+    if (count > exec->arg_stack_len) {
+        printf("[VM] CRITICAL: Arg stack underflow\n");
+        pthread_exit((void*)0);
+    }
+    for (size_t i = 0; i < count; i++) {
+        ScrData arg = exec->arg_stack[exec->arg_stack_len - 1 - i];
+        if (arg.storage.type != DATA_STORAGE_MANAGED) continue;
+        data_free(arg);
+    }
+    exec->arg_stack_len -= count;
+}
+
+// Looks up variable named by op->value. Slot where it was found stays valid
+// until another variable is declared, as variables are only removed from the
+// top and none of the ones above the slot had the same name
+static inline ScrVariable* exec_op_variable(ScrExec* exec, ScrPostfixOp* op) {
+    if (op->var_version == exec->variable_stack_version && op->var_slot < exec->variable_stack_len) {
+        return &exec->variable_stack[op->var_slot];
+    }
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(*op->value));
+    if (!var) return NULL;
+    op->var_slot = var - exec->variable_stack;
+    op->var_version = exec->variable_stack_version;
+    return var;
+}
+
+static inline void exec_push_var(ScrExec* exec, ScrPostfixOp* op) {
+    ScrVariable* var = exec_op_variable(exec, op);
+    arg_stack_push_arg(exec, var ? var->value : (ScrData) {0});
+}
+
+// Returns zero filled array
+ScrData data_array_new(ScrArrayType type, size_t len);
+ScrData list_view(ScrData list, size_t offset, size_t len);
+void list_unshare(ScrDataList* list);
+void list_resize(ScrData* list, size_t len);
+ScrData data_map_new(void);
+bool map_key_valid(ScrData key);
+ScrData* map_get(ScrDataMap* map, ScrData key);
+void map_put(ScrData* map, ScrData key, ScrData value);
+bool map_remove(ScrDataMap* map, ScrData key);
+void array_int_fill(int* dst, size_t len, int value);
+void array_double_fill(double* dst, size_t len, double value);
+void array_int_add_scalar(int* dst, size_t len, int value);
+void array_double_add_scalar(double* dst, size_t len, double value);
+void array_int_mul_scalar(int* dst, size_t len, int value);
+void array_double_mul_scalar(double* dst, size_t len, double value);
+void array_int_add(int* dst, const int* src, size_t len);
+void array_double_add(double* dst, const double* src, size_t len);
+int array_int_dot(const int* a, const int* b, size_t len);
+double array_double_dot(const double* a, const double* b, size_t len);
+int array_int_sum(const int* src, size_t len);
+double array_double_sum(const double* src, size_t len);
+// Min and max expect len > 0
+int array_int_min(const int* src, size_t len);
+double array_double_min(const double* src, size_t len);
+int array_int_max(const int* src, size_t len);
+double array_double_max(const double* src, size_t len);
 
 ScrBlockdef* blockdef_new(const char* id, ScrBlockdefType type, ScrColor color, ScrBlockFunc func);
 size_t blockdef_register(ScrVm* vm, ScrBlockdef* blockdef);
+// Returns NULL if no registered blockdef has this id
+ScrBlockdef* blockdef_find(ScrVm* vm, const char* id);
 void blockdef_add_text(ScrBlockdef* blockdef, char* text);
 void blockdef_add_argument(ScrBlockdef* blockdef, char* defualt_data, ScrInputArgumentConstraint constraint);
 void blockdef_add_dropdown(ScrBlockdef* blockdef, ScrInputDropdownSource dropdown_source, ScrListAccessor accessor);
@@ -387,6 +835,8 @@ void blockdef_add_image(ScrBlockdef* blockdef, ScrImage image);
 void blockdef_add_blockdef_editor(ScrBlockdef* blockdef);
 void blockdef_delete_input(ScrBlockdef* blockdef, size_t input);
 void blockdef_set_id(ScrBlockdef* blockdef, const char* new_id);
+void blockdef_set_short_circuit(ScrBlockdef* blockdef, ScrShortCircuit short_circuit);
+void blockdef_set_builtin(ScrBlockdef* blockdef, ScrBuiltin builtin);
 void blockdef_unregister(ScrVm* vm, size_t id);
 
 ScrBlockChain blockchain_new(void);
@@ -709,17 +1159,66 @@ vector _vector_copy(vector vec, vec_type_t type_size)
 
 #include <assert.h>
 
+// Vector kernels used by typed arrays. They are written with vector extensions,
+// so one body compiles to SSE2, AVX or wasm simd128 depending on the target.
+// Native x86-64 builds are not compiled with -mavx, so the kernels are cloned
+// for newer instruction sets and the loader picks a clone for the running CPU
+#if defined(__GNUC__)
+#define SCRVM_SIMD_BYTES 32
+typedef int simd_int __attribute__((vector_size(SCRVM_SIMD_BYTES)));
+typedef unsigned int simd_uint __attribute__((vector_size(SCRVM_SIMD_BYTES)));
+typedef double simd_double __attribute__((vector_size(SCRVM_SIMD_BYTES)));
+typedef long long simd_mask __attribute__((vector_size(SCRVM_SIMD_BYTES)));
+#define SCRVM_SIMD_INT_LANES (SCRVM_SIMD_BYTES / (int)sizeof(int))
+#define SCRVM_SIMD_DOUBLE_LANES (SCRVM_SIMD_BYTES / (int)sizeof(double))
+#define simd_load(vec, ptr) memcpy(&(vec), (ptr), SCRVM_SIMD_BYTES)
+#define simd_store(ptr, vec) memcpy((ptr), &(vec), SCRVM_SIMD_BYTES)
+#define simd_splat(vec, val) for (int simd_lane = 0; simd_lane < (int)(sizeof(vec) / sizeof(vec[0])); simd_lane++) vec[simd_lane] = (val)
+#define simd_int_min(a, b) (((a) & ((a) < (b))) | ((b) & ~((a) < (b))))
+#define simd_int_max(a, b) (((a) & ((a) > (b))) | ((b) & ~((a) > (b))))
+#define simd_double_min(a, b) ((simd_double)(((simd_mask)(a) & (simd_mask)((a) < (b))) | ((simd_mask)(b) & ~(simd_mask)((a) < (b)))))
+#define simd_double_max(a, b) ((simd_double)(((simd_mask)(a) & (simd_mask)((a) > (b))) | ((simd_mask)(b) & ~(simd_mask)((a) > (b)))))
+#endif
+
+#if defined(SCRVM_SIMD_BYTES) && defined(__x86_64__) && defined(__linux__) && !defined(__AVX2__)
+#define SCRVM_SIMD_CLONES __attribute__((target_clones("avx2", "avx", "sse4.1", "default")))
+#else
+#define SCRVM_SIMD_CLONES
+#endif
+
 // Private functions
 void blockchain_update_parent_links(ScrBlockChain* chain);
-void arg_stack_push_arg(ScrExec* exec, ScrData data);
-void arg_stack_undo_args(ScrExec* exec, size_t count);
 void variable_stack_pop_layer(ScrExec* exec);
 void variable_stack_cleanup(ScrExec* exec);
-void data_free(ScrData data);
+void list_release(ScrDataList list);
+ScrMapEntry* map_entries_copy(ScrMapEntry* entries, size_t cap);
+ScrStringHeader* string_get_header(const char* str);
+unsigned int string_hash(const char* str, size_t size);
+ScrString string_new(size_t cap);
+void string_add_array(ScrString* string, const char* other, size_t other_len, size_t other_char_len);
+void string_add(ScrString* string, const char* other);
+void string_add_data(ScrString* string, ScrData data);
+ScrData string_make_managed(ScrString* string);
+ScrString string_take(ScrData* arg);
+void string_free(ScrString string);
+void block_compile_arguments(ScrBlock* block);
+void blockchain_compile(ScrBlockChain* chain);
 void blockdef_free(ScrBlockdef* blockdef);
 ScrBlockdef* blockdef_copy(ScrBlockdef* blockdef);
 void chain_stack_push(ScrExec* exec, ScrChainStackData data);
 void chain_stack_pop(ScrExec* exec);
+void jit_compile(ScrBlockChain* chain);
+void jit_free(ScrJitCode* jit);
+uint64_t profile_time_ns(void);
+void profile_add(ScrProfile* profile, ScrBlock* block, uint64_t inclusive_ns, uint64_t exclusive_ns);
+
+ScrInternTable intern_table = {
+    .items = NULL,
+    .hashes = NULL,
+    .len = 0,
+    .cap = 0,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
 
 ScrVm vm_new(void) {
     ScrVm vm = (ScrVm) {
@@ -742,8 +1241,10 @@ ScrExec exec_new(void) {
         .code = NULL,
         .arg_stack_len = 0,
         .control_stack_len = 0,
+        .arena_len = 0,
         .thread = (pthread_t) {0},
         .is_running = false,
+        .profile = NULL,
     };
     return exec;
 }
@@ -757,225 +1258,2038 @@ void exec_copy_code(ScrVm* vm, ScrExec* exec, ScrBlockChain* code) {
     exec->code = code;
 }
 
-bool exec_block(ScrExec* exec, ScrBlock block, ScrData* block_return, bool from_end, bool omit_args, ScrData control_arg) {
-    ScrBlockFunc execute_block = block.blockdef->func;
-    if (!execute_block) return false;
-
-    int stack_begin = exec->arg_stack_len;
-
-    if (block.blockdef->arg_id != -1) {
-        arg_stack_push_arg(exec, (ScrData) {
+// Values that go before block arguments: custom block info and control state
+size_t block_prologue(ScrBlockdef* blockdef, bool from_end, ScrData control_arg, ScrData* out) {
+    size_t len = 0;
+    if (blockdef->arg_id != -1) {
+        out[len++] = (ScrData) {
             .type = DATA_INT,
             .storage = DATA_STORAGE_STATIC,
             .data = (ScrDataContents) {
-                .int_arg = block.blockdef->arg_id,
+                .int_arg = blockdef->arg_id,
             },
-        });
+        };
     }
-    
-    if (block.blockdef->chain) {
-        arg_stack_push_arg(exec, (ScrData) {
+
+    if (blockdef->chain) {
+        out[len++] = (ScrData) {
             .type = DATA_CHAIN,
             .storage = DATA_STORAGE_STATIC,
             .data = (ScrDataContents) {
-                .chain_arg = block.blockdef->chain,
+                .chain_arg = blockdef->chain,
             },
-        });
+        };
     }
 
-    if (block.blockdef->type == BLOCKTYPE_CONTROL || block.blockdef->type == BLOCKTYPE_CONTROLEND) {
-        arg_stack_push_arg(exec, (ScrData) {
+    if (blockdef->type == BLOCKTYPE_CONTROL || blockdef->type == BLOCKTYPE_CONTROLEND) {
+        out[len++] = (ScrData) {
             .type = DATA_CONTROL,
             .storage = DATA_STORAGE_STATIC,
             .data = (ScrDataContents) {
                 .control_arg = from_end ? CONTROL_ARG_END : CONTROL_ARG_BEGIN,
             },
-        });
-        if (!from_end && block.blockdef->type == BLOCKTYPE_CONTROLEND) {
-            arg_stack_push_arg(exec, control_arg);
-        }
+        };
+        if (!from_end && blockdef->type == BLOCKTYPE_CONTROLEND) out[len++] = control_arg;
     }
-    if (!omit_args) {
-        for (vec_size_t i = 0; i < vector_size(block.arguments); i++) {
-            ScrArgument block_arg = block.arguments[i];
-            switch (block_arg.type) {
-            case ARGUMENT_TEXT:
-            case ARGUMENT_CONST_STRING:
-                arg_stack_push_arg(exec, (ScrData) {
-                    .type = DATA_STR,
-                    .storage = DATA_STORAGE_STATIC,
-                    .data = (ScrDataContents) {
-                        .str_arg = block_arg.data.text,
-                    },
-                });
-                break;
-            case ARGUMENT_BLOCK:
-                0;
-                ScrData arg_return;
-                if (!exec_block(exec, block_arg.data.block, &arg_return, false, false, (ScrData) {0})) return false;
-                arg_stack_push_arg(exec, arg_return);
-                break;
-            case ARGUMENT_BLOCKDEF:
-                break;
-            default:
-                return false;
-            }
+    return len;
+}
+
+// Calls block on the top argc values of arg stack and replaces them with its result
+bool exec_call_block(ScrExec* exec, ScrBlock* block, int argc) {
+    ScrBlockdef* blockdef = block->blockdef;
+    if (!blockdef->func) return false;
+
+    size_t stack_begin = exec->arg_stack_len - argc;
+    ScrData prologue[4];
+    size_t prologue_len = block_prologue(blockdef, false, (ScrData) {0}, prologue);
+    if (prologue_len) {
+        if (exec->arg_stack_len + prologue_len > VM_ARG_STACK_SIZE) {
+            printf("[VM] CRITICAL: Arg stack overflow\n");
+            pthread_exit((void*)0);
         }
+        memmove(&exec->arg_stack[stack_begin + prologue_len], &exec->arg_stack[stack_begin], argc * sizeof(ScrData));
+        memcpy(&exec->arg_stack[stack_begin], prologue, prologue_len * sizeof(ScrData));
+        exec->arg_stack_len += prologue_len;
     }
 
-    *block_return = execute_block(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    ScrData arg_return = blockdef->func(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
     arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
-
+    arg_stack_push_arg(exec, arg_return);
     return true;
 }
 
-#define BLOCKDEF chain->blocks[i].blockdef
-bool exec_run_custom(ScrExec* exec, ScrBlockChain* chain, int argc, ScrData* argv, ScrData* return_val) {
-    chain->custom_argc = argc;
-    chain->custom_argv = argv;
-    return exec_run_chain(exec, chain, return_val);
+ScrData exec_get_var_value(ScrExec* exec, ScrData* name) {
+    ScrVariable* var = variable_stack_get_variable(exec, data_to_atom(*name));
+    if (!var) return (ScrData) {0};
+    return var->value;
 }
 
-bool exec_run_chain(ScrExec* exec, ScrBlockChain* chain, ScrData* return_val) {
-    int skip_layer = -1;
-    size_t base_len = exec->control_stack_len;
-    chain_stack_push(exec, (ScrChainStackData) {
-        .skip_block = false,
-        .layer = 0,
-        .running_ind = 0,
-        .custom_argc = chain->custom_argc,
-        .custom_argv = chain->custom_argv,
-        .is_returning = false,
-        .return_arg = (ScrData) {0},
+bool compare_ints(ScrBuiltin builtin, int left, int right) {
+    switch (builtin) {
+    case BUILTIN_LESS: return left < right;
+    case BUILTIN_LESS_EQ: return left <= right;
+    case BUILTIN_MORE: return left > right;
+    case BUILTIN_MORE_EQ: return left >= right;
+    case BUILTIN_EQ: return left == right;
+    case BUILTIN_NOT_EQ: return left != right;
+    default: return false;
+    }
+}
+
+// Replaces the top value with a bool and returns true if the rest of
+// short circuiting block should be skipped
+bool exec_short_circuit(ScrExec* exec, bool on_true) {
+    bool cond = data_to_bool(exec->arg_stack[exec->arg_stack_len - 1]);
+    if (cond != on_true) return false;
+    arg_stack_undo_args(exec, 1);
+    arg_stack_push_arg(exec, (ScrData) {
+        .type = DATA_BOOL,
+        .storage = DATA_STORAGE_STATIC,
+        .data = (ScrDataContents) {
+            .int_arg = cond,
+        },
     });
-    exec->running_chain = chain;
-    ScrData block_return;
-    for (size_t i = 0; i < vector_size(chain->blocks); i++) {
-        pthread_testcancel();
-        size_t block_ind = i;
-        ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
-        chain_data->running_ind = i;
-        bool from_end = false;
-        bool omit_args = false;
-        bool return_used = false;
-        if (chain_data->is_returning) {
-            break;
-        }
+    return true;
+}
 
-        if (BLOCKDEF->type == BLOCKTYPE_END || BLOCKDEF->type == BLOCKTYPE_CONTROLEND) {
-            if (BLOCKDEF->type == BLOCKTYPE_CONTROLEND && chain_data->layer == 0) continue;
-            variable_stack_pop_layer(exec);
-            chain_data->layer--;
-            control_stack_pop_data(block_ind, size_t)
-            control_stack_pop_data(block_return, ScrData)
-            if (block_return.type == DATA_OMIT_ARGS) omit_args = true;
-            if (block_return.storage.type == DATA_STORAGE_MANAGED) data_free(block_return);
-            from_end = true;
-            if (chain_data->skip_block && skip_layer == chain_data->layer) {
-                chain_data->skip_block = false;
-                skip_layer = -1;
-            }
-        }
-        if (!chain_data->skip_block) {
-            if (!exec_block(exec, chain->blocks[block_ind], &block_return, from_end, omit_args, (ScrData){0})) {
-                chain_stack_pop(exec);
-                return false;
-            }
-            if (chain_data->running_ind != i) i = chain_data->running_ind;
-        }
-        if (BLOCKDEF->type == BLOCKTYPE_CONTROLEND && block_ind != i) {
-            from_end = false;
-            if (!exec_block(exec, chain->blocks[i], &block_return, from_end, false, block_return)) {
-                chain_stack_pop(exec);
-                return false;
-            }
-            if (chain_data->running_ind != i) i = chain_data->running_ind;
-            return_used = true;
+bool exec_list_get_var(ScrExec* exec, ScrPostfixOp* op) {
+    ScrData list = exec_get_var_value(exec, op->value);
+    ScrData index = exec_get_var_value(exec, op->index);
+    if (list.type == DATA_LIST && index.type == DATA_INT) {
+        if (index.data.int_arg < 0 || (size_t)index.data.int_arg >= list.data.list_arg.len) {
+            arg_stack_push_arg(exec, (ScrData) {0});
+        } else {
+            arg_stack_push_arg(exec, list.data.list_arg.items[index.data.int_arg]);
         }
-        if (BLOCKDEF->type == BLOCKTYPE_CONTROL || BLOCKDEF->type == BLOCKTYPE_CONTROLEND) {
-            control_stack_push_data(block_return, ScrData)
-            control_stack_push_data(i, size_t)
-            if (chain_data->skip_block && skip_layer == -1) skip_layer = chain_data->layer;
-            return_used = true;
-            chain_data->layer++;
-        } 
-        if (!return_used && block_return.storage.type == DATA_STORAGE_MANAGED) {
-            data_free(block_return);
-        }
-    }
-    *return_val = exec->chain_stack[exec->chain_stack_len - 1].return_arg;
-    while (exec->chain_stack[exec->chain_stack_len - 1].layer >= 0) {
-        variable_stack_pop_layer(exec);
-        exec->chain_stack[exec->chain_stack_len - 1].layer--;
+        return true;
     }
-    exec->control_stack_len = base_len;
-    chain_stack_pop(exec);
-    return true;
+    arg_stack_push_arg(exec, *op->value);
+    arg_stack_push_arg(exec, index);
+    return exec_call_block(exec, op->block, 2);
 }
-#undef BLOCKDEF
 
-void exec_thread_exit(void* thread_exec) {
-    ScrExec* exec = thread_exec;
-    variable_stack_cleanup(exec);
-    arg_stack_undo_args(exec, exec->arg_stack_len);
-    exec->is_running = false;
+bool exec_compare(ScrExec* exec, ScrPostfixOp* op) {
+    ScrData* argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        bool result = compare_ints(op->block->blockdef->builtin, argv[0].data.int_arg, argv[1].data.int_arg);
+        exec->arg_stack_len -= 2;
+        arg_stack_push_arg(exec, (ScrData) {
+            .type = DATA_BOOL,
+            .storage = DATA_STORAGE_STATIC,
+            .data = (ScrDataContents) {
+                .int_arg = result,
+            },
+        });
+        return true;
+    }
+    return exec_call_block(exec, op->block, 2);
 }
 
-void* exec_thread_entry(void* thread_exec) {
-    ScrExec* exec = thread_exec;
-    pthread_cleanup_push(exec_thread_exit, thread_exec);
-
-    exec->is_running = true;
-    exec->arg_stack_len = 0;
-    exec->control_stack_len = 0;
-    exec->chain_stack_len = 0;
-    exec->running_chain = NULL;
-
-    for (size_t i = 0; i < vector_size(exec->code); i++) {
-        ScrBlock* block = &exec->code[i].blocks[0];
-        if (block->blockdef->type != BLOCKTYPE_HAT) continue;
-        for (size_t j = 0; j < vector_size(block->arguments); j++) {
-            if (block->arguments[j].type != ARGUMENT_BLOCKDEF) continue;
-            block->arguments[j].data.blockdef->chain = &exec->code[i];
-        }
+// Plus, minus and mult of two ints or two doubles, same as their block functions
+bool exec_arith(ScrExec* exec, ScrPostfixOp* op) {
+    ScrData* argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    ScrBuiltin builtin = op->block->blockdef->builtin;
+    if (argv[0].type == DATA_INT && argv[1].type == DATA_INT) {
+        int left = argv[0].data.int_arg, right = argv[1].data.int_arg;
+        int result = builtin == BUILTIN_PLUS ? left + right : builtin == BUILTIN_MINUS ? left - right : left * right;
+        exec->arg_stack_len -= 2;
+        arg_stack_push_arg(exec, (ScrData) {
+            .type = DATA_INT,
+            .storage = DATA_STORAGE_STATIC,
+            .data = (ScrDataContents) {
+                .int_arg = result,
+            },
+        });
+        return true;
+    }
+    if (argv[0].type == DATA_DOUBLE && argv[1].type == DATA_DOUBLE) {
+        double left = argv[0].data.double_arg, right = argv[1].data.double_arg;
+        double result = builtin == BUILTIN_PLUS ? left + right : builtin == BUILTIN_MINUS ? left - right : left * right;
+        exec->arg_stack_len -= 2;
+        arg_stack_push_arg(exec, (ScrData) {
+            .type = DATA_DOUBLE,
+            .storage = DATA_STORAGE_STATIC,
+            .data = (ScrDataContents) {
+                .double_arg = result,
+            },
+        });
+        return true;
     }
+    return exec_call_block(exec, op->block, 2);
+}
 
-    for (size_t i = 0; i < vector_size(exec->code); i++) {
-        ScrBlock* block = &exec->code[i].blocks[0];
-        if (block->blockdef->type != BLOCKTYPE_HAT) continue;
-        bool cont = false;
-        for (size_t j = 0; j < vector_size(block->arguments); j++) {
-            if (block->arguments[j].type == ARGUMENT_BLOCKDEF) {
-                cont = true;
-                break;
-            }
-        }
-        if (cont) continue;
-        exec->code[i].custom_argc = -1;
-        exec->code[i].custom_argv = NULL;
-        ScrData bin;
-        if (!exec_run_chain(exec, &exec->code[i], &bin)) {
-            exec->running_chain = NULL;
-            pthread_exit((void*)0);
+// Step is on top of arg stack. Whole set var block ends here
+ScrPostfixResult exec_inc_var(ScrExec* exec, ScrPostfixOp* op) {
+    ScrVariable* var = exec_op_variable(exec, op);
+    ScrData step = exec->arg_stack[exec->arg_stack_len - 1];
+    if (var && !var->read_only && (var->value.type == DATA_INT || var->value.type == DATA_DOUBLE)) {
+        if (var->value.type == DATA_INT) {
+            var->value.data.int_arg += data_to_int(step);
+        } else {
+            var->value.data.double_arg += data_to_double(step);
         }
-        exec->running_chain = NULL;
+        arg_stack_undo_args(exec, 1);
+        arg_stack_push_arg(exec, var->value);
+        return POSTFIX_BLOCK_DONE;
     }
 
-    pthread_cleanup_pop(1);
-    pthread_exit((void*)1);
+    exec->arg_stack[exec->arg_stack_len - 1] = var ? var->value : (ScrData) {0};
+    arg_stack_push_arg(exec, step);
+    if (!exec_call_block(exec, op->inner, 2)) return POSTFIX_ERROR;
+    ScrData sum = exec->arg_stack[exec->arg_stack_len - 1];
+    exec->arg_stack[exec->arg_stack_len - 1] = *op->value;
+    arg_stack_push_arg(exec, sum);
+    if (!exec_call_block(exec, op->block, 2)) return POSTFIX_ERROR;
+    return POSTFIX_BLOCK_DONE;
 }
 
-bool exec_start(ScrVm* vm, ScrExec* exec) {
-    if (vm->is_running) return false;
-    if (exec->is_running) return false;
-    vm->is_running = true;
+// Variable name, its value and the joined value are on top of arg stack. The
+// variable owns its string, so it is appended to in place unless the joined
+// value is the same string or the variable was set while it was evaluated.
+// Whole set var block ends here
+ScrPostfixResult exec_append_var(ScrExec* exec, ScrPostfixOp* op) {
+    ScrVariable* var = exec_op_variable(exec, op);
+    ScrData* argv = &exec->arg_stack[exec->arg_stack_len - 2];
+    if (var &&
+        !var->read_only &&
+        var->value.type == DATA_STR &&
+        var->value.storage.type == DATA_STORAGE_UNMANAGED &&
+        argv[0].type == DATA_STR &&
+        argv[0].data.str_arg == var->value.data.str_arg &&
+        (argv[1].type != DATA_STR || argv[1].data.str_arg != var->value.data.str_arg))
+    {
+        ScrString string = string_take(&var->value);
+        string_add_data(&string, argv[1]);
+        var->value = string_make_managed(&string);
+        var->value.storage.type = DATA_STORAGE_UNMANAGED;
+        arg_stack_undo_args(exec, 3);
+        arg_stack_push_arg(exec, var->value);
+        return POSTFIX_BLOCK_DONE;
+    }
 
-    if (pthread_create(&exec->thread, NULL, exec_thread_entry, exec)) return false;
-    exec->is_running = true;
-    return true;
+    if (!exec_call_block(exec, op->inner, 2)) return POSTFIX_ERROR;
+    if (!exec_call_block(exec, op->block, 2)) return POSTFIX_ERROR;
+    return POSTFIX_BLOCK_DONE;
 }
 
-bool exec_stop(ScrVm* vm, ScrExec* exec) {
+// Variable name and the new value are on top of arg stack. Static values
+// replace static values as is, anything else goes through set var block.
+// Whole set var block ends here, with the value left as its result
+ScrPostfixResult exec_set_var(ScrExec* exec, ScrPostfixOp* op) {
+    ScrVariable* var = exec_op_variable(exec, op);
+    ScrData value = exec->arg_stack[exec->arg_stack_len - 1];
+    if (var && !var->read_only && var->value.storage.type == DATA_STORAGE_STATIC && value.storage.type == DATA_STORAGE_STATIC) {
+        var->value = value;
+        return POSTFIX_BLOCK_DONE;
+    }
+    if (!exec_call_block(exec, op->block, 2)) return POSTFIX_ERROR;
+    return POSTFIX_BLOCK_DONE;
+}
+
+// Fused ops count every block they stand for, so the number does not depend on fusion
+#ifdef SCRVM_COUNT_BLOCKS
+#define exec_count_blocks(exec, count) ((exec)->block_count += (count))
+#else
+#define exec_count_blocks(exec, count)
+#endif
+
+// The interpreter is instantiated twice, once with profiling hooks and once
+// without. profiling is a constant in both, so the hooks compile away when off
+#define SCRVM_ALWAYS_INLINE static inline __attribute__((always_inline))
+
+// Evaluates argument program up to POSTFIX_END without recursing into nested
+// blocks. Leaves one value per argument on the arg stack.
+// Profiling times every block it calls. Pushing a value takes no time, so the
+// clock is only read after calls
+SCRVM_ALWAYS_INLINE ScrPostfixResult exec_eval_postfix_impl(ScrExec* exec, ScrPostfixOp* op, bool profiling) {
+    ScrProfile* profile = exec->profile;
+    uint64_t now = profiling ? profile_time_ns() : 0;
+    for (;; op++) {
+        uint64_t start = now;
+        size_t pos = exec->arg_stack_len;
+        switch (op->type) {
+        case POSTFIX_PUSH:
+            if (profiling) profile->arg_start[pos] = now;
+            arg_stack_push_arg(exec, *op->value);
+            break;
+        case POSTFIX_CALL: {
+            exec_count_blocks(exec, 1);
+            uint64_t nested_start = 0;
+            if (profiling) {
+                // Evaluation of the block started with its first argument
+                pos -= op->argc;
+                if (op->argc == 0) profile->arg_start[pos] = now;
+                nested_start = profile->nested_ns;
+            }
+            if (!exec_call_block(exec, op->block, op->argc)) return POSTFIX_ERROR;
+            if (profiling) {
+                now = profile_time_ns();
+                profile_add(profile, op->block, now - profile->arg_start[pos], now - start - (profile->nested_ns - nested_start));
+            }
+            break;
+        }
+        case POSTFIX_SKIP_IF_FALSE:
+        case POSTFIX_SKIP_IF_TRUE:
+            if (exec_short_circuit(exec, op->type == POSTFIX_SKIP_IF_TRUE)) {
+                op += op->skip;
+                if (profiling) profile_add(profile, op->block, now - profile->arg_start[pos - 1], 0);
+            }
+            break;
+        case POSTFIX_GET_VAR:
+            exec_count_blocks(exec, 1);
+            if (profiling) profile->arg_start[pos] = now;
+            exec_push_var(exec, op);
+            break;
+        case POSTFIX_LIST_GET_VAR:
+            // List get and get var of the index
+            exec_count_blocks(exec, 2);
+            if (profiling) profile->arg_start[pos] = now;
+            if (!exec_list_get_var(exec, op)) return POSTFIX_ERROR;
+            if (profiling) {
+                now = profile_time_ns();
+                profile_add(profile, op->block, now - start, now - start);
+            }
+            break;
+        case POSTFIX_COMPARE:
+            exec_count_blocks(exec, 1);
+            if (!exec_compare(exec, op)) return POSTFIX_ERROR;
+            if (profiling) {
+                now = profile_time_ns();
+                profile_add(profile, op->block, now - profile->arg_start[pos - 2], now - start);
+            }
+            break;
+        case POSTFIX_ARITH:
+            exec_count_blocks(exec, 1);
+            if (!exec_arith(exec, op)) return POSTFIX_ERROR;
+            if (profiling) {
+                now = profile_time_ns();
+                profile_add(profile, op->block, now - profile->arg_start[pos - 2], now - start);
+            }
+            break;
+        case POSTFIX_INC_VAR: {
+            // Get var and plus blocks, set var itself is counted and timed by exec_block
+            exec_count_blocks(exec, 2);
+            ScrPostfixResult result = exec_inc_var(exec, op);
+            if (profiling && result != POSTFIX_ERROR) {
+                now = profile_time_ns();
+                profile_add(profile, op->inner, now - start, now - start);
+            }
+            return result;
+        }
+        case POSTFIX_APPEND_VAR: {
+            // Join block, set var itself is counted and timed by exec_block.
+            // Join evaluation started with the variable value
+            exec_count_blocks(exec, 1);
+            ScrPostfixResult result = exec_append_var(exec, op);
+            if (profiling && result != POSTFIX_ERROR) {
+                now = profile_time_ns();
+                profile_add(profile, op->inner, now - profile->arg_start[pos - 2], now - start);
+            }
+            return result;
+        }
+        case POSTFIX_SET_VAR:
+            // Set var is counted by exec_block. Profiling runs it as a plain set
+            // var block, so its time doesn't include arguments
+            if (profiling) return POSTFIX_ARGS_READY;
+            return exec_set_var(exec, op);
+        case POSTFIX_END:
+            return POSTFIX_ARGS_READY;
+        default:
+            return POSTFIX_ERROR;
+        }
+    }
+}
+
+ScrPostfixResult exec_eval_postfix(ScrExec* exec, ScrPostfixOp* op) {
+    return exec_eval_postfix_impl(exec, op, false);
+}
+
+// Profiling adds time of the block to the profile
+SCRVM_ALWAYS_INLINE bool exec_block_impl(ScrExec* exec, ScrBlock* block, ScrPostfixOp* args, ScrData* block_return, bool from_end, bool omit_args, ScrData control_arg, bool profiling) {
+    ScrBlockFunc execute_block = block->blockdef->func;
+    if (!execute_block) return false;
+    exec_count_blocks(exec, 1);
+    uint64_t start = profiling ? profile_time_ns() : 0;
+    uint64_t nested_start = profiling ? exec->profile->nested_ns : 0;
+
+    int stack_begin = exec->arg_stack_len;
+
+    ScrData prologue[4];
+    size_t prologue_len = block_prologue(block->blockdef, from_end, control_arg, prologue);
+    for (size_t i = 0; i < prologue_len; i++) arg_stack_push_arg(exec, prologue[i]);
+
+    if (!omit_args) {
+        ScrPostfixResult result = exec_eval_postfix_impl(exec, args, profiling);
+        if (result == POSTFIX_ERROR) return false;
+        if (result == POSTFIX_BLOCK_DONE) {
+            *block_return = exec->arg_stack[--exec->arg_stack_len];
+            arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+            if (profiling) {
+                uint64_t end = profile_time_ns();
+                profile_add(exec->profile, block, end - start, end - start - (exec->profile->nested_ns - nested_start));
+            }
+            return true;
+        }
+    }
+
+    uint64_t args_end = profiling ? profile_time_ns() : 0;
+    uint64_t nested_args_end = profiling ? exec->profile->nested_ns : 0;
+    *block_return = execute_block(exec, exec->arg_stack_len - stack_begin, exec->arg_stack + stack_begin);
+    arg_stack_undo_args(exec, exec->arg_stack_len - stack_begin);
+    if (profiling) {
+        uint64_t end = profile_time_ns();
+        profile_add(exec->profile, block, end - start, end - args_end - (exec->profile->nested_ns - nested_args_end));
+    }
+
+    return true;
+}
+
+bool exec_block(ScrExec* exec, ScrBlock block, ScrPostfixOp* args, ScrData* block_return, bool from_end, bool omit_args, ScrData control_arg) {
+    return exec_block_impl(exec, &block, args, block_return, from_end, omit_args, control_arg, false);
+}
+
+#define BLOCKDEF chain->blocks[i].blockdef
+bool exec_run_custom(ScrExec* exec, ScrBlockChain* chain, int argc, ScrData* argv, ScrData* return_val) {
+    chain->custom_argc = argc;
+    chain->custom_argv = argv;
+    if (!trace_enabled) return exec_run_chain(exec, chain, return_val);
+    trace_event(NULL, chain, 'B');
+    bool result = exec_run_chain(exec, chain, return_val);
+    trace_event(NULL, chain, 'E');
+    return result;
+}
+
+void exec_unwind_layers(ScrExec* exec, int count) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    for (int i = 0; i < count; i++) {
+        ScrBlockFrame frame;
+        control_stack_pop_data(frame, ScrBlockFrame)
+        if (frame.block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame.block_return);
+        exec->control_stack_len = frame.control_base;
+
+        while (exec->variable_stack_len > frame.variable_base) {
+            ScrData arg = exec->variable_stack[--exec->variable_stack_len].value;
+            if (arg.storage.type == DATA_STORAGE_UNMANAGED || arg.storage.type == DATA_STORAGE_MANAGED) {
+                data_free(arg);
+            }
+        }
+        chain_data->layer--;
+    }
+}
+
+// Closes the innermost layer and returns whether its block asked to omit arguments at the end
+bool exec_pop_layer(ScrExec* exec, ScrBlockFrame* frame) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    variable_stack_pop_layer(exec);
+    chain_data->layer--;
+    control_stack_pop_data(*frame, ScrBlockFrame)
+    bool omit_args = frame->block_return.type == DATA_OMIT_ARGS;
+    if (frame->block_return.storage.type == DATA_STORAGE_MANAGED) data_free(frame->block_return);
+    // Skipping always jumps straight to the end block, so this is the layer that was skipped
+    chain_data->skip_block = false;
+    return omit_args;
+}
+
+// Opens a layer of control block at block_ind and returns whether it asked to skip its body
+bool exec_push_layer(ScrExec* exec, ScrBlockFrame* frame, size_t block_ind) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    if (data_in_arena(frame->block_return)) frame->block_return = data_copy(frame->block_return);
+    frame->block_ind = block_ind;
+    control_stack_push_data(*frame, ScrBlockFrame)
+    chain_data->layer++;
+    return chain_data->skip_block;
+}
+
+// Opens a layer if blocks[i] is a control block and returns index of the next block
+size_t exec_block_layer(ScrExec* exec, ScrBlockChain* chain, size_t i, ScrBlockFrame* frame, bool return_used) {
+    if (BLOCKDEF->type == BLOCKTYPE_CONTROL || BLOCKDEF->type == BLOCKTYPE_CONTROLEND) {
+        // Nothing in between runs, so go straight to the end block
+        if (exec_push_layer(exec, frame, i)) return chain->block_ends[i] == (size_t)-1 ? vector_size(chain->blocks) : chain->block_ends[i];
+        return i + 1;
+    }
+    if (!return_used && frame->block_return.storage.type == DATA_STORAGE_MANAGED) {
+        data_free(frame->block_return);
+    }
+    return i + 1;
+}
+
+// Finishes a block after frame->block_ind was run and returns index of the next block.
+// i is the running index after the block, control blocks change it to loop
+SCRVM_ALWAYS_INLINE size_t exec_block_done_impl(ScrExec* exec, ScrBlockChain* chain, size_t i, ScrBlockFrame* frame, bool profiling) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    bool return_used = false;
+    if (BLOCKDEF->type == BLOCKTYPE_CONTROLEND && frame->block_ind != i) {
+        frame->control_base = exec->control_stack_len;
+        frame->variable_base = exec->variable_stack_len;
+        if (!exec_block_impl(exec, &chain->blocks[i], &chain->postfix[chain->postfix_start[i]], &frame->block_return, false, false, frame->block_return, profiling)) return (size_t)-1;
+        if (chain_data->running_ind != i) i = chain_data->running_ind;
+        return_used = true;
+    }
+    return exec_block_layer(exec, chain, i, frame, return_used);
+}
+
+size_t exec_block_done(ScrExec* exec, ScrBlockChain* chain, size_t i, ScrBlockFrame* frame) {
+    return exec_block_done_impl(exec, chain, i, frame, false);
+}
+
+// Runs blocks[i] and returns index of the next block to run, (size_t)-1 on error
+SCRVM_ALWAYS_INLINE size_t exec_run_block_impl(ScrExec* exec, ScrBlockChain* chain, size_t i, size_t arena_base, bool profiling) {
+    pthread_testcancel();
+    exec->arena_len = arena_base;
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    atomic_store_explicit(&chain_data->running_ind, i, memory_order_relaxed);
+    if (chain_data->is_returning) return vector_size(chain->blocks);
+    if (chain->loop_jumps[i].unwind >= 0) {
+        exec_unwind_layers(exec, chain->loop_jumps[i].unwind);
+        return chain->loop_jumps[i].next;
+    }
+
+    ScrBlockFrame frame = {
+        .block_ind = i,
+        .control_base = exec->control_stack_len,
+        .variable_base = exec->variable_stack_len,
+    };
+    bool from_end = false;
+    bool omit_args = false;
+    if (BLOCKDEF->type == BLOCKTYPE_END || BLOCKDEF->type == BLOCKTYPE_CONTROLEND) {
+        if (BLOCKDEF->type == BLOCKTYPE_CONTROLEND && chain_data->layer == 0) return i + 1;
+        omit_args = exec_pop_layer(exec, &frame);
+        from_end = true;
+    }
+    if (!exec_block_impl(exec, &chain->blocks[frame.block_ind], &chain->postfix[chain->postfix_start[frame.block_ind]], &frame.block_return, from_end, omit_args, (ScrData){0}, profiling)) {
+        return (size_t)-1;
+    }
+    return exec_block_done_impl(exec, chain, chain_data->running_ind, &frame, profiling);
+}
+
+size_t exec_run_block(ScrExec* exec, ScrBlockChain* chain, size_t i, size_t arena_base) {
+    return exec_run_block_impl(exec, chain, i, arena_base, false);
+}
+
+// Same as exec_run_block, but with blocks timed into exec->profile
+size_t profile_run_block(ScrExec* exec, ScrBlockChain* chain, size_t i, size_t arena_base) {
+    return exec_run_block_impl(exec, chain, i, arena_base, true);
+}
+
+////// Profiler
+
+#include <time.h>
+
+uint64_t profile_time_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+size_t profile_hash(ScrProfile* profile, ScrBlock* block) {
+    return (((uintptr_t)block >> 3) * 2654435761u) & (profile->cap - 1);
+}
+
+ScrBlockProfile* profile_get(ScrProfile* profile, ScrBlock* block) {
+    if (!profile->entries) return NULL;
+    for (size_t i = profile_hash(profile, block);; i = (i + 1) & (profile->cap - 1)) {
+        if (profile->entries[i].block == block) return &profile->entries[i];
+        if (!profile->entries[i].block) return NULL;
+    }
+}
+
+// Returns number of blocks added, pass NULL profile to only count them
+size_t profile_add_block(ScrProfile* profile, ScrBlock* block) {
+    size_t count = 1;
+    if (profile) {
+        size_t i = profile_hash(profile, block);
+        while (profile->entries[i].block) i = (i + 1) & (profile->cap - 1);
+        profile->entries[i].block = block;
+    }
+    for (size_t i = 0; i < vector_size(block->arguments); i++) {
+        if (block->arguments[i].type != ARGUMENT_BLOCK) continue;
+        count += profile_add_block(profile, &block->arguments[i].data.block);
+    }
+    return count;
+}
+
+void profile_init(ScrProfile* profile, ScrBlockChain* code) {
+    size_t count = 0;
+    for (size_t i = 0; i < vector_size(code); i++) {
+        for (size_t j = 0; j < vector_size(code[i].blocks); j++) count += profile_add_block(NULL, &code[i].blocks[j]);
+    }
+
+    // Keep the table at most half full
+    profile->cap = 16;
+    while (profile->cap < count * 2) profile->cap *= 2;
+    profile->entries = calloc(profile->cap, sizeof(ScrBlockProfile));
+    profile->max_exclusive_ns = 0;
+    profile->nested_ns = 0;
+    for (size_t i = 0; i < vector_size(code); i++) {
+        for (size_t j = 0; j < vector_size(code[i].blocks); j++) profile_add_block(profile, &code[i].blocks[j]);
+    }
+}
+
+// Blocks are looked up by address, so the profile has to be freed before the code is edited
+void profile_free(ScrProfile* profile) {
+    if (profile->entries) free(profile->entries);
+    profile->entries = NULL;
+    profile->cap = 0;
+    profile->max_exclusive_ns = 0;
+}
+
+void profile_add(ScrProfile* profile, ScrBlock* block, uint64_t inclusive_ns, uint64_t exclusive_ns) {
+    ScrBlockProfile* entry = profile_get(profile, block);
+    if (!entry) return;
+    entry->count++;
+    entry->inclusive_ns += inclusive_ns;
+    entry->exclusive_ns += exclusive_ns;
+    if (entry->exclusive_ns > profile->max_exclusive_ns) profile->max_exclusive_ns = entry->exclusive_ns;
+}
+
+////// Sampler
+
+void sampler_table_insert(ScrSampler* sampler, size_t stack_ind) {
+    size_t i = sampler->stacks[stack_ind].hash & (sampler->table_cap - 1);
+    while (sampler->table[i]) i = (i + 1) & (sampler->table_cap - 1);
+    sampler->table[i] = stack_ind + 1;
+}
+
+void sampler_add_stack(ScrSampler* sampler, ScrSampleFrame* frames, size_t depth) {
+    unsigned int hash = string_hash((const char*)frames, depth * sizeof(ScrSampleFrame));
+    for (size_t i = hash & (sampler->table_cap - 1); sampler->table[i]; i = (i + 1) & (sampler->table_cap - 1)) {
+        ScrSampleStack* stack = &sampler->stacks[sampler->table[i] - 1];
+        if (stack->hash != hash || stack->depth != depth) continue;
+        if (memcmp(&sampler->frames[stack->frames_start], frames, depth * sizeof(ScrSampleFrame))) continue;
+        stack->count++;
+        return;
+    }
+
+    // Keep the table at most half full
+    if ((vector_size(sampler->stacks) + 1) * 2 > sampler->table_cap) {
+        free(sampler->table);
+        sampler->table_cap *= 2;
+        sampler->table = calloc(sampler->table_cap, sizeof(size_t));
+        for (size_t i = 0; i < vector_size(sampler->stacks); i++) sampler_table_insert(sampler, i);
+    }
+
+    ScrSampleStack stack = {
+        .frames_start = vector_size(sampler->frames),
+        .depth = depth,
+        .count = 1,
+        .hash = hash,
+    };
+    for (size_t i = 0; i < depth; i++) vector_add(&sampler->frames, frames[i]);
+    vector_add(&sampler->stacks, stack);
+    sampler_table_insert(sampler, vector_size(sampler->stacks) - 1);
+}
+
+// Chain stack is read while the vm changes it. Frames are copied first and
+// the copy is dropped if a chain was pushed or popped in the meantime, same
+// as a seqlock. running_ind can still move on, which only shifts the sample
+void sampler_take_sample(ScrSampler* sampler) {
+    ScrSampleFrame frames[VM_CHAIN_STACK_SIZE];
+    ScrExec* exec = sampler->exec;
+    size_t seq = atomic_load_explicit(&exec->chain_stack_seq, memory_order_acquire);
+    if (seq & 1) return;
+    size_t depth = atomic_load_explicit(&exec->chain_stack_len, memory_order_relaxed);
+    if (depth == 0 || depth > VM_CHAIN_STACK_SIZE) return;
+
+    for (size_t i = 0; i < depth; i++) {
+        frames[i].chain = atomic_load_explicit(&exec->chain_stack[i].chain, memory_order_relaxed);
+        frames[i].running_ind = atomic_load_explicit(&exec->chain_stack[i].running_ind, memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&exec->chain_stack_seq, memory_order_relaxed) != seq) return;
+
+    for (size_t i = 0; i < depth; i++) {
+        if (!frames[i].chain || frames[i].running_ind >= vector_size(frames[i].chain->blocks)) return;
+    }
+    sampler_add_stack(sampler, frames, depth);
+    sampler->sample_count++;
+}
+
+void* sampler_thread_entry(void* thread_sampler) {
+    ScrSampler* sampler = thread_sampler;
+    struct timespec interval = {
+        .tv_sec = sampler->interval_us / 1000000,
+        .tv_nsec = (sampler->interval_us % 1000000) * 1000,
+    };
+    while (sampler->is_running) {
+        nanosleep(&interval, NULL);
+        sampler_take_sample(sampler);
+    }
+    return NULL;
+}
+
+bool sampler_start(ScrSampler* sampler, ScrExec* exec, int interval_us) {
+    sampler_free(sampler);
+    sampler->exec = exec;
+    sampler->interval_us = interval_us;
+    sampler->frames = vector_create();
+    sampler->stacks = vector_create();
+    sampler->table_cap = 64;
+    sampler->table = calloc(sampler->table_cap, sizeof(size_t));
+    sampler->sample_count = 0;
+    sampler->is_running = true;
+    if (pthread_create(&sampler->thread, NULL, sampler_thread_entry, sampler)) {
+        sampler->is_running = false;
+        return false;
+    }
+    return true;
+}
+
+void sampler_stop(ScrSampler* sampler) {
+    if (!sampler->is_running) return;
+    sampler->is_running = false;
+    pthread_join(sampler->thread, NULL);
+}
+
+void sampler_free(ScrSampler* sampler) {
+    sampler_stop(sampler);
+    if (sampler->frames) vector_free(sampler->frames);
+    if (sampler->stacks) vector_free(sampler->stacks);
+    if (sampler->table) free(sampler->table);
+    sampler->frames = NULL;
+    sampler->stacks = NULL;
+    sampler->table = NULL;
+    sampler->table_cap = 0;
+    sampler->sample_count = 0;
+}
+
+// Semicolons separate frames in folded stacks, so they can't be in names
+void sampler_add_name(ScrString* out, const char* name) {
+    for (const char* c = name; *c; c++) {
+        char ch = *c == ';' ? ':' : *c == '\n' ? ' ' : *c;
+        string_add_array(out, &ch, 1, ((unsigned char)ch & 0xc0) != 0x80);
+    }
+}
+
+// Custom blocks are named after their text and arguments, like "fib [arg0]"
+void sampler_add_blockdef_name(ScrString* out, ScrBlockdef* blockdef) {
+    if (!blockdef->chain) {
+        sampler_add_name(out, blockdef->id);
+        return;
+    }
+    for (size_t i = 0; i < vector_size(blockdef->inputs); i++) {
+        ScrInput* input = &blockdef->inputs[i];
+        if (i > 0) string_add(out, " ");
+        if (input->type == INPUT_TEXT_DISPLAY) {
+            sampler_add_name(out, input->data.stext.text);
+        } else if (input->type == INPUT_ARGUMENT) {
+            ScrBlockdef* arg = input->data.arg.blockdef;
+            string_add(out, "[");
+            if (vector_size(arg->inputs) > 0 && arg->inputs[0].type == INPUT_TEXT_DISPLAY) sampler_add_name(out, arg->inputs[0].data.stext.text);
+            string_add(out, "]");
+        }
+    }
+}
+
+void sampler_add_chain_name(ScrString* out, ScrBlockChain* chain) {
+    ScrBlock* hat = &chain->blocks[0];
+    for (size_t i = 0; i < vector_size(hat->arguments); i++) {
+        if (hat->arguments[i].type != ARGUMENT_BLOCKDEF) continue;
+        sampler_add_blockdef_name(out, hat->arguments[i].data.blockdef);
+        return;
+    }
+    sampler_add_name(out, hat->blockdef->id);
+}
+
+typedef struct {
+    ScrString name;
+    size_t count;
+} ScrFoldedLine;
+
+int sampler_compare_lines(const void* left, const void* right) {
+    return strcmp(((const ScrFoldedLine*)left)->name.str, ((const ScrFoldedLine*)right)->name.str);
+}
+
+char* sampler_folded(ScrSampler* sampler) {
+    size_t stacks_len = sampler->stacks ? vector_size(sampler->stacks) : 0;
+    ScrFoldedLine* lines = malloc((stacks_len + 1) * sizeof(ScrFoldedLine));
+    for (size_t i = 0; i < stacks_len; i++) {
+        ScrSampleStack* stack = &sampler->stacks[i];
+        ScrSampleFrame* frames = &sampler->frames[stack->frames_start];
+        lines[i].name = string_new(64);
+        lines[i].count = stack->count;
+        // Frames are chains and the last one is the block that was running in the innermost chain
+        for (size_t j = 0; j < stack->depth; j++) {
+            sampler_add_chain_name(&lines[i].name, frames[j].chain);
+            string_add(&lines[i].name, ";");
+        }
+        ScrSampleFrame* top = &frames[stack->depth - 1];
+        sampler_add_blockdef_name(&lines[i].name, top->chain->blocks[top->running_ind].blockdef);
+    }
+
+    // Different stacks may resolve to the same names, like two calls from different places in a chain
+    qsort(lines, stacks_len, sizeof(ScrFoldedLine), sampler_compare_lines);
+    ScrString out = string_new(1024);
+    char count_str[32];
+    for (size_t i = 0; i < stacks_len; i++) {
+        size_t count = lines[i].count;
+        while (i + 1 < stacks_len && !strcmp(lines[i].name.str, lines[i + 1].name.str)) {
+            string_free(lines[i].name);
+            count += lines[++i].count;
+        }
+        string_add(&out, lines[i].name.str);
+        sprintf(count_str, " %zu\n", count);
+        string_add(&out, count_str);
+        string_free(lines[i].name);
+    }
+    free(lines);
+
+    char* result = malloc(out.len + 1);
+    memcpy(result, out.str, out.len + 1);
+    string_free(out);
+    return result;
+}
+
+////// Trace recorder
+
+atomic_bool trace_enabled = false;
+uint64_t trace_start_ns = 0;
+uint64_t trace_stop_ns = 0;
+_Atomic(ScrTraceBuffer*) trace_buffers[VM_TRACE_MAX_THREADS];
+atomic_size_t trace_buffers_len = 0;
+_Thread_local ScrTraceBuffer* trace_buffer = NULL;
+_Thread_local const char* trace_name = NULL;
+
+void trace_thread_name(const char* name) {
+    trace_name = name;
+    if (trace_buffer) trace_buffer->thread_name = name;
+}
+
+// Every thread writes to its own buffer, so recording an event takes no locks.
+// Buffers of threads that have exited are given to new threads
+ScrTraceBuffer* trace_get_buffer(void) {
+    if (trace_buffer) return trace_buffer;
+
+    size_t len = atomic_load(&trace_buffers_len);
+    for (size_t i = 0; i < len && i < VM_TRACE_MAX_THREADS; i++) {
+        ScrTraceBuffer* buffer = atomic_load(&trace_buffers[i]);
+        bool in_use = false;
+        if (!buffer || !atomic_compare_exchange_strong(&buffer->in_use, &in_use, true)) continue;
+        atomic_store(&buffer->head, 0);
+        buffer->thread_name = trace_name;
+        trace_buffer = buffer;
+        return buffer;
+    }
+
+    size_t ind = atomic_fetch_add(&trace_buffers_len, 1);
+    if (ind >= VM_TRACE_MAX_THREADS) return NULL;
+    ScrTraceBuffer* buffer = calloc(1, sizeof(ScrTraceBuffer));
+    buffer->in_use = true;
+    buffer->thread_name = trace_name;
+    atomic_store(&trace_buffers[ind], buffer);
+    trace_buffer = buffer;
+    return buffer;
+}
+
+void trace_thread_exit(void) {
+    if (!trace_buffer) return;
+    atomic_store(&trace_buffer->in_use, false);
+    trace_buffer = NULL;
+}
+
+void trace_event(const char* name, ScrBlockChain* chain, char phase) {
+    ScrTraceBuffer* buffer = trace_get_buffer();
+    if (!buffer) return;
+    size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    ScrTraceEvent* event = &buffer->events[head % VM_TRACE_BUFFER_SIZE];
+    event->time_ns = profile_time_ns();
+    event->name = name;
+    event->chain = chain;
+    event->phase = phase;
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+// Should be called while traced threads are not recording anything, old events are dropped
+void trace_start(void) {
+    size_t len = atomic_load(&trace_buffers_len);
+    for (size_t i = 0; i < len && i < VM_TRACE_MAX_THREADS; i++) {
+        ScrTraceBuffer* buffer = atomic_load(&trace_buffers[i]);
+        if (buffer) atomic_store(&buffer->head, 0);
+    }
+    trace_start_ns = profile_time_ns();
+    trace_enabled = true;
+}
+
+void trace_stop(void) {
+    trace_enabled = false;
+    trace_stop_ns = profile_time_ns();
+}
+
+void trace_add_json_str(ScrString* out, const char* str) {
+    char escaped[8];
+    string_add(out, "\"");
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped[0] = '\\';
+            escaped[1] = *c;
+            string_add_array(out, escaped, 2, 2);
+        } else if ((unsigned char)*c < 0x20) {
+            sprintf(escaped, "\\u%04x", *c);
+            string_add(out, escaped);
+        } else {
+            string_add_array(out, c, 1, ((unsigned char)*c & 0xc0) != 0x80);
+        }
+    }
+    string_add(out, "\"");
+}
+
+void trace_add_event(ScrString* out, ScrString* name, ScrTraceEvent* event, char phase, uint64_t time_ns, size_t tid) {
+    char num[128];
+    name->len = 0;
+    name->str[0] = 0;
+    if (event->chain) {
+        sampler_add_chain_name(name, event->chain);
+    } else {
+        string_add(name, event->name);
+    }
+    string_add(out, ",\n{\"name\":");
+    trace_add_json_str(out, name->str);
+    sprintf(
+        num,
+        ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%zu}",
+        event->chain ? "custom" : "scrap",
+        phase,
+        (double)(time_ns - trace_start_ns) / 1000.0,
+        tid
+    );
+    string_add(out, num);
+}
+
+char* trace_json(void) {
+    ScrString out = string_new(4096);
+    ScrString name = string_new(64);
+    char num[128];
+    bool first = true;
+    size_t* open = vector_create();
+    size_t* orphans = vector_create();
+    string_add(&out, "{\"traceEvents\":[\n");
+
+    size_t len = atomic_load(&trace_buffers_len);
+    for (size_t i = 0; i < len && i < VM_TRACE_MAX_THREADS; i++) {
+        ScrTraceBuffer* buffer = atomic_load(&trace_buffers[i]);
+        if (!buffer) continue;
+        size_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        if (head == 0) continue;
+
+        if (!first) string_add(&out, ",\n");
+        first = false;
+        sprintf(num, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":", i + 1);
+        string_add(&out, num);
+        if (buffer->thread_name) {
+            trace_add_json_str(&out, buffer->thread_name);
+        } else {
+            sprintf(num, "\"thread %zu\"", i + 1);
+            string_add(&out, num);
+        }
+        string_add(&out, "}}");
+
+        // Oldest events are overwritten once the buffer is full, which can leave
+        // ends of spans without their begins. Those get a begin at the first kept
+        // event and spans that are still open get an end when tracing stopped
+        size_t start = head > VM_TRACE_BUFFER_SIZE ? head - VM_TRACE_BUFFER_SIZE : 0;
+        vector_clear(open);
+        vector_clear(orphans);
+        for (size_t j = start; j < head; j++) {
+            ScrTraceEvent* event = &buffer->events[j % VM_TRACE_BUFFER_SIZE];
+            if (event->phase == 'B') {
+                vector_add(&open, j);
+            } else if (vector_size(open) > 0) {
+                vector_pop(open);
+            } else {
+                vector_add(&orphans, j);
+            }
+        }
+
+        uint64_t first_ns = buffer->events[start % VM_TRACE_BUFFER_SIZE].time_ns;
+        for (size_t j = vector_size(orphans); j > 0; j--) {
+            trace_add_event(&out, &name, &buffer->events[orphans[j - 1] % VM_TRACE_BUFFER_SIZE], 'B', first_ns, i + 1);
+        }
+        for (size_t j = start; j < head; j++) {
+            ScrTraceEvent* event = &buffer->events[j % VM_TRACE_BUFFER_SIZE];
+            trace_add_event(&out, &name, event, event->phase, event->time_ns, i + 1);
+        }
+        for (size_t j = vector_size(open); j > 0; j--) {
+            ScrTraceEvent* event = &buffer->events[open[j - 1] % VM_TRACE_BUFFER_SIZE];
+            trace_add_event(&out, &name, event, 'E', trace_stop_ns > event->time_ns ? trace_stop_ns : event->time_ns, i + 1);
+        }
+    }
+    string_add(&out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    char* result = malloc(out.len + 1);
+    memcpy(result, out.str, out.len + 1);
+    string_free(out);
+    string_free(name);
+    vector_free(open);
+    vector_free(orphans);
+    return result;
+}
+
+void exec_chain_begin(ScrExec* exec, ScrBlockChain* chain, int argc, ScrData* argv) {
+    chain_stack_push(exec, (ScrChainStackData) {
+        .skip_block = false,
+        .layer = 0,
+        .running_ind = 0,
+        .custom_argc = argc,
+        .custom_argv = argv,
+        .is_returning = false,
+        .return_arg = (ScrData) {0},
+        .chain = chain,
+    });
+    exec->running_chain = chain;
+}
+
+// Drops everything the chain left on the stacks, base_len and arena_base are
+// the control stack and arena lengths from before exec_chain_begin
+bool exec_chain_end(ScrExec* exec, bool ok, size_t base_len, size_t arena_base, ScrData* return_val) {
+    if (!ok) {
+        chain_stack_pop(exec);
+        return false;
+    }
+    *return_val = exec->chain_stack[exec->chain_stack_len - 1].return_arg;
+    while (exec->chain_stack[exec->chain_stack_len - 1].layer >= 0) {
+        variable_stack_pop_layer(exec);
+        exec->chain_stack[exec->chain_stack_len - 1].layer--;
+    }
+    exec->control_stack_len = base_len;
+    exec->arena_len = arena_base;
+    chain_stack_pop(exec);
+    return true;
+}
+
+bool exec_run_chain(ScrExec* exec, ScrBlockChain* chain, ScrData* return_val) {
+    size_t base_len = exec->control_stack_len;
+    size_t arena_base = exec->arena_len;
+    exec_chain_begin(exec, chain, chain->custom_argc, chain->custom_argv);
+    size_t i = 0;
+    // Profiling is checked once per chain, so the loop below does not pay for it.
+    // Chain time replaces what chains called from it added to nested_ns
+    if (exec->profile) {
+        uint64_t nested_start = exec->profile->nested_ns;
+        uint64_t start = profile_time_ns();
+        while (i < vector_size(chain->blocks)) i = profile_run_block(exec, chain, i, arena_base);
+        exec->profile->nested_ns = nested_start + (profile_time_ns() - start);
+    }
+    while (i < vector_size(chain->blocks)) {
+#ifdef SCRVM_JIT
+        if (!chain->jit.func && ++chain->jit.runs == VM_JIT_THRESHOLD) jit_compile(chain);
+        if (chain->jit.func) {
+#ifdef SCRVM_JIT_WASM
+            ScrBlockFrame frame;
+            i = chain->jit.func(exec, i, arena_base, &frame);
+#else
+            i = chain->jit.func(exec, i, arena_base);
+#endif
+        } else {
+            i = exec_run_block(exec, chain, i, arena_base);
+        }
+#else
+        i = exec_run_block(exec, chain, i, arena_base);
+#endif
+        if (i == (size_t)-1) break;
+    }
+    return exec_chain_end(exec, i != (size_t)-1, base_len, arena_base, return_val);
+}
+#undef BLOCKDEF
+
+bool exec_run_compiled(ScrExec* exec, ScrCompiledChain chain, int argc, ScrData* argv, ScrData* return_val) {
+    size_t base_len = exec->control_stack_len;
+    size_t arena_base = exec->arena_len;
+    exec_chain_begin(exec, NULL, argc, argv);
+    bool ok = chain(exec, arena_base);
+    return exec_chain_end(exec, ok, base_len, arena_base, return_val);
+}
+
+bool exec_call_compiled(ScrExec* exec, ScrCompiledChain chain, int argc) {
+    size_t stack_begin = exec->arg_stack_len - argc;
+    ScrData return_val;
+    if (!exec_run_compiled(exec, chain, argc, exec->arg_stack + stack_begin, &return_val)) return false;
+    arg_stack_undo_args(exec, argc);
+    arg_stack_push_arg(exec, return_val);
+    return true;
+}
+
+ScrData exec_custom_arg(ScrExec* exec, int ind) {
+    ScrChainStackData* chain_data = &exec->chain_stack[exec->chain_stack_len - 1];
+    if (ind >= chain_data->custom_argc) RETURN_NOTHING;
+    return data_copy(chain_data->custom_argv[ind]);
+}
+
+#if defined(SCRVM_JIT) || defined(SCRVM_WASM_EMITTER)
+#include <stdint.h>
+
+// How generated code runs a block
+typedef enum {
+    // Calls exec_run_block
+    JIT_TEMPLATE_INTERPRET,
+    // Runs normal or control block inline
+    JIT_TEMPLATE_BLOCK,
+    // Closes layer and runs the control block that opened it inline
+    JIT_TEMPLATE_END,
+} ScrJitTemplate;
+
+// Index of the control block closed by every block, (size_t)-1 if there is none
+size_t* jit_block_openers(ScrBlockChain* chain) {
+    size_t* openers = vector_create();
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) vector_add(&openers, (size_t)-1);
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) {
+        if (chain->block_ends[i] != (size_t)-1) openers[chain->block_ends[i]] = i;
+    }
+    return openers;
+}
+
+ScrJitTemplate jit_block_template(ScrBlockChain* chain, size_t* openers, size_t i) {
+    if (chain->loop_jumps[i].unwind >= 0) return JIT_TEMPLATE_INTERPRET;
+    ScrBlockdef* blockdef = chain->blocks[i].blockdef;
+    if ((blockdef->type == BLOCKTYPE_NORMAL || blockdef->type == BLOCKTYPE_CONTROL) && blockdef->func) return JIT_TEMPLATE_BLOCK;
+    if (blockdef->type != BLOCKTYPE_END || openers[i] == (size_t)-1) return JIT_TEMPLATE_INTERPRET;
+    ScrBlockdef* opener = chain->blocks[openers[i]].blockdef;
+    return opener->type == BLOCKTYPE_CONTROL && opener->func ? JIT_TEMPLATE_END : JIT_TEMPLATE_INTERPRET;
+}
+
+void jit_data_free(ScrData* data) {
+    data_free(*data);
+}
+
+// Called by generated code when block at the end of a layer is not the one
+// that the layer was opened by
+size_t jit_run_popped(ScrExec* exec, ScrBlockChain* chain, bool omit_args, ScrBlockFrame* frame) {
+    if (!exec_block(exec, chain->blocks[frame->block_ind], &chain->postfix[chain->postfix_start[frame->block_ind]], &frame->block_return, true, omit_args, (ScrData){0})) {
+        return (size_t)-1;
+    }
+    return exec_block_done(exec, chain, exec->chain_stack[exec->chain_stack_len - 1].running_ind, frame);
+}
+
+// Called after a block moved the running index, usually to loop again
+size_t jit_block_moved(ScrExec* exec, ScrBlockChain* chain, size_t unused, ScrBlockFrame* frame) {
+    (void) unused;
+    pthread_testcancel();
+    return exec_block_done(exec, chain, exec->chain_stack[exec->chain_stack_len - 1].running_ind, frame);
+}
+
+void jit_arg_stack_overflow(void) {
+    printf("[VM] CRITICAL: Arg stack overflow\n");
+    pthread_exit((void*)0);
+}
+#endif
+
+#ifdef SCRVM_JIT_X86_64
+#include "jit-x86_64.h"
+#endif // SCRVM_JIT_X86_64
+
+#ifdef SCRVM_WASM_EMITTER
+// Emits a wasm module for a chain. It follows the same templates as the x86-64
+// jit, but all blocks live in one function that goes to block next through a
+// br_table at the top of a loop. Generated code imports memory and function
+// table of the vm, so it calls helpers and block functions with call_indirect
+// on their function pointers, which are table indices in wasm
+typedef struct {
+    unsigned char* code;
+    // Number of structured blocks open inside of the code of the current chain block
+    size_t depth;
+    // Branch depth of the block that exits the dispatch loop, from the start of a chain block
+    size_t exit_depth;
+    size_t chain_len;
+} ScrWasmEmitter;
+
+#define WASM_OP_UNREACHABLE 0x00
+#define WASM_OP_BLOCK 0x02
+#define WASM_OP_LOOP 0x03
+#define WASM_OP_IF 0x04
+#define WASM_OP_END 0x0b
+#define WASM_OP_BR 0x0c
+#define WASM_OP_BR_IF 0x0d
+#define WASM_OP_BR_TABLE 0x0e
+#define WASM_OP_CALL_INDIRECT 0x11
+#define WASM_OP_LOCAL_GET 0x20
+#define WASM_OP_LOCAL_SET 0x21
+#define WASM_OP_I32_LOAD 0x28
+#define WASM_OP_I64_LOAD 0x29
+#define WASM_OP_I32_LOAD8_U 0x2d
+#define WASM_OP_I32_STORE 0x36
+#define WASM_OP_I64_STORE 0x37
+#define WASM_OP_I32_CONST 0x41
+#define WASM_OP_I64_CONST 0x42
+#define WASM_OP_I32_EQZ 0x45
+#define WASM_OP_I32_EQ 0x46
+#define WASM_OP_I32_NE 0x47
+#define WASM_OP_I32_LT_S 0x48
+#define WASM_OP_I32_GT_S 0x4a
+#define WASM_OP_I32_LE_S 0x4c
+#define WASM_OP_I32_GE_S 0x4e
+#define WASM_OP_I32_GE_U 0x4f
+#define WASM_OP_I32_ADD 0x6a
+#define WASM_OP_I32_SUB 0x6b
+#define WASM_OP_I32_MUL 0x6c
+
+#define WASM_I32 0x7f
+#define WASM_VOID 0x40
+
+// Function types used by generated code, in type section order
+typedef enum {
+    // Generated function, helpers running blocks of the chain
+    WASM_TYPE_RUN,
+    // Block functions, ScrData is returned through a pointer in the first argument
+    WASM_TYPE_BLOCK,
+    WASM_TYPE_CALL_BLOCK,
+    WASM_TYPE_OP,
+    WASM_TYPE_UNDO,
+    WASM_TYPE_FREE,
+    WASM_TYPE_ABORT,
+    WASM_TYPE_LEN,
+} ScrWasmType;
+
+// Locals of generated function, the first four are its arguments
+#define WASM_LOCAL_EXEC 0
+#define WASM_LOCAL_START 1
+#define WASM_LOCAL_ARENA_BASE 2
+#define WASM_LOCAL_FRAME 3
+#define WASM_LOCAL_NEXT 4
+#define WASM_LOCAL_STACK_BEGIN 5
+#define WASM_LOCAL_OMIT_ARGS 6
+#define WASM_LOCAL_CHAIN_DATA 7
+#define WASM_LOCAL_ADDR 8
+#define WASM_LOCAL_VALUE 9
+#define WASM_LOCALS_LEN 10
+
+#define WASM_DATA_TYPE offsetof(ScrData, type)
+#define WASM_DATA_STORAGE (offsetof(ScrData, storage) + offsetof(ScrDataStorage, type))
+#define WASM_DATA_INT (offsetof(ScrData, data) + offsetof(ScrDataContents, int_arg))
+#define WASM_FRAME_RETURN offsetof(ScrBlockFrame, block_return)
+
+_Static_assert(sizeof(ScrData) % 8 == 0, "ScrData is copied in 8 byte words");
+
+void wasm_emit_byte(ScrWasmEmitter* wasm, unsigned char byte) {
+    vector_add(&wasm->code, byte);
+}
+
+void wasm_emit_uleb(ScrWasmEmitter* wasm, uint64_t value) {
+    do {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        wasm_emit_byte(wasm, byte | (value ? 0x80 : 0));
+    } while (value);
+}
+
+void wasm_emit_sleb(ScrWasmEmitter* wasm, int64_t value) {
+    for (;;) {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        if ((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40))) {
+            wasm_emit_byte(wasm, byte);
+            return;
+        }
+        wasm_emit_byte(wasm, byte | 0x80);
+    }
+}
+
+void wasm_emit_name(ScrWasmEmitter* wasm, const char* name) {
+    wasm_emit_uleb(wasm, strlen(name));
+    for (const char* c = name; *c; c++) wasm_emit_byte(wasm, *c);
+}
+
+// Opens block, loop or if and returns its label
+size_t wasm_open(ScrWasmEmitter* wasm, unsigned char op) {
+    wasm_emit_byte(wasm, op);
+    wasm_emit_byte(wasm, WASM_VOID);
+    return ++wasm->depth;
+}
+
+void wasm_close(ScrWasmEmitter* wasm) {
+    wasm_emit_byte(wasm, WASM_OP_END);
+    wasm->depth--;
+}
+
+void wasm_emit_br(ScrWasmEmitter* wasm, unsigned char op, size_t label) {
+    wasm_emit_byte(wasm, op);
+    wasm_emit_uleb(wasm, wasm->depth - label);
+}
+
+void wasm_emit_local(ScrWasmEmitter* wasm, unsigned char op, int local) {
+    wasm_emit_byte(wasm, op);
+    wasm_emit_uleb(wasm, local);
+}
+
+void wasm_emit_i32(ScrWasmEmitter* wasm, int32_t value) {
+    wasm_emit_byte(wasm, WASM_OP_I32_CONST);
+    wasm_emit_sleb(wasm, value);
+}
+
+void wasm_emit_ptr(ScrWasmEmitter* wasm, const void* ptr) {
+    wasm_emit_i32(wasm, (int32_t)(uintptr_t)ptr);
+}
+
+// Loads and stores take address from the stack, offset is added to it
+void wasm_emit_mem(ScrWasmEmitter* wasm, unsigned char op, size_t offset) {
+    wasm_emit_byte(wasm, op);
+    wasm_emit_uleb(wasm, 0);
+    wasm_emit_uleb(wasm, offset);
+}
+
+void wasm_emit_load(ScrWasmEmitter* wasm, int local, size_t offset) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, local);
+    wasm_emit_mem(wasm, WASM_OP_I32_LOAD, offset);
+}
+
+void wasm_emit_call(ScrWasmEmitter* wasm, const void* func, ScrWasmType type) {
+    wasm_emit_ptr(wasm, func);
+    wasm_emit_byte(wasm, WASM_OP_CALL_INDIRECT);
+    wasm_emit_uleb(wasm, type);
+    wasm_emit_byte(wasm, 0);
+}
+
+// Leaves the chain, next must already be set
+void wasm_emit_exit(ScrWasmEmitter* wasm) {
+    wasm_emit_byte(wasm, WASM_OP_BR);
+    wasm_emit_uleb(wasm, wasm->exit_depth + wasm->depth);
+}
+
+// Goes to block with index on the stack
+void wasm_emit_dispatch(ScrWasmEmitter* wasm) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_NEXT);
+    wasm_emit_byte(wasm, WASM_OP_BR);
+    wasm_emit_uleb(wasm, wasm->exit_depth + wasm->depth + 1);
+}
+
+void wasm_emit_error_if(ScrWasmEmitter* wasm) {
+    wasm_open(wasm, WASM_OP_IF);
+    wasm_emit_i32(wasm, -1);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_NEXT);
+    wasm_emit_exit(wasm);
+    wasm_close(wasm);
+}
+
+// Calls helper that returns false on error
+void wasm_emit_call_checked(ScrWasmEmitter* wasm, const void* func, ScrWasmType type) {
+    wasm_emit_call(wasm, func, type);
+    wasm_emit_byte(wasm, WASM_OP_I32_EQZ);
+    wasm_emit_error_if(wasm);
+}
+
+// Calls helper with exec, chain, argument pushed by caller and frame, and goes where it says
+void wasm_emit_call_helper(ScrWasmEmitter* wasm, const void* func) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+    wasm_emit_call(wasm, func, WASM_TYPE_RUN);
+    wasm_emit_dispatch(wasm);
+}
+
+void wasm_emit_exec_chain(ScrWasmEmitter* wasm, ScrBlockChain* chain) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_ptr(wasm, chain);
+}
+
+// Leaves address of arg_stack[arg_stack_len] minus offset values in local addr.
+// Memory offsets must be positive, so arg stack offset is added by the loads
+void wasm_emit_arg_addr(ScrWasmEmitter* wasm, int offset) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, arg_stack_len));
+    if (offset) {
+        wasm_emit_i32(wasm, offset);
+        wasm_emit_byte(wasm, WASM_OP_I32_SUB);
+    }
+    wasm_emit_i32(wasm, sizeof(ScrData));
+    wasm_emit_byte(wasm, WASM_OP_I32_MUL);
+    wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_ADDR);
+}
+
+void wasm_emit_add_arg_len(ScrWasmEmitter* wasm, int count) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, arg_stack_len));
+    wasm_emit_i32(wasm, count);
+    wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arg_stack_len));
+}
+
+void wasm_emit_push_check(ScrWasmEmitter* wasm) {
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, arg_stack_len));
+    wasm_emit_i32(wasm, VM_ARG_STACK_SIZE);
+    wasm_emit_byte(wasm, WASM_OP_I32_GE_U);
+    wasm_open(wasm, WASM_OP_IF);
+    wasm_emit_call(wasm, jit_arg_stack_overflow, WASM_TYPE_ABORT);
+    wasm_emit_byte(wasm, WASM_OP_UNREACHABLE);
+    wasm_close(wasm);
+}
+
+// Pushes value that is read from memory on each run
+void wasm_emit_push(ScrWasmEmitter* wasm, ScrData* value) {
+    wasm_emit_push_check(wasm);
+    wasm_emit_arg_addr(wasm, 0);
+    for (size_t i = 0; i < sizeof(ScrData); i += 8) {
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+        wasm_emit_ptr(wasm, value);
+        wasm_emit_mem(wasm, WASM_OP_I64_LOAD, i);
+        wasm_emit_mem(wasm, WASM_OP_I64_STORE, offsetof(ScrExec, arg_stack) + i);
+    }
+    wasm_emit_add_arg_len(wasm, 1);
+}
+
+// Pushes value known at compile time
+void wasm_emit_push_const(ScrWasmEmitter* wasm, ScrData value) {
+    int64_t words[sizeof(ScrData) / 8];
+    memcpy(words, &value, sizeof(ScrData));
+    wasm_emit_push_check(wasm);
+    wasm_emit_arg_addr(wasm, 0);
+    for (size_t i = 0; i < sizeof(ScrData) / 8; i++) {
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+        wasm_emit_byte(wasm, WASM_OP_I64_CONST);
+        wasm_emit_sleb(wasm, words[i]);
+        wasm_emit_mem(wasm, WASM_OP_I64_STORE, offsetof(ScrExec, arg_stack) + i * 8);
+    }
+    wasm_emit_add_arg_len(wasm, 1);
+}
+
+unsigned char wasm_compare_op(ScrBuiltin builtin) {
+    switch (builtin) {
+    case BUILTIN_LESS: return WASM_OP_I32_LT_S;
+    case BUILTIN_LESS_EQ: return WASM_OP_I32_LE_S;
+    case BUILTIN_MORE: return WASM_OP_I32_GT_S;
+    case BUILTIN_MORE_EQ: return WASM_OP_I32_GE_S;
+    case BUILTIN_EQ: return WASM_OP_I32_EQ;
+    case BUILTIN_NOT_EQ: return WASM_OP_I32_NE;
+    default: return 0;
+    }
+}
+
+void wasm_emit_call_op(ScrWasmEmitter* wasm, const void* func, ScrPostfixOp* op) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_ptr(wasm, op);
+    wasm_emit_call_checked(wasm, func, WASM_TYPE_OP);
+}
+
+void wasm_emit_call_block(ScrWasmEmitter* wasm, ScrBlock* block, int argc) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_ptr(wasm, block);
+    wasm_emit_i32(wasm, argc);
+    wasm_emit_call_checked(wasm, exec_call_block, WASM_TYPE_CALL_BLOCK);
+}
+
+void wasm_emit_compare(ScrWasmEmitter* wasm, ScrPostfixOp* op) {
+    unsigned char compare = wasm_compare_op(op->block->blockdef->builtin);
+    if (!compare) {
+        wasm_emit_call_op(wasm, exec_compare, op);
+        return;
+    }
+
+    size_t done = wasm_open(wasm, WASM_OP_BLOCK);
+    size_t slow = wasm_open(wasm, WASM_OP_BLOCK);
+    wasm_emit_arg_addr(wasm, 2);
+    for (int i = 0; i < 2; i++) {
+        wasm_emit_load(wasm, WASM_LOCAL_ADDR, offsetof(ScrExec, arg_stack) + i * sizeof(ScrData) + WASM_DATA_TYPE);
+        wasm_emit_i32(wasm, DATA_INT);
+        wasm_emit_byte(wasm, WASM_OP_I32_NE);
+        wasm_emit_br(wasm, WASM_OP_BR_IF, slow);
+    }
+
+    wasm_emit_load(wasm, WASM_LOCAL_ADDR, offsetof(ScrExec, arg_stack) + WASM_DATA_INT);
+    wasm_emit_load(wasm, WASM_LOCAL_ADDR, offsetof(ScrExec, arg_stack) + sizeof(ScrData) + WASM_DATA_INT);
+    wasm_emit_byte(wasm, compare);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_VALUE);
+
+    // Left value becomes the static bool result
+    for (size_t i = 0; i < sizeof(ScrData); i += 8) {
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+        wasm_emit_byte(wasm, WASM_OP_I64_CONST);
+        wasm_emit_sleb(wasm, 0);
+        wasm_emit_mem(wasm, WASM_OP_I64_STORE, offsetof(ScrExec, arg_stack) + i);
+    }
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+    wasm_emit_i32(wasm, DATA_BOOL);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arg_stack) + WASM_DATA_TYPE);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+    wasm_emit_i32(wasm, DATA_STORAGE_STATIC);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arg_stack) + WASM_DATA_STORAGE);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_VALUE);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arg_stack) + WASM_DATA_INT);
+    wasm_emit_add_arg_len(wasm, -1);
+    wasm_emit_br(wasm, WASM_OP_BR, done);
+    wasm_close(wasm);
+
+    wasm_emit_call_block(wasm, op->block, 2);
+    wasm_close(wasm);
+}
+
+unsigned char wasm_arith_op(ScrBuiltin builtin) {
+    switch (builtin) {
+    case BUILTIN_PLUS: return WASM_OP_I32_ADD;
+    case BUILTIN_MINUS: return WASM_OP_I32_SUB;
+    case BUILTIN_MULT: return WASM_OP_I32_MUL;
+    default: return 0;
+    }
+}
+
+// Int arithmetic is done inline, anything else goes through exec_arith
+void wasm_emit_arith(ScrWasmEmitter* wasm, ScrPostfixOp* op) {
+    size_t done = wasm_open(wasm, WASM_OP_BLOCK);
+    size_t slow = wasm_open(wasm, WASM_OP_BLOCK);
+    wasm_emit_arg_addr(wasm, 2);
+    for (int i = 0; i < 2; i++) {
+        wasm_emit_load(wasm, WASM_LOCAL_ADDR, offsetof(ScrExec, arg_stack) + i * sizeof(ScrData) + WASM_DATA_TYPE);
+        wasm_emit_i32(wasm, DATA_INT);
+        wasm_emit_byte(wasm, WASM_OP_I32_NE);
+        wasm_emit_br(wasm, WASM_OP_BR_IF, slow);
+    }
+
+    // Left value becomes the static int result
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+    wasm_emit_load(wasm, WASM_LOCAL_ADDR, offsetof(ScrExec, arg_stack) + WASM_DATA_INT);
+    wasm_emit_load(wasm, WASM_LOCAL_ADDR, offsetof(ScrExec, arg_stack) + sizeof(ScrData) + WASM_DATA_INT);
+    wasm_emit_byte(wasm, wasm_arith_op(op->block->blockdef->builtin));
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arg_stack) + WASM_DATA_INT);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+    wasm_emit_i32(wasm, DATA_STORAGE_STATIC);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arg_stack) + WASM_DATA_STORAGE);
+    wasm_emit_add_arg_len(wasm, -1);
+    wasm_emit_br(wasm, WASM_OP_BR, done);
+    wasm_close(wasm);
+
+    wasm_emit_call_op(wasm, exec_arith, op);
+    wasm_close(wasm);
+}
+
+const void* wasm_fused_block_func(ScrPostfixOpType type) {
+    switch (type) {
+    case POSTFIX_INC_VAR: return exec_inc_var;
+    case POSTFIX_APPEND_VAR: return exec_append_var;
+    default: return exec_set_var;
+    }
+}
+
+// Emits argument program that falls through once arguments are ready and
+// branches to block_done if a fused op has already run the block
+bool wasm_emit_args(ScrWasmEmitter* wasm, ScrPostfixOp* ops, size_t block_done) {
+    size_t ops_len = 1;
+    while (ops[ops_len - 1].type != POSTFIX_END) ops_len++;
+
+    // Skips only go forward and nest like the blocks they came from, so every
+    // skip becomes a wasm block ending right before its target
+    size_t* skip_ends = vector_create();
+    bool ok = true;
+    for (size_t i = 0; ok && i < ops_len; i++) {
+        while (vector_size(skip_ends) > 0 && skip_ends[vector_size(skip_ends) - 1] == i) {
+            wasm_close(wasm);
+            vector_pop(skip_ends);
+        }
+
+        ScrPostfixOp* op = &ops[i];
+        switch (op->type) {
+        case POSTFIX_PUSH:
+            wasm_emit_push(wasm, op->value);
+            break;
+        case POSTFIX_CALL:
+            wasm_emit_call_block(wasm, op->block, op->argc);
+            break;
+        case POSTFIX_SKIP_IF_FALSE:
+        case POSTFIX_SKIP_IF_TRUE: {
+            size_t end = i + op->skip + 1;
+            if (end >= ops_len || (vector_size(skip_ends) > 0 && end > skip_ends[vector_size(skip_ends) - 1])) {
+                ok = false;
+                break;
+            }
+            size_t skip = wasm_open(wasm, WASM_OP_BLOCK);
+            vector_add(&skip_ends, end);
+            wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+            wasm_emit_i32(wasm, op->type == POSTFIX_SKIP_IF_TRUE);
+            wasm_emit_call(wasm, exec_short_circuit, WASM_TYPE_OP);
+            wasm_emit_br(wasm, WASM_OP_BR_IF, skip);
+            break;
+        }
+        case POSTFIX_GET_VAR:
+            wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+            wasm_emit_ptr(wasm, op);
+            wasm_emit_call(wasm, exec_push_var, WASM_TYPE_UNDO);
+            break;
+        case POSTFIX_LIST_GET_VAR:
+            wasm_emit_call_op(wasm, exec_list_get_var, op);
+            break;
+        case POSTFIX_COMPARE:
+            wasm_emit_compare(wasm, op);
+            break;
+        case POSTFIX_ARITH:
+            wasm_emit_arith(wasm, op);
+            break;
+        case POSTFIX_INC_VAR:
+        case POSTFIX_APPEND_VAR:
+        case POSTFIX_SET_VAR:
+            wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+            wasm_emit_ptr(wasm, op);
+            wasm_emit_call(wasm, wasm_fused_block_func(op->type), WASM_TYPE_OP);
+            wasm_emit_i32(wasm, POSTFIX_ERROR);
+            wasm_emit_byte(wasm, WASM_OP_I32_EQ);
+            wasm_emit_error_if(wasm);
+            wasm_emit_br(wasm, WASM_OP_BR, block_done);
+            break;
+        case POSTFIX_END:
+            break;
+        default:
+            ok = false;
+            break;
+        }
+    }
+    // Every skip ends at or before POSTFIX_END, this only happens on failure
+    while (vector_size(skip_ends) > 0) {
+        wasm_close(wasm);
+        vector_pop(skip_ends);
+    }
+    vector_free(skip_ends);
+    return ok;
+}
+
+void wasm_emit_undo_args(ScrWasmEmitter* wasm) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, arg_stack_len));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_STACK_BEGIN);
+    wasm_emit_byte(wasm, WASM_OP_I32_SUB);
+    wasm_emit_call(wasm, arg_stack_undo_args, WASM_TYPE_UNDO);
+}
+
+void wasm_emit_frame_return(ScrWasmEmitter* wasm) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+    if (WASM_FRAME_RETURN) {
+        wasm_emit_i32(wasm, WASM_FRAME_RETURN);
+        wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    }
+}
+
+// Same as exec_block with block function called directly and arguments inline
+bool wasm_emit_exec_block(ScrWasmEmitter* wasm, ScrBlockChain* chain, size_t ind, bool from_end) {
+    ScrBlock* block = &chain->blocks[ind];
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, arg_stack_len));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_STACK_BEGIN);
+
+    ScrData prologue[4];
+    size_t prologue_len = block_prologue(block->blockdef, from_end, (ScrData) {0}, prologue);
+    for (size_t i = 0; i < prologue_len; i++) wasm_emit_push_const(wasm, prologue[i]);
+
+    size_t ran = wasm_open(wasm, WASM_OP_BLOCK);
+    size_t block_done = wasm_open(wasm, WASM_OP_BLOCK);
+    size_t args_done = wasm_open(wasm, WASM_OP_BLOCK);
+    if (from_end) {
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_OMIT_ARGS);
+        wasm_emit_br(wasm, WASM_OP_BR_IF, args_done);
+    }
+    if (!wasm_emit_args(wasm, &chain->postfix[chain->postfix_start[ind]], block_done)) return false;
+    wasm_close(wasm);
+
+    wasm_emit_frame_return(wasm);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, arg_stack_len));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_STACK_BEGIN);
+    wasm_emit_byte(wasm, WASM_OP_I32_SUB);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_STACK_BEGIN);
+    wasm_emit_i32(wasm, sizeof(ScrData));
+    wasm_emit_byte(wasm, WASM_OP_I32_MUL);
+    wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    wasm_emit_i32(wasm, offsetof(ScrExec, arg_stack));
+    wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    wasm_emit_call(wasm, block->blockdef->func, WASM_TYPE_BLOCK);
+    wasm_emit_undo_args(wasm);
+    wasm_emit_br(wasm, WASM_OP_BR, ran);
+    wasm_close(wasm);
+
+    // Fused op left block result on top of the stack
+    wasm_emit_add_arg_len(wasm, -1);
+    wasm_emit_arg_addr(wasm, 0);
+    for (size_t i = 0; i < sizeof(ScrData); i += 8) {
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ADDR);
+        wasm_emit_mem(wasm, WASM_OP_I64_LOAD, offsetof(ScrExec, arg_stack) + i);
+        wasm_emit_mem(wasm, WASM_OP_I64_STORE, WASM_FRAME_RETURN + i);
+    }
+    wasm_emit_undo_args(wasm);
+    wasm_close(wasm);
+    return true;
+}
+
+void wasm_emit_save_bases(ScrWasmEmitter* wasm, size_t ind) {
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+    wasm_emit_i32(wasm, ind);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrBlockFrame, block_ind));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, control_stack_len));
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrBlockFrame, control_base));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, variable_stack_len));
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrBlockFrame, variable_base));
+}
+
+bool wasm_emit_block(ScrWasmEmitter* wasm, ScrBlockChain* chain, size_t* openers, size_t i) {
+    ScrJitTemplate kind = jit_block_template(chain, openers, i);
+    if (kind == JIT_TEMPLATE_INTERPRET) {
+        wasm_emit_exec_chain(wasm, chain);
+        wasm_emit_i32(wasm, i);
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ARENA_BASE);
+        wasm_emit_call(wasm, exec_run_block, WASM_TYPE_RUN);
+        wasm_emit_dispatch(wasm);
+        return true;
+    }
+
+    // Same as the start of exec_run_block, only loops check for cancellation
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_CHAIN_DATA);
+    wasm_emit_i32(wasm, i);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrChainStackData, running_ind));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_ARENA_BASE);
+    wasm_emit_mem(wasm, WASM_OP_I32_STORE, offsetof(ScrExec, arena_len));
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_CHAIN_DATA);
+    wasm_emit_mem(wasm, WASM_OP_I32_LOAD8_U, offsetof(ScrChainStackData, is_returning));
+    wasm_open(wasm, WASM_OP_IF);
+    wasm_emit_i32(wasm, wasm->chain_len);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_NEXT);
+    wasm_emit_exit(wasm);
+    wasm_close(wasm);
+
+    size_t opener = openers[i];
+    if (kind == JIT_TEMPLATE_BLOCK) {
+        wasm_emit_save_bases(wasm, i);
+        if (!wasm_emit_exec_block(wasm, chain, i, false)) return false;
+        if (chain->blocks[i].blockdef->type == BLOCKTYPE_CONTROL) {
+            // Pushes control layer
+            wasm_emit_exec_chain(wasm, chain);
+            wasm_emit_load(wasm, WASM_LOCAL_CHAIN_DATA, offsetof(ScrChainStackData, running_ind));
+            wasm_emit_call_helper(wasm, exec_block_done);
+            return true;
+        }
+    } else {
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_FRAME);
+        wasm_emit_call(wasm, exec_pop_layer, WASM_TYPE_OP);
+        wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_OMIT_ARGS);
+
+        wasm_emit_load(wasm, WASM_LOCAL_FRAME, offsetof(ScrBlockFrame, block_ind));
+        wasm_emit_i32(wasm, opener);
+        wasm_emit_byte(wasm, WASM_OP_I32_NE);
+        wasm_open(wasm, WASM_OP_IF);
+        wasm_emit_exec_chain(wasm, chain);
+        wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_OMIT_ARGS);
+        wasm_emit_call_helper(wasm, jit_run_popped);
+        wasm_close(wasm);
+
+        if (!wasm_emit_exec_block(wasm, chain, opener, true)) return false;
+    }
+
+    // Finishes block like exec_block_done does when it did not touch running index
+    wasm_emit_load(wasm, WASM_LOCAL_CHAIN_DATA, offsetof(ScrChainStackData, running_ind));
+    wasm_emit_i32(wasm, i);
+    wasm_emit_byte(wasm, WASM_OP_I32_NE);
+    wasm_open(wasm, WASM_OP_IF);
+    wasm_emit_exec_chain(wasm, chain);
+    wasm_emit_i32(wasm, 0);
+    wasm_emit_call_helper(wasm, jit_block_moved);
+    wasm_close(wasm);
+
+    wasm_emit_frame_return(wasm);
+    wasm_emit_mem(wasm, WASM_OP_I32_LOAD, WASM_DATA_STORAGE);
+    wasm_emit_i32(wasm, DATA_STORAGE_MANAGED);
+    wasm_emit_byte(wasm, WASM_OP_I32_EQ);
+    wasm_open(wasm, WASM_OP_IF);
+    wasm_emit_frame_return(wasm);
+    wasm_emit_call(wasm, jit_data_free, WASM_TYPE_FREE);
+    wasm_close(wasm);
+    return true;
+}
+
+// Emits contents of other emitter prefixed by their size and clears it
+void wasm_emit_sized(ScrWasmEmitter* wasm, ScrWasmEmitter* contents) {
+    wasm_emit_uleb(wasm, vector_size(contents->code));
+    for (size_t i = 0; i < vector_size(contents->code); i++) wasm_emit_byte(wasm, contents->code[i]);
+    vector_clear(contents->code);
+}
+
+void wasm_emit_section(ScrWasmEmitter* wasm, unsigned char id, ScrWasmEmitter* section) {
+    wasm_emit_byte(wasm, id);
+    wasm_emit_sized(wasm, section);
+}
+
+void wasm_emit_type(ScrWasmEmitter* wasm, int params, bool result) {
+    wasm_emit_byte(wasm, 0x60);
+    wasm_emit_uleb(wasm, params);
+    for (int i = 0; i < params; i++) wasm_emit_byte(wasm, WASM_I32);
+    wasm_emit_uleb(wasm, result);
+    if (result) wasm_emit_byte(wasm, WASM_I32);
+}
+
+// Body of the exported function. Blocks are nested so that br_table at the
+// innermost one lands right before the code of any block, and code of every
+// block falls through to the next one
+bool wasm_emit_function(ScrWasmEmitter* wasm, ScrBlockChain* chain) {
+    size_t chain_len = vector_size(chain->blocks);
+    wasm->chain_len = chain_len;
+
+    wasm_emit_uleb(wasm, 1);
+    wasm_emit_uleb(wasm, WASM_LOCALS_LEN - 4);
+    wasm_emit_byte(wasm, WASM_I32);
+
+    // chain_data = &exec->chain_stack[exec->chain_stack_len - 1]
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_EXEC);
+    wasm_emit_load(wasm, WASM_LOCAL_EXEC, offsetof(ScrExec, chain_stack_len));
+    wasm_emit_i32(wasm, sizeof(ScrChainStackData));
+    wasm_emit_byte(wasm, WASM_OP_I32_MUL);
+    wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    wasm_emit_i32(wasm, offsetof(ScrExec, chain_stack) - sizeof(ScrChainStackData));
+    wasm_emit_byte(wasm, WASM_OP_I32_ADD);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_CHAIN_DATA);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_START);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_NEXT);
+
+    wasm_emit_byte(wasm, WASM_OP_LOOP);
+    wasm_emit_byte(wasm, WASM_VOID);
+    wasm_emit_byte(wasm, WASM_OP_BLOCK);
+    wasm_emit_byte(wasm, WASM_VOID);
+    for (size_t i = 0; i < chain_len; i++) {
+        wasm_emit_byte(wasm, WASM_OP_BLOCK);
+        wasm_emit_byte(wasm, WASM_VOID);
+    }
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_NEXT);
+    wasm_emit_byte(wasm, WASM_OP_BR_TABLE);
+    wasm_emit_uleb(wasm, chain_len);
+    for (size_t i = 0; i < chain_len; i++) wasm_emit_uleb(wasm, i);
+    wasm_emit_uleb(wasm, chain_len);
+
+    bool ok = true;
+    size_t* openers = jit_block_openers(chain);
+    for (size_t i = 0; ok && i < chain_len; i++) {
+        wasm_emit_byte(wasm, WASM_OP_END);
+        wasm->depth = 0;
+        wasm->exit_depth = chain_len - 1 - i;
+        ok = wasm_emit_block(wasm, chain, openers, i);
+    }
+    vector_free(openers);
+    if (!ok) return false;
+
+    wasm_emit_i32(wasm, chain_len);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_SET, WASM_LOCAL_NEXT);
+    wasm_emit_byte(wasm, WASM_OP_END);
+    wasm_emit_byte(wasm, WASM_OP_END);
+    wasm_emit_local(wasm, WASM_OP_LOCAL_GET, WASM_LOCAL_NEXT);
+    wasm_emit_byte(wasm, WASM_OP_END);
+    return true;
+}
+
+// Returns module exporting "run" with ScrJitFunc signature, or NULL if the
+// chain can not be compiled. Module imports memory and __indirect_function_table
+// of the vm as env.memory and env.table
+unsigned char* wasm_compile_chain(ScrBlockChain* chain, bool shared_memory) {
+    ScrWasmEmitter wasm = { .code = vector_create() };
+    ScrWasmEmitter section = { .code = vector_create() };
+
+    static const unsigned char header[] = { 0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00 };
+    for (size_t i = 0; i < sizeof(header); i++) wasm_emit_byte(&wasm, header[i]);
+
+    wasm_emit_uleb(&section, WASM_TYPE_LEN);
+    wasm_emit_type(&section, 4, true); // WASM_TYPE_RUN
+    wasm_emit_type(&section, 4, false); // WASM_TYPE_BLOCK
+    wasm_emit_type(&section, 3, true); // WASM_TYPE_CALL_BLOCK
+    wasm_emit_type(&section, 2, true); // WASM_TYPE_OP
+    wasm_emit_type(&section, 2, false); // WASM_TYPE_UNDO
+    wasm_emit_type(&section, 1, false); // WASM_TYPE_FREE
+    wasm_emit_type(&section, 0, false); // WASM_TYPE_ABORT
+    wasm_emit_section(&wasm, 1, &section);
+
+    wasm_emit_uleb(&section, 2);
+    wasm_emit_name(&section, "env");
+    wasm_emit_name(&section, "memory");
+    wasm_emit_byte(&section, 0x02);
+    if (shared_memory) {
+        // Shared memory must declare maximum size, use the largest one
+        wasm_emit_byte(&section, 0x03);
+        wasm_emit_uleb(&section, 0);
+        wasm_emit_uleb(&section, 65536);
+    } else {
+        wasm_emit_byte(&section, 0x00);
+        wasm_emit_uleb(&section, 0);
+    }
+    wasm_emit_name(&section, "env");
+    wasm_emit_name(&section, "table");
+    wasm_emit_byte(&section, 0x01);
+    wasm_emit_byte(&section, 0x70);
+    wasm_emit_byte(&section, 0x00);
+    wasm_emit_uleb(&section, 0);
+    wasm_emit_section(&wasm, 2, &section);
+
+    wasm_emit_uleb(&section, 1);
+    wasm_emit_uleb(&section, WASM_TYPE_RUN);
+    wasm_emit_section(&wasm, 3, &section);
+
+    wasm_emit_uleb(&section, 1);
+    wasm_emit_name(&section, "run");
+    wasm_emit_byte(&section, 0x00);
+    wasm_emit_uleb(&section, 0);
+    wasm_emit_section(&wasm, 7, &section);
+
+    ScrWasmEmitter body = { .code = vector_create() };
+    bool ok = wasm_emit_function(&body, chain);
+    if (ok) {
+        wasm_emit_uleb(&section, 1);
+        wasm_emit_sized(&section, &body);
+        wasm_emit_section(&wasm, 10, &section);
+    }
+    vector_free(body.code);
+    vector_free(section.code);
+    if (!ok) {
+        vector_free(wasm.code);
+        return NULL;
+    }
+    return wasm.code;
+}
+#endif // SCRVM_WASM_EMITTER
+
+#ifdef SCRVM_JIT_WASM
+#include <emscripten.h>
+
+EM_JS_DEPS(scrvm_jit, "$addFunction,$removeFunction");
+
+// Module is instantiated by the thread that runs the vm, so its function
+// ends up in the table of that thread
+EM_JS(int, jit_wasm_instantiate, (const unsigned char* code, size_t size), {
+    try {
+        var module = new WebAssembly.Module(HEAPU8.slice(code, code + size));
+        var instance = new WebAssembly.Instance(module, { env: { memory: wasmMemory, table: wasmTable } });
+        return addFunction(instance.exports.run);
+    } catch (e) {
+        console.warn("[VM] Could not compile chain:", e);
+        return 0;
+    }
+});
+
+// Has to run on the thread that added the function, see exec_thread_exit
+EM_JS(void, jit_wasm_remove, (int func), {
+    removeFunction(func);
+});
+
+void jit_compile(ScrBlockChain* chain) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+    unsigned char* code = wasm_compile_chain(chain, true);
+#else
+    unsigned char* code = wasm_compile_chain(chain, false);
+#endif
+    if (!code) return;
+    int func = jit_wasm_instantiate(code, vector_size(code));
+    chain->jit.size = vector_size(code);
+    vector_free(code);
+    if (!func) return;
+    chain->jit.func = (ScrJitFunc)(uintptr_t)func;
+}
+
+void jit_free(ScrJitCode* jit) {
+    if (jit->func) jit_wasm_remove((int)(uintptr_t)jit->func);
+    jit->func = NULL;
+    jit->size = 0;
+    jit->runs = 0;
+}
+#endif // SCRVM_JIT_WASM
+
+#ifndef SCRVM_JIT
+void jit_free(ScrJitCode* jit) {
+    (void) jit;
+}
+#endif
+
+void exec_thread_exit(void* thread_exec) {
+    ScrExec* exec = thread_exec;
+    // Compiled code is freed by the thread that compiled it, as on the web
+    // each thread has its own function table
+    if (exec->code) {
+        for (size_t i = 0; i < vector_size(exec->code); i++) jit_free(&exec->code[i].jit);
+    }
+    variable_stack_cleanup(exec);
+    arg_stack_undo_args(exec, exec->arg_stack_len);
+    trace_thread_exit();
+    exec->is_running = false;
+}
+
+void exec_thread_begin(ScrExec* exec) {
+    trace_thread_name("vm");
+    exec->is_running = true;
+    exec->arg_stack_len = 0;
+    exec->control_stack_len = 0;
+    exec->chain_stack_len = 0;
+    exec->arena_len = 0;
+    exec->running_chain = NULL;
+    exec->block_count = 0;
+}
+
+void* exec_thread_entry(void* thread_exec) {
+    ScrExec* exec = thread_exec;
+    pthread_cleanup_push(exec_thread_exit, thread_exec);
+    exec_thread_begin(exec);
+
+    for (size_t i = 0; i < vector_size(exec->code); i++) {
+        ScrBlock* block = &exec->code[i].blocks[0];
+        if (block->blockdef->type != BLOCKTYPE_HAT) continue;
+        for (size_t j = 0; j < vector_size(block->arguments); j++) {
+            if (block->arguments[j].type != ARGUMENT_BLOCKDEF) continue;
+            block->arguments[j].data.blockdef->chain = &exec->code[i];
+        }
+    }
+
+    for (size_t i = 0; i < vector_size(exec->code); i++) {
+        ScrBlock* block = &exec->code[i].blocks[0];
+        if (block->blockdef->type != BLOCKTYPE_HAT) continue;
+        bool cont = false;
+        for (size_t j = 0; j < vector_size(block->arguments); j++) {
+            if (block->arguments[j].type == ARGUMENT_BLOCKDEF) {
+                cont = true;
+                break;
+            }
+        }
+        if (cont) continue;
+        exec->code[i].custom_argc = -1;
+        exec->code[i].custom_argv = NULL;
+        ScrData bin;
+        if (!exec_run_chain(exec, &exec->code[i], &bin)) {
+            exec->running_chain = NULL;
+            pthread_exit((void*)0);
+        }
+        exec->running_chain = NULL;
+    }
+
+    pthread_cleanup_pop(1);
+    pthread_exit((void*)1);
+}
+
+bool exec_start(ScrVm* vm, ScrExec* exec) {
+    if (vm->is_running) return false;
+    if (exec->is_running) return false;
+    vm->is_running = true;
+
+    for (size_t i = 0; i < vector_size(exec->code); i++) blockchain_compile(&exec->code[i]);
+
+    if (pthread_create(&exec->thread, NULL, exec_thread_entry, exec)) return false;
+    exec->is_running = true;
+    return true;
+}
+
+void* exec_compiled_thread_entry(void* thread_exec) {
+    ScrExec* exec = thread_exec;
+    pthread_cleanup_push(exec_thread_exit, thread_exec);
+    exec_thread_begin(exec);
+
+    for (size_t i = 0; i < exec->compiled_len; i++) {
+        ScrData bin;
+        if (!exec_run_compiled(exec, exec->compiled[i], -1, NULL, &bin)) pthread_exit((void*)0);
+        exec->running_chain = NULL;
+    }
+
+    pthread_cleanup_pop(1);
+    pthread_exit((void*)1);
+}
+
+// Same as exec_start, but runs chains compiled by scrap-aot in their order
+bool exec_start_compiled(ScrVm* vm, ScrExec* exec, ScrCompiledChain* chains, size_t len) {
+    if (vm->is_running) return false;
+    if (exec->is_running) return false;
+    vm->is_running = true;
+
+    exec->code = NULL;
+    exec->compiled = chains;
+    exec->compiled_len = len;
+    if (pthread_create(&exec->thread, NULL, exec_compiled_thread_entry, exec)) return false;
+    exec->is_running = true;
+    return true;
+}
+
+bool exec_stop(ScrVm* vm, ScrExec* exec) {
     if (!vm->is_running) return false;
     if (!exec->is_running) return false;
     if (pthread_cancel(exec->thread)) return false;
@@ -1016,7 +3330,9 @@ bool variable_stack_push_var(ScrExec* exec, const char* name, ScrData arg) {
     var.value = arg;
     var.chain_layer = exec->chain_stack_len - 1;
     var.layer = exec->chain_stack[var.chain_layer].layer;
+    var.read_only = false;
     exec->variable_stack[exec->variable_stack_len++] = var;
+    exec->variable_stack_version++;
     return true;
 }
 
@@ -1046,64 +3362,326 @@ void variable_stack_cleanup(ScrExec* exec) {
 
 ScrVariable* variable_stack_get_variable(ScrExec* exec, const char* name) {
     for (int i = exec->variable_stack_len - 1; i >= 0; i--) {
-        if (!strcmp(exec->variable_stack[i].name, name)) return &exec->variable_stack[i];
+        if (exec->variable_stack[i].name == name) return &exec->variable_stack[i];
     }
     return NULL;
 }
 
+// Makes chain_stack_seq odd while the stack changes, see sampler_take_sample
+void chain_stack_begin_change(ScrExec* exec) {
+    size_t seq = atomic_load_explicit(&exec->chain_stack_seq, memory_order_relaxed);
+    atomic_store_explicit(&exec->chain_stack_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void chain_stack_end_change(ScrExec* exec) {
+    size_t seq = atomic_load_explicit(&exec->chain_stack_seq, memory_order_relaxed);
+    atomic_store_explicit(&exec->chain_stack_seq, seq + 1, memory_order_release);
+}
+
 void chain_stack_push(ScrExec* exec, ScrChainStackData data) {
-    if (exec->chain_stack_len >= VM_CHAIN_STACK_SIZE) {
+    size_t len = atomic_load_explicit(&exec->chain_stack_len, memory_order_relaxed);
+    if (len >= VM_CHAIN_STACK_SIZE) {
         printf("[VM] CRITICAL: Chain stack overflow\n");
         pthread_exit((void*)0);
     }
-    exec->chain_stack[exec->chain_stack_len++] = data;
+    chain_stack_begin_change(exec);
+    // Struct copy is not atomic, so fields read by the sampler are stored one by one
+    ScrChainStackData* frame = &exec->chain_stack[len];
+    frame->skip_block = data.skip_block;
+    frame->layer = data.layer;
+    atomic_store_explicit(&frame->running_ind, atomic_load_explicit(&data.running_ind, memory_order_relaxed), memory_order_relaxed);
+    frame->custom_argc = data.custom_argc;
+    frame->custom_argv = data.custom_argv;
+    frame->is_returning = data.is_returning;
+    frame->return_arg = data.return_arg;
+    atomic_store_explicit(&frame->chain, atomic_load_explicit(&data.chain, memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(&exec->chain_stack_len, len + 1, memory_order_relaxed);
+    chain_stack_end_change(exec);
 }
 
 void chain_stack_pop(ScrExec* exec) {
-    if (exec->chain_stack_len == 0) {
+    size_t len = atomic_load_explicit(&exec->chain_stack_len, memory_order_relaxed);
+    if (len == 0) {
         printf("[VM] CRITICAL: Chain stack underflow\n");
         pthread_exit((void*)0);
     }
-    exec->chain_stack_len--;
+    chain_stack_begin_change(exec);
+    atomic_store_explicit(&exec->chain_stack_len, len - 1, memory_order_relaxed);
+    chain_stack_end_change(exec);
 }
 
-void arg_stack_push_arg(ScrExec* exec, ScrData arg) {
-    if (exec->arg_stack_len >= VM_ARG_STACK_SIZE) {
-        printf("[VM] CRITICAL: Arg stack overflow\n");
-        pthread_exit((void*)0);
+ScrData data_copy(ScrData arg) {
+    if (arg.storage.type == DATA_STORAGE_STATIC) return arg;
+
+    ScrData out;
+    out.type = arg.type;
+    out.storage.type = DATA_STORAGE_MANAGED;
+    out.storage.storage_len = arg.storage.storage_len;
+    if (arg.type == DATA_STR) {
+        ScrStringHeader* header = string_get_header(arg.data.str_arg);
+        ScrStringHeader* new_header = malloc(sizeof(ScrStringHeader) + header->size + 1);
+        memcpy(new_header, header, sizeof(ScrStringHeader) + header->size + 1);
+        new_header->capacity = header->size;
+        new_header->in_arena = false;
+        out.data.str_arg = new_header->str;
+        return out;
     }
-    exec->arg_stack[exec->arg_stack_len++] = arg;
+
+    if (arg.type == DATA_ARRAY) {
+        out.data.array_arg = arg.data.array_arg;
+        out.data.array_arg.items = malloc(arg.storage.storage_len);
+        memcpy(out.data.array_arg.items, arg.data.array_arg.items, arg.storage.storage_len);
+        return out;
+    }
+
+    if (arg.type == DATA_MAP) {
+        out.data.map_arg = arg.data.map_arg;
+        out.data.map_arg.entries = map_entries_copy(arg.data.map_arg.entries, arg.data.map_arg.cap);
+        return out;
+    }
+
+    if (arg.type == DATA_LIST) {
+        out.data.list_arg = arg.data.list_arg;
+        if (out.data.list_arg.buffer) out.data.list_arg.buffer->refs++;
+        return out;
+    }
+
+    out.data.custom_arg = malloc(arg.storage.storage_len);
+    memcpy((void*)out.data.custom_arg, arg.data.custom_arg, arg.storage.storage_len);
+    return out;
 }
 
-void arg_stack_undo_args(ScrExec* exec, size_t count) {
-    if (count > exec->arg_stack_len) {
-        printf("[VM] CRITICAL: Arg stack underflow\n");
-        pthread_exit((void*)0);
+ScrData list_view(ScrData list, size_t offset, size_t len) {
+    ScrData out;
+    out.type = DATA_LIST;
+    out.storage.type = DATA_STORAGE_MANAGED;
+    out.storage.storage_len = len * sizeof(ScrData);
+    out.data.list_arg.len = len;
+    if (len == 0 || !list.data.list_arg.buffer) {
+        out.data.list_arg.items = NULL;
+        out.data.list_arg.len = 0;
+        out.data.list_arg.buffer = NULL;
+        out.storage.storage_len = 0;
+        return out;
     }
-    for (size_t i = 0; i < count; i++) {
-        ScrData arg = exec->arg_stack[exec->arg_stack_len - 1 - i];
-        if (arg.storage.type != DATA_STORAGE_MANAGED) continue;
-        data_free(arg);
+    out.data.list_arg.items = list.data.list_arg.items + offset;
+    out.data.list_arg.buffer = list.data.list_arg.buffer;
+    out.data.list_arg.buffer->refs++;
+    return out;
+}
+
+void list_release(ScrDataList list) {
+    if (!list.buffer) return;
+    if (--list.buffer->refs > 0) return;
+    for (size_t i = 0; i < list.buffer->len; i++) data_free(list.buffer->items[i]);
+    free(list.buffer);
+}
+
+// Makes the list the only owner of its buffer and makes the buffer hold
+// exactly the list items. Must be called before changing a list in place
+void list_unshare(ScrDataList* list) {
+    ScrListBuffer* buffer = list->buffer;
+    if (!buffer) return;
+    if (buffer->refs == 1 && list->items == buffer->items && list->len == buffer->len) return;
+
+    if (buffer->refs == 1) {
+        // Last view into the buffer, so drop the items outside of it
+        size_t offset = list->items - buffer->items;
+        for (size_t i = 0; i < offset; i++) data_free(buffer->items[i]);
+        for (size_t i = offset + list->len; i < buffer->len; i++) data_free(buffer->items[i]);
+        memmove(buffer->items, list->items, list->len * sizeof(ScrData));
+        buffer->len = list->len;
+        list->items = buffer->items;
+        return;
+    }
+
+    ScrListBuffer* new_buffer = malloc(sizeof(ScrListBuffer) + list->len * sizeof(ScrData));
+    new_buffer->refs = 1;
+    new_buffer->len = list->len;
+    for (size_t i = 0; i < list->len; i++) {
+        new_buffer->items[i] = data_copy(list->items[i]);
+        // List items are owned by the list, not by the arg stack
+        if (new_buffer->items[i].storage.type == DATA_STORAGE_MANAGED) new_buffer->items[i].storage.type = DATA_STORAGE_UNMANAGED;
+    }
+    buffer->refs--;
+    list->buffer = new_buffer;
+    list->items = new_buffer->items;
+}
+
+// Items past the new length must be freed or moved out before shrinking
+void list_resize(ScrData* list, size_t len) {
+    ScrDataList* list_arg = &list->data.list_arg;
+    list_unshare(list_arg);
+    if (len == 0) {
+        free(list_arg->buffer);
+        list_arg->buffer = NULL;
+        list_arg->items = NULL;
+    } else {
+        bool is_new = !list_arg->buffer;
+        list_arg->buffer = realloc(list_arg->buffer, sizeof(ScrListBuffer) + len * sizeof(ScrData));
+        if (is_new) list_arg->buffer->refs = 1;
+        list_arg->buffer->len = len;
+        list_arg->items = list_arg->buffer->items;
+    }
+    list_arg->len = len;
+    list->storage.storage_len = len * sizeof(ScrData);
+}
+
+ScrData data_map_new(void) {
+    ScrData out;
+    out.type = DATA_MAP;
+    out.storage.type = DATA_STORAGE_MANAGED;
+    out.storage.storage_len = 0;
+    out.data.map_arg.entries = NULL;
+    out.data.map_arg.len = 0;
+    out.data.map_arg.cap = 0;
+    return out;
+}
+
+bool map_key_valid(ScrData key) {
+    return key.type == DATA_STR || key.type == DATA_INT || key.type == DATA_DOUBLE || key.type == DATA_BOOL;
+}
+
+// -0.0 hashes as 0.0 since they compare equal, and every NaN is hashed the same
+unsigned int map_key_hash(ScrData key) {
+    unsigned long long bits;
+    double value;
+    switch (key.type) {
+    case DATA_STR:
+        return data_str_hash(key);
+    case DATA_DOUBLE:
+        value = key.data.double_arg;
+        if (value == 0.0) return 0;
+        if (value != value) return 0x7ff80000u * 2654435761u;
+        memcpy(&bits, &value, sizeof(bits));
+        bits ^= bits >> 32;
+        return (unsigned int)bits * 2654435761u;
+    default:
+        return ((unsigned int)key.data.int_arg ^ key.type) * 2654435761u;
+    }
+}
+
+// Keys of different types are never equal, same as in eq block. NaN keys are
+// all treated as one key, otherwise a value stored under NaN could never be found
+bool map_key_eq(ScrData left, ScrData right) {
+    if (left.type != right.type) return false;
+    switch (left.type) {
+    case DATA_STR:
+        return data_str_eq(left, right);
+    case DATA_DOUBLE:
+        if (left.data.double_arg != left.data.double_arg) return right.data.double_arg != right.data.double_arg;
+        return left.data.double_arg == right.data.double_arg;
+    default:
+        return left.data.int_arg == right.data.int_arg;
+    }
+}
+
+// Returns slot with the key or the empty slot where it should be inserted
+size_t map_find_slot(ScrDataMap* map, ScrData key, unsigned int hash) {
+    size_t mask = map->cap - 1;
+    size_t i = hash & mask;
+    while (map->entries[i].key.type != DATA_NOTHING) {
+        if (map->entries[i].hash == hash && map_key_eq(map->entries[i].key, key)) return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+ScrMapEntry* map_entries_copy(ScrMapEntry* entries, size_t cap) {
+    if (!entries) return NULL;
+    ScrMapEntry* out = malloc(cap * sizeof(ScrMapEntry));
+    for (size_t i = 0; i < cap; i++) {
+        out[i] = entries[i];
+        if (entries[i].key.type == DATA_NOTHING) continue;
+        out[i].key = data_copy(entries[i].key);
+        out[i].value = data_copy(entries[i].value);
+        // Entries are owned by the map, not by the arg stack
+        if (out[i].key.storage.type == DATA_STORAGE_MANAGED) out[i].key.storage.type = DATA_STORAGE_UNMANAGED;
+        if (out[i].value.storage.type == DATA_STORAGE_MANAGED) out[i].value.storage.type = DATA_STORAGE_UNMANAGED;
+    }
+    return out;
+}
+
+ScrData* map_get(ScrDataMap* map, ScrData key) {
+    if (map->len == 0 || !map_key_valid(key)) return NULL;
+    size_t slot = map_find_slot(map, key, map_key_hash(key));
+    if (map->entries[slot].key.type == DATA_NOTHING) return NULL;
+    return &map->entries[slot].value;
+}
+
+// Map takes ownership of key and value
+void map_put(ScrData* map, ScrData key, ScrData value) {
+    ScrDataMap* map_arg = &map->data.map_arg;
+    unsigned int hash = map_key_hash(key);
+
+    // Keep load factor under 3/4
+    if ((map_arg->len + 1) * 4 > map_arg->cap * 3) {
+        ScrDataMap new_map;
+        new_map.cap = map_arg->cap ? map_arg->cap * 2 : 8;
+        new_map.len = map_arg->len;
+        new_map.entries = malloc(new_map.cap * sizeof(ScrMapEntry));
+        for (size_t i = 0; i < new_map.cap; i++) new_map.entries[i].key.type = DATA_NOTHING;
+        for (size_t i = 0; i < map_arg->cap; i++) {
+            if (map_arg->entries[i].key.type == DATA_NOTHING) continue;
+            new_map.entries[map_find_slot(&new_map, map_arg->entries[i].key, map_arg->entries[i].hash)] = map_arg->entries[i];
+        }
+        free(map_arg->entries);
+        *map_arg = new_map;
+        map->storage.storage_len = new_map.cap * sizeof(ScrMapEntry);
+    }
+
+    ScrMapEntry* entry = &map_arg->entries[map_find_slot(map_arg, key, hash)];
+    if (entry->key.type != DATA_NOTHING) {
+        data_free(key);
+        data_free(entry->value);
+        entry->value = value;
+        return;
+    }
+    entry->key = key;
+    entry->value = value;
+    entry->hash = hash;
+    map_arg->len++;
+}
+
+bool map_remove(ScrDataMap* map, ScrData key) {
+    if (map->len == 0 || !map_key_valid(key)) return false;
+    size_t mask = map->cap - 1;
+    size_t i = map_find_slot(map, key, map_key_hash(key));
+    if (map->entries[i].key.type == DATA_NOTHING) return false;
+
+    data_free(map->entries[i].key);
+    data_free(map->entries[i].value);
+    map->len--;
+
+    // Shift following entries back so that probing never hits a hole
+    for (size_t j = (i + 1) & mask; map->entries[j].key.type != DATA_NOTHING; j = (j + 1) & mask) {
+        size_t home = map->entries[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            map->entries[i] = map->entries[j];
+            i = j;
+        }
     }
-    exec->arg_stack_len -= count;
+    map->entries[i].key.type = DATA_NOTHING;
+    return true;
 }
 
-ScrData data_copy(ScrData arg) {
-    if (arg.storage.type == DATA_STORAGE_STATIC) return arg;
+bool data_in_arena(ScrData arg) {
+    if (arg.type != DATA_STR || arg.storage.type == DATA_STORAGE_STATIC) return false;
+    return string_get_header(arg.data.str_arg)->in_arena;
+}
 
+// Moves a value into storage that outlives the current block call (variables,
+// list items). Managed temporaries are stolen from the arg stack instead of copied
+ScrData data_take(ScrData* arg) {
     ScrData out;
-    out.type = arg.type;
-    out.storage.type = DATA_STORAGE_MANAGED;
-    out.storage.storage_len = arg.storage.storage_len;
-    out.data.custom_arg = malloc(arg.storage.storage_len);
-    if (arg.type == DATA_LIST) {
-        out.data.list_arg.len = arg.data.list_arg.len;
-        for (size_t i = 0; i < arg.data.list_arg.len; i++) {
-            out.data.list_arg.items[i] = data_copy(arg.data.list_arg.items[i]);
-        }
+    if (arg->storage.type == DATA_STORAGE_MANAGED && !data_in_arena(*arg)) {
+        out = *arg;
+        arg->storage.type = DATA_STORAGE_UNMANAGED;
     } else {
-        memcpy((void*)out.data.custom_arg, arg.data.custom_arg, arg.storage.storage_len);
+        out = data_copy(*arg);
     }
+    if (out.storage.type == DATA_STORAGE_MANAGED) out.storage.type = DATA_STORAGE_UNMANAGED;
     return out;
 }
 
@@ -1111,11 +3689,23 @@ void data_free(ScrData arg) {
     if (arg.storage.type == DATA_STORAGE_STATIC) return;
     switch (arg.type) {
     case DATA_LIST:
-        if (!arg.data.list_arg.items) break;
-        for (size_t i = 0; i < arg.data.list_arg.len; i++) {
-            data_free(arg.data.list_arg.items[i]);
+        list_release(arg.data.list_arg);
+        break;
+    case DATA_ARRAY:
+        free(arg.data.array_arg.items);
+        break;
+    case DATA_MAP:
+        for (size_t i = 0; i < arg.data.map_arg.cap; i++) {
+            if (arg.data.map_arg.entries[i].key.type == DATA_NOTHING) continue;
+            data_free(arg.data.map_arg.entries[i].key);
+            data_free(arg.data.map_arg.entries[i].value);
         }
-        free((ScrData*)arg.data.list_arg.items);
+        free(arg.data.map_arg.entries);
+        break;
+    case DATA_STR:
+        if (!arg.data.str_arg) break;
+        if (string_get_header(arg.data.str_arg)->in_arena) break;
+        free(string_get_header(arg.data.str_arg));
         break;
     default:
         if (!arg.data.custom_arg) break;
@@ -1163,6 +3753,10 @@ int data_to_bool(ScrData arg) {
         return *arg.data.str_arg != 0;
     case DATA_LIST:
         return arg.data.list_arg.len != 0;
+    case DATA_ARRAY:
+        return arg.data.array_arg.len != 0;
+    case DATA_MAP:
+        return arg.data.map_arg.len != 0;
     default:
         return 0;
     }
@@ -1186,31 +3780,118 @@ const char* data_to_str(ScrData arg) {
         return buf;
     case DATA_LIST:
         return "# LIST #";
+    case DATA_ARRAY:
+        return "# ARRAY #";
+    case DATA_MAP:
+        return "# MAP #";
     default:
         return "";
     }
 }
 
+ScrStringHeader* string_get_header(const char* str) {
+    return (ScrStringHeader*)(str - offsetof(ScrStringHeader, str));
+}
+
+size_t string_char_count(const char* str, size_t size) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+        // Count every byte except UTF-8 continuation bytes (10xxxxxx)
+        if (((unsigned char)str[i] & 0xc0) != 0x80) count++;
+    }
+    return count;
+}
+
+unsigned int string_hash(const char* str, size_t size) {
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
 ScrString string_new(size_t cap) {
+    ScrStringHeader* header = malloc(sizeof(ScrStringHeader) + (cap + 1) * sizeof(char));
     ScrString string;
-    string.str = malloc((cap + 1)* sizeof(char));
+    string.str = header->str;
     *string.str = 0;
     string.len = 0;
     string.cap = cap;
+    string.char_len = 0;
+    string.in_arena = false;
     return string;
 }
 
-void string_add(ScrString* string, const char* other) {
-    size_t new_len = string->len + strlen(other);
+void* exec_arena_alloc(ScrExec* exec, size_t size) {
+    size = (size + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1);
+    if (exec->arena_len + size > VM_ARENA_SIZE) return NULL;
+    void* out = exec->arena + exec->arena_len;
+    exec->arena_len += size;
+    return out;
+}
+
+// Same as string_new, but the string is only valid until the current block in the chain
+// finishes. Falls back to the heap if arena is full
+ScrString string_new_temp(ScrExec* exec, size_t cap) {
+    ScrStringHeader* header = exec_arena_alloc(exec, sizeof(ScrStringHeader) + (cap + 1) * sizeof(char));
+    if (!header) return string_new(cap);
+
+    ScrString string;
+    string.str = header->str;
+    *string.str = 0;
+    string.len = 0;
+    string.cap = cap;
+    string.char_len = 0;
+    string.in_arena = true;
+    return string;
+}
+
+void string_add_array(ScrString* string, const char* other, size_t other_len, size_t other_char_len) {
+    size_t new_len = string->len + other_len;
     if (new_len > string->cap) {
-        string->str = realloc(string->str, (new_len + 1) * sizeof(char));
-        string->cap = new_len;
+        size_t new_cap = string->cap * 2 > new_len ? string->cap * 2 : new_len;
+        ScrStringHeader* header;
+        if (string->in_arena) {
+            // Arena strings can't be resized, so move to the heap
+            header = malloc(sizeof(ScrStringHeader) + (new_cap + 1) * sizeof(char));
+            memcpy(header->str, string->str, string->len + 1);
+            string->in_arena = false;
+        } else {
+            header = realloc(string_get_header(string->str), sizeof(ScrStringHeader) + (new_cap + 1) * sizeof(char));
+        }
+        string->str = header->str;
+        string->cap = new_cap;
     }
-    strcat(string->str, other);
+    memcpy(string->str + string->len, other, other_len);
+    string->str[new_len] = 0;
     string->len = new_len;
+    string->char_len += other_char_len;
+}
+
+void string_add(ScrString* string, const char* other) {
+    size_t other_len = strlen(other);
+    string_add_array(string, other, other_len, string_char_count(other, other_len));
+}
+
+void string_add_data(ScrString* string, ScrData data) {
+    if (data.type == DATA_STR && data.storage.type != DATA_STORAGE_STATIC) {
+        ScrStringHeader* header = string_get_header(data.data.str_arg);
+        string_add_array(string, header->str, header->size, header->char_len);
+        return;
+    }
+    string_add(string, data_to_str(data));
 }
 
 ScrData string_make_managed(ScrString* string) {
+    ScrStringHeader* header = string_get_header(string->str);
+    header->size = string->len;
+    header->capacity = string->cap;
+    header->char_len = string->char_len;
+    header->hash = 0;
+    header->in_arena = string->in_arena;
+
     ScrData out;
     out.type = DATA_STR;
     out.storage.type = DATA_STORAGE_MANAGED;
@@ -1219,8 +3900,384 @@ ScrData string_make_managed(ScrString* string) {
     return out;
 }
 
+// Takes over the heap buffer of a string that nothing else holds, a managed
+// temporary or a variable value, so it can be appended to in place
+ScrString string_take(ScrData* arg) {
+    ScrStringHeader* header = string_get_header(arg->data.str_arg);
+    arg->storage.type = DATA_STORAGE_UNMANAGED;
+
+    ScrString string;
+    string.str = header->str;
+    string.len = header->size;
+    string.cap = header->capacity;
+    string.char_len = header->char_len;
+    string.in_arena = header->in_arena;
+    return string;
+}
+
 void string_free(ScrString string) {
-    free(string.str);
+    if (string.in_arena) return;
+    free(string_get_header(string.str));
+}
+
+size_t data_str_len(ScrData arg) {
+    if (arg.type == DATA_STR && arg.storage.type != DATA_STORAGE_STATIC) return string_get_header(arg.data.str_arg)->size;
+    return strlen(data_to_str(arg));
+}
+
+size_t data_str_char_len(ScrData arg) {
+    if (arg.type == DATA_STR && arg.storage.type != DATA_STORAGE_STATIC) return string_get_header(arg.data.str_arg)->char_len;
+    const char* str = data_to_str(arg);
+    return string_char_count(str, strlen(str));
+}
+
+unsigned int data_str_hash(ScrData arg) {
+    if (arg.type == DATA_STR && arg.storage.type != DATA_STORAGE_STATIC) {
+        ScrStringHeader* header = string_get_header(arg.data.str_arg);
+        if (!header->hash) header->hash = string_hash(header->str, header->size);
+        return header->hash;
+    }
+    const char* str = data_to_str(arg);
+    return string_hash(str, strlen(str));
+}
+
+// Both arguments should be DATA_STR
+bool data_str_eq(ScrData left, ScrData right) {
+    if (left.data.str_arg == right.data.str_arg) return true;
+
+    bool left_header = left.storage.type != DATA_STORAGE_STATIC;
+    bool right_header = right.storage.type != DATA_STORAGE_STATIC;
+    // Two different atoms can never hold the same string
+    if (!left_header && !right_header) return false;
+    if (left_header && right_header) {
+        ScrStringHeader* left_str = string_get_header(left.data.str_arg);
+        ScrStringHeader* right_str = string_get_header(right.data.str_arg);
+        if (left_str->size != right_str->size) return false;
+        if (left_str->hash && right_str->hash && left_str->hash != right_str->hash) return false;
+        return !memcmp(left_str->str, right_str->str, left_str->size);
+    }
+
+    size_t left_len = data_str_len(left);
+    if (left_len != data_str_len(right)) return false;
+    return !memcmp(left.data.str_arg, right.data.str_arg, left_len);
+}
+
+const char* data_to_atom(ScrData arg) {
+    if (arg.type == DATA_STR && arg.storage.type == DATA_STORAGE_STATIC) return arg.data.str_arg;
+    return intern_find(data_to_str(arg));
+}
+
+// Should be called with intern_table.lock held. Returns the slot where str is or should be
+size_t intern_find_slot(const char* str, unsigned int hash) {
+    size_t mask = intern_table.cap - 1;
+    size_t slot = hash & mask;
+    while (intern_table.items[slot]) {
+        if (intern_table.hashes[slot] == hash && !strcmp(intern_table.items[slot], str)) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void intern_grow(void) {
+    const char** old_items = intern_table.items;
+    unsigned int* old_hashes = intern_table.hashes;
+    size_t old_cap = intern_table.cap;
+
+    intern_table.cap = old_cap ? old_cap * 2 : 256;
+    intern_table.items = calloc(intern_table.cap, sizeof(const char*));
+    intern_table.hashes = malloc(intern_table.cap * sizeof(unsigned int));
+
+    for (size_t i = 0; i < old_cap; i++) {
+        if (!old_items[i]) continue;
+        size_t slot = intern_find_slot(old_items[i], old_hashes[i]);
+        intern_table.items[slot] = old_items[i];
+        intern_table.hashes[slot] = old_hashes[i];
+    }
+    free(old_items);
+    free(old_hashes);
+}
+
+const char* intern_str(const char* str) {
+    size_t len = strlen(str);
+    unsigned int hash = string_hash(str, len);
+
+    pthread_mutex_lock(&intern_table.lock);
+    // Keep load factor under 1/2
+    if ((intern_table.len + 1) * 2 > intern_table.cap) intern_grow();
+
+    size_t slot = intern_find_slot(str, hash);
+    if (!intern_table.items[slot]) {
+        intern_table.items[slot] = memcpy(malloc(len + 1), str, len + 1);
+        intern_table.hashes[slot] = hash;
+        intern_table.len++;
+    }
+    const char* out = intern_table.items[slot];
+    pthread_mutex_unlock(&intern_table.lock);
+    return out;
+}
+
+const char* intern_find(const char* str) {
+    unsigned int hash = string_hash(str, strlen(str));
+
+    pthread_mutex_lock(&intern_table.lock);
+    const char* out = NULL;
+    if (intern_table.cap > 0) out = intern_table.items[intern_find_slot(str, hash)];
+    pthread_mutex_unlock(&intern_table.lock);
+    return out;
+}
+
+ScrData data_array_new(ScrArrayType type, size_t len) {
+    size_t item_size = type == ARRAY_INT ? sizeof(int) : sizeof(double);
+
+    ScrData out;
+    out.type = DATA_ARRAY;
+    out.storage.type = DATA_STORAGE_MANAGED;
+    out.storage.storage_len = len * item_size;
+    out.data.array_arg.items = calloc(len ? len : 1, item_size);
+    out.data.array_arg.len = len;
+    out.data.array_arg.type = type;
+    return out;
+}
+
+// Int kernels go through unsigned so that overflow wraps the same way in
+// vector and scalar code
+
+SCRVM_SIMD_CLONES void array_int_fill(int* dst, size_t len, int value) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_int vec;
+    simd_splat(vec, value);
+    for (; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) simd_store(dst + i, vec);
+#endif
+    for (; i < len; i++) dst[i] = value;
+}
+
+SCRVM_SIMD_CLONES void array_double_fill(double* dst, size_t len, double value) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_double vec;
+    simd_splat(vec, value);
+    for (; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) simd_store(dst + i, vec);
+#endif
+    for (; i < len; i++) dst[i] = value;
+}
+
+SCRVM_SIMD_CLONES void array_int_add_scalar(int* dst, size_t len, int value) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_uint vec, item;
+    simd_splat(vec, (unsigned int)value);
+    for (; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+        simd_load(item, dst + i);
+        item += vec;
+        simd_store(dst + i, item);
+    }
+#endif
+    for (; i < len; i++) dst[i] = (int)((unsigned int)dst[i] + (unsigned int)value);
+}
+
+SCRVM_SIMD_CLONES void array_double_add_scalar(double* dst, size_t len, double value) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_double vec, item;
+    simd_splat(vec, value);
+    for (; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+        simd_load(item, dst + i);
+        item += vec;
+        simd_store(dst + i, item);
+    }
+#endif
+    for (; i < len; i++) dst[i] += value;
+}
+
+SCRVM_SIMD_CLONES void array_int_mul_scalar(int* dst, size_t len, int value) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_uint vec, item;
+    simd_splat(vec, (unsigned int)value);
+    for (; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+        simd_load(item, dst + i);
+        item *= vec;
+        simd_store(dst + i, item);
+    }
+#endif
+    for (; i < len; i++) dst[i] = (int)((unsigned int)dst[i] * (unsigned int)value);
+}
+
+SCRVM_SIMD_CLONES void array_double_mul_scalar(double* dst, size_t len, double value) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_double vec, item;
+    simd_splat(vec, value);
+    for (; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+        simd_load(item, dst + i);
+        item *= vec;
+        simd_store(dst + i, item);
+    }
+#endif
+    for (; i < len; i++) dst[i] *= value;
+}
+
+SCRVM_SIMD_CLONES void array_int_add(int* dst, const int* src, size_t len) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_uint a, b;
+    for (; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+        simd_load(a, dst + i);
+        simd_load(b, src + i);
+        a += b;
+        simd_store(dst + i, a);
+    }
+#endif
+    for (; i < len; i++) dst[i] = (int)((unsigned int)dst[i] + (unsigned int)src[i]);
+}
+
+SCRVM_SIMD_CLONES void array_double_add(double* dst, const double* src, size_t len) {
+    size_t i = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_double a, b;
+    for (; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+        simd_load(a, dst + i);
+        simd_load(b, src + i);
+        a += b;
+        simd_store(dst + i, a);
+    }
+#endif
+    for (; i < len; i++) dst[i] += src[i];
+}
+
+SCRVM_SIMD_CLONES int array_int_dot(const int* a, const int* b, size_t len) {
+    size_t i = 0;
+    unsigned int out = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_uint acc = {0}, va, vb;
+    for (; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+        simd_load(va, a + i);
+        simd_load(vb, b + i);
+        acc += va * vb;
+    }
+    for (int j = 0; j < SCRVM_SIMD_INT_LANES; j++) out += acc[j];
+#endif
+    for (; i < len; i++) out += (unsigned int)a[i] * (unsigned int)b[i];
+    return (int)out;
+}
+
+SCRVM_SIMD_CLONES double array_double_dot(const double* a, const double* b, size_t len) {
+    size_t i = 0;
+    double out = 0.0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_double acc = {0}, va, vb;
+    for (; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+        simd_load(va, a + i);
+        simd_load(vb, b + i);
+        acc += va * vb;
+    }
+    for (int j = 0; j < SCRVM_SIMD_DOUBLE_LANES; j++) out += acc[j];
+#endif
+    for (; i < len; i++) out += a[i] * b[i];
+    return out;
+}
+
+SCRVM_SIMD_CLONES int array_int_sum(const int* src, size_t len) {
+    size_t i = 0;
+    unsigned int out = 0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_uint acc = {0}, item;
+    for (; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+        simd_load(item, src + i);
+        acc += item;
+    }
+    for (int j = 0; j < SCRVM_SIMD_INT_LANES; j++) out += acc[j];
+#endif
+    for (; i < len; i++) out += (unsigned int)src[i];
+    return (int)out;
+}
+
+SCRVM_SIMD_CLONES double array_double_sum(const double* src, size_t len) {
+    size_t i = 0;
+    double out = 0.0;
+#ifdef SCRVM_SIMD_BYTES
+    simd_double acc = {0}, item;
+    for (; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+        simd_load(item, src + i);
+        acc += item;
+    }
+    for (int j = 0; j < SCRVM_SIMD_DOUBLE_LANES; j++) out += acc[j];
+#endif
+    for (; i < len; i++) out += src[i];
+    return out;
+}
+
+SCRVM_SIMD_CLONES int array_int_min(const int* src, size_t len) {
+    size_t i = 0;
+    int out = src[0];
+#ifdef SCRVM_SIMD_BYTES
+    if (len >= SCRVM_SIMD_INT_LANES) {
+        simd_int acc, item;
+        simd_load(acc, src);
+        for (i = SCRVM_SIMD_INT_LANES; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+            simd_load(item, src + i);
+            acc = simd_int_min(acc, item);
+        }
+        for (int j = 0; j < SCRVM_SIMD_INT_LANES; j++) if (acc[j] < out) out = acc[j];
+    }
+#endif
+    for (; i < len; i++) if (src[i] < out) out = src[i];
+    return out;
+}
+
+SCRVM_SIMD_CLONES double array_double_min(const double* src, size_t len) {
+    size_t i = 0;
+    double out = src[0];
+#ifdef SCRVM_SIMD_BYTES
+    if (len >= SCRVM_SIMD_DOUBLE_LANES) {
+        simd_double acc, item;
+        simd_load(acc, src);
+        for (i = SCRVM_SIMD_DOUBLE_LANES; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+            simd_load(item, src + i);
+            acc = simd_double_min(acc, item);
+        }
+        for (int j = 0; j < SCRVM_SIMD_DOUBLE_LANES; j++) if (acc[j] < out) out = acc[j];
+    }
+#endif
+    for (; i < len; i++) if (src[i] < out) out = src[i];
+    return out;
+}
+
+SCRVM_SIMD_CLONES int array_int_max(const int* src, size_t len) {
+    size_t i = 0;
+    int out = src[0];
+#ifdef SCRVM_SIMD_BYTES
+    if (len >= SCRVM_SIMD_INT_LANES) {
+        simd_int acc, item;
+        simd_load(acc, src);
+        for (i = SCRVM_SIMD_INT_LANES; i + SCRVM_SIMD_INT_LANES <= len; i += SCRVM_SIMD_INT_LANES) {
+            simd_load(item, src + i);
+            acc = simd_int_max(acc, item);
+        }
+        for (int j = 0; j < SCRVM_SIMD_INT_LANES; j++) if (acc[j] > out) out = acc[j];
+    }
+#endif
+    for (; i < len; i++) if (src[i] > out) out = src[i];
+    return out;
+}
+
+SCRVM_SIMD_CLONES double array_double_max(const double* src, size_t len) {
+    size_t i = 0;
+    double out = src[0];
+#ifdef SCRVM_SIMD_BYTES
+    if (len >= SCRVM_SIMD_DOUBLE_LANES) {
+        simd_double acc, item;
+        simd_load(acc, src);
+        for (i = SCRVM_SIMD_DOUBLE_LANES; i + SCRVM_SIMD_DOUBLE_LANES <= len; i += SCRVM_SIMD_DOUBLE_LANES) {
+            simd_load(item, src + i);
+            acc = simd_double_max(acc, item);
+        }
+        for (int j = 0; j < SCRVM_SIMD_DOUBLE_LANES; j++) if (acc[j] > out) out = acc[j];
+    }
+#endif
+    for (; i < len; i++) if (src[i] > out) out = src[i];
+    return out;
 }
 
 ScrBlock block_new(ScrBlockdef* blockdef) {
@@ -1237,6 +4294,7 @@ ScrBlock block_new(ScrBlockdef* blockdef) {
             block.blockdef->inputs[i].type != INPUT_BLOCKDEF_EDITOR) continue;
         ScrArgument* arg = vector_add_dst((ScrArgument**)&block.arguments);
         arg->input_id = i;
+        arg->value = (ScrData) {0};
 
         switch (blockdef->inputs[i].type) {
         case INPUT_ARGUMENT:
@@ -1303,6 +4361,7 @@ ScrBlock block_copy(ScrBlock* block, ScrBlock* parent) {
         arg->ms = block->arguments[i].ms;
         arg->type = block->arguments[i].type;
         arg->input_id = block->arguments[i].input_id;
+        arg->value = block->arguments[i].value;
         switch (block->arguments[i].type) {
         case ARGUMENT_CONST_STRING:
         case ARGUMENT_TEXT:
@@ -1371,6 +4430,11 @@ ScrBlockChain blockchain_new(void) {
     ScrBlockChain chain;
     chain.pos = (ScrVec) {0};
     chain.blocks = vector_create();
+    chain.postfix = vector_create();
+    chain.postfix_start = vector_create();
+    chain.block_ends = vector_create();
+    chain.loop_jumps = vector_create();
+    chain.jit = (ScrJitCode) {0};
 
     return chain;
 }
@@ -1381,6 +4445,11 @@ ScrBlockChain blockchain_copy_single(ScrBlockChain* chain, size_t pos) {
     ScrBlockChain new;
     new.pos = chain->pos;
     new.blocks = vector_create();
+    new.postfix = vector_create();
+    new.postfix_start = vector_create();
+    new.block_ends = vector_create();
+    new.loop_jumps = vector_create();
+    new.jit = (ScrJitCode) {0};
 
     ScrBlockdefType block_type = chain->blocks[pos].blockdef->type;
     if (block_type == BLOCKTYPE_END) return new;
@@ -1413,6 +4482,11 @@ ScrBlockChain blockchain_copy(ScrBlockChain* chain, size_t pos) {
     ScrBlockChain new;
     new.pos = chain->pos;
     new.blocks = vector_create();
+    new.postfix = vector_create();
+    new.postfix_start = vector_create();
+    new.block_ends = vector_create();
+    new.loop_jumps = vector_create();
+    new.jit = (ScrJitCode) {0};
 
     int pos_layer = 0;
     for (size_t i = 0; i < pos; i++) {
@@ -1543,6 +4617,332 @@ void blockchain_detach(ScrBlockChain* dst, ScrBlockChain* src, size_t pos) {
 void blockchain_free(ScrBlockChain* chain) {
     blockchain_clear_blocks(chain);
     vector_free(chain->blocks);
+    vector_free(chain->postfix);
+    vector_free(chain->postfix_start);
+    vector_free(chain->block_ends);
+    vector_free(chain->loop_jumps);
+    jit_free(&chain->jit);
+}
+
+// Dropdown selections can't change while exec is running, so look them up once here
+int block_resolve_dropdown(ScrBlock* block, ScrInputDropdown* drop, const char* atom) {
+    size_t list_len = 0;
+    char** list = drop->list(block, &list_len);
+    for (size_t i = 0; i < list_len; i++) {
+        if (intern_str(list[i]) == atom) return i;
+    }
+    return -1;
+}
+
+void block_compile_arguments(ScrBlock* block) {
+    for (size_t i = 0; i < vector_size(block->arguments); i++) {
+        ScrArgument* arg = &block->arguments[i];
+        ScrInput* input = &block->blockdef->inputs[arg->input_id];
+        switch (arg->type) {
+        case ARGUMENT_TEXT:
+        case ARGUMENT_CONST_STRING:
+            arg->value = (ScrData) {
+                .type = DATA_STR,
+                .storage = DATA_STORAGE_STATIC,
+                .data = (ScrDataContents) {
+                    .str_arg = intern_str(arg->data.text),
+                },
+            };
+            if (input->type == INPUT_DROPDOWN && input->data.drop.source == DROPDOWN_SOURCE_LISTREF_INDEX) {
+                arg->value = (ScrData) {
+                    .type = DATA_INT,
+                    .storage = DATA_STORAGE_STATIC,
+                    .data = (ScrDataContents) {
+                        .int_arg = block_resolve_dropdown(block, &input->data.drop, arg->value.data.str_arg),
+                    },
+                };
+            }
+            break;
+        case ARGUMENT_BLOCK:
+            block_compile_arguments(&arg->data.block);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int block_compile_short_circuit(ScrBlock* block, ScrPostfixOp** program);
+
+bool postfix_is_builtin_call(ScrPostfixOp* op, ScrBuiltin builtin, int argc) {
+    return op->type == POSTFIX_CALL && op->block->blockdef->builtin == builtin && op->argc == argc;
+}
+
+// Text like "7" is converted with atoi every time it is used as a number.
+// Arithmetic and ordering blocks treat ints and such text the same, so their
+// constant operands are turned into ints once. Only text that an int prints
+// back as is gets folded, "-0" for example stays text as atof reads it as -0.0
+void postfix_fold_int_constant(ScrPostfixOp* op) {
+    if (op->type != POSTFIX_PUSH || op->value->type != DATA_STR || op->value->storage.type != DATA_STORAGE_STATIC) return;
+    const char* str = op->value->data.str_arg;
+    const char* digits = *str == '-' ? str + 1 : str;
+    size_t len = strlen(digits);
+    if (len == 0 || len > 9 || (digits[0] == '0' && (len > 1 || digits != str))) return;
+    for (size_t i = 0; i < len; i++) if (digits[i] < '0' || digits[i] > '9') return;
+
+    *op->value = (ScrData) {
+        .type = DATA_INT,
+        .storage = DATA_STORAGE_STATIC,
+        .data = (ScrDataContents) {
+            .int_arg = atoi(str),
+        },
+    };
+}
+
+// Peephole pass, run after each CALL op is added. Ops before the CALL are
+// its arguments, so they can be folded into it
+void postfix_fuse_call(ScrPostfixOp** program) {
+    size_t len = vector_size(*program);
+    ScrPostfixOp* ops = *program;
+    ScrPostfixOp* call = &ops[len - 1];
+
+    // get var [name] -> GET_VAR
+    if (len >= 2 && postfix_is_builtin_call(call, BUILTIN_GET_VAR, 1) && ops[len - 2].type == POSTFIX_PUSH) {
+        ops[len - 2].type = POSTFIX_GET_VAR;
+        ops[len - 2].var_version = (size_t)-1;
+        vector_pop(*program);
+        return;
+    }
+
+    // [list] get at (get var [index]) -> LIST_GET_VAR
+    if (len >= 3 && postfix_is_builtin_call(call, BUILTIN_LIST_GET, 2) && ops[len - 3].type == POSTFIX_PUSH && ops[len - 2].type == POSTFIX_GET_VAR) {
+        ops[len - 3].type = POSTFIX_LIST_GET_VAR;
+        ops[len - 3].index = ops[len - 2].value;
+        ops[len - 3].block = call->block;
+        vector_pop(*program);
+        vector_pop(*program);
+        return;
+    }
+
+    if (call->type != POSTFIX_CALL || call->argc != 2) return;
+    switch (call->block->blockdef->builtin) {
+    case BUILTIN_PLUS:
+    case BUILTIN_MINUS:
+    case BUILTIN_MULT:
+        call->type = POSTFIX_ARITH;
+        break;
+    case BUILTIN_LESS:
+    case BUILTIN_LESS_EQ:
+    case BUILTIN_MORE:
+    case BUILTIN_MORE_EQ:
+        call->type = POSTFIX_COMPARE;
+        break;
+    case BUILTIN_EQ:
+    case BUILTIN_NOT_EQ:
+        // Equality compares types, so "7" is not the same as 7 there
+        call->type = POSTFIX_COMPARE;
+        return;
+    default:
+        return;
+    }
+
+    // Both arguments are a single op only if the last one is
+    ScrPostfixOp* right = &ops[len - 2];
+    if (right->type != POSTFIX_PUSH && right->type != POSTFIX_GET_VAR) return;
+    postfix_fold_int_constant(right);
+    if (len >= 3) postfix_fold_int_constant(&ops[len - 3]);
+}
+
+// set var [name] = (get var [name]) + [step] -> [step] INC_VAR, where step is
+// a constant or a variable so it doesn't matter when it is evaluated.
+// set var [name] = join (get var [name]) [value] -> [name] GET_VAR [value] APPEND_VAR
+// set var [name] = [value] -> [name] [value] SET_VAR
+void postfix_fuse_block(ScrBlock* block, ScrPostfixOp** program, size_t start) {
+    if (block->blockdef->builtin != BUILTIN_SET_VAR || block->blockdef->type != BLOCKTYPE_NORMAL) return;
+    size_t len = vector_size(*program) - start;
+    ScrPostfixOp* ops = &(*program)[start];
+
+    ScrBlock* join = vector_size(block->arguments) >= 2 && block->arguments[1].type == ARGUMENT_BLOCK ? &block->arguments[1].data.block : NULL;
+    if (join &&
+        len >= 4 &&
+        ops[0].type == POSTFIX_PUSH &&
+        ops[1].type == POSTFIX_GET_VAR &&
+        data_to_atom(*ops[0].value) == data_to_atom(*ops[1].value) &&
+        postfix_is_builtin_call(&ops[len - 1], BUILTIN_JOIN, 2) &&
+        ops[len - 1].block == join &&
+        join->arguments[0].type == ARGUMENT_BLOCK &&
+        vector_size(join->arguments[0].data.block.arguments) > 0 &&
+        ops[1].value == &join->arguments[0].data.block.arguments[0].value)
+    {
+        // GET_VAR is the whole first argument of join, not the start of it
+        ops[len - 1].type = POSTFIX_APPEND_VAR;
+        ops[len - 1].inner = join;
+        ops[len - 1].block = block;
+        ops[len - 1].value = ops[0].value;
+        ops[len - 1].var_version = (size_t)-1;
+        return;
+    }
+
+    if (len == 4 &&
+        ops[0].type == POSTFIX_PUSH &&
+        ops[1].type == POSTFIX_GET_VAR &&
+        (ops[2].type == POSTFIX_PUSH || ops[2].type == POSTFIX_GET_VAR) &&
+        ops[3].type == POSTFIX_ARITH &&
+        ops[3].block->blockdef->builtin == BUILTIN_PLUS &&
+        data_to_atom(*ops[0].value) == data_to_atom(*ops[1].value))
+    {
+        ScrData* name = ops[0].value;
+        ScrBlock* plus = ops[3].block;
+        ops[0] = ops[2];
+        ops[1].type = POSTFIX_INC_VAR;
+        ops[1].inner = plus;
+        ops[1].argc = 1;
+        ops[1].block = block;
+        ops[1].value = name;
+        ops[1].var_version = (size_t)-1;
+        vector_pop(*program);
+        vector_pop(*program);
+        return;
+    }
+
+    // Name and value are the only arguments, so the value is what is left on top
+    if (vector_size(block->arguments) != 2 || ops[0].type != POSTFIX_PUSH || ops[0].value != &block->arguments[0].value) return;
+    ScrArgumentType value_type = block->arguments[1].type;
+    if (value_type != ARGUMENT_TEXT && value_type != ARGUMENT_CONST_STRING && value_type != ARGUMENT_BLOCK) return;
+    ScrPostfixOp* op = vector_add_dst(program);
+    op->type = POSTFIX_SET_VAR;
+    op->argc = 2;
+    op->block = block;
+    op->value = &block->arguments[0].value;
+    op->var_version = (size_t)-1;
+}
+
+// Returns number of values the argument leaves on arg stack
+int block_compile_argument(ScrArgument* arg, ScrPostfixOp** program) {
+    ScrPostfixOp* op;
+    switch (arg->type) {
+    case ARGUMENT_TEXT:
+    case ARGUMENT_CONST_STRING:
+        op = vector_add_dst(program);
+        op->type = POSTFIX_PUSH;
+        op->argc = 0;
+        op->value = &arg->value;
+        return 1;
+    case ARGUMENT_BLOCK: {
+        ScrBlock* block = &arg->data.block;
+        int argc;
+        if (block->blockdef->short_circuit != SHORT_CIRCUIT_NONE && block->blockdef->arg_id == -1) {
+            argc = block_compile_short_circuit(block, program);
+        } else {
+            argc = 0;
+            for (size_t i = 0; i < vector_size(block->arguments); i++) argc += block_compile_argument(&block->arguments[i], program);
+        }
+        op = vector_add_dst(program);
+        op->type = POSTFIX_CALL;
+        op->argc = argc;
+        op->block = block;
+        postfix_fuse_call(program);
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+// Puts a jump after the first argument that goes over the rest of arguments
+// and the CALL op that follows them. Only used for argument blocks, a top
+// level block result is thrown away so it is compiled as usual
+int block_compile_short_circuit(ScrBlock* block, ScrPostfixOp** program) {
+    int argc = 0;
+    size_t skip_ind = 0;
+    for (size_t i = 0; i < vector_size(block->arguments); i++) {
+        argc += block_compile_argument(&block->arguments[i], program);
+        if (argc == 1 && skip_ind == 0) {
+            skip_ind = vector_size(*program);
+            ScrPostfixOp* op = vector_add_dst(program);
+            op->type = block->blockdef->short_circuit == SHORT_CIRCUIT_ON_FALSE ? POSTFIX_SKIP_IF_FALSE : POSTFIX_SKIP_IF_TRUE;
+            op->argc = 0;
+        }
+    }
+    if (skip_ind) (*program)[skip_ind].skip = vector_size(*program) - skip_ind;
+    return argc;
+}
+
+// Control layers are tracked the same way as exec_run_chain does, so a
+// CONTROLEND outside of any layer does nothing here either
+void blockchain_compile_ends(ScrBlockChain* chain) {
+    vector_clear(chain->block_ends);
+    size_t* layers = vector_create();
+
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) {
+        ScrBlockdefType type = chain->blocks[i].blockdef->type;
+        vector_add(&chain->block_ends, (size_t)-1);
+        if ((type == BLOCKTYPE_END || type == BLOCKTYPE_CONTROLEND) && vector_size(layers) > 0) {
+            chain->block_ends[layers[vector_size(layers) - 1]] = i;
+            vector_pop(layers);
+            if (type == BLOCKTYPE_CONTROLEND) vector_add(&layers, i);
+        } else if (type == BLOCKTYPE_CONTROL) {
+            vector_add(&layers, i);
+        }
+    }
+
+    vector_free(layers);
+}
+
+// Needs block_ends to be filled
+void blockchain_compile_loop_jumps(ScrBlockChain* chain) {
+    vector_clear(chain->loop_jumps);
+    size_t* layers = vector_create();
+
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) {
+        ScrBlockdef* blockdef = chain->blocks[i].blockdef;
+        ScrLoopJump* jump = vector_add_dst(&chain->loop_jumps);
+        jump->next = 0;
+        jump->unwind = -1;
+
+        if ((blockdef->type == BLOCKTYPE_END || blockdef->type == BLOCKTYPE_CONTROLEND) && vector_size(layers) > 0) {
+            vector_pop(layers);
+            if (blockdef->type == BLOCKTYPE_CONTROLEND) vector_add(&layers, i);
+            continue;
+        }
+        if (blockdef->type == BLOCKTYPE_CONTROL) {
+            vector_add(&layers, i);
+            continue;
+        }
+        if (blockdef->builtin != BUILTIN_BREAK && blockdef->builtin != BUILTIN_CONTINUE) continue;
+
+        for (int j = vector_size(layers) - 1; j >= 0; j--) {
+            if (chain->blocks[layers[j]].blockdef->builtin != BUILTIN_LOOP) continue;
+            size_t end = chain->block_ends[layers[j]];
+            // Loops closed by else are left alone, jumping over the else would unbalance the layers
+            if (end == (size_t)-1 || chain->blocks[end].blockdef->type != BLOCKTYPE_END) break;
+
+            jump->unwind = vector_size(layers) - 1 - j;
+            if (blockdef->builtin == BUILTIN_BREAK) {
+                // Drops the loop layer too and continues after its end
+                jump->unwind++;
+                jump->next = end + 1;
+            } else {
+                // Lets the loop end block decide whether to loop again
+                jump->next = end;
+            }
+            break;
+        }
+    }
+
+    vector_free(layers);
+}
+
+void blockchain_compile(ScrBlockChain* chain) {
+    jit_free(&chain->jit);
+    vector_clear(chain->postfix);
+    vector_clear(chain->postfix_start);
+    for (size_t i = 0; i < vector_size(chain->blocks); i++) {
+        block_compile_arguments(&chain->blocks[i]);
+        vector_add(&chain->postfix_start, vector_size(chain->postfix));
+        ScrBlock* block = &chain->blocks[i];
+        for (size_t j = 0; j < vector_size(block->arguments); j++) block_compile_argument(&block->arguments[j], &chain->postfix);
+        postfix_fuse_block(block, &chain->postfix, chain->postfix_start[i]);
+        ScrPostfixOp* op = vector_add_dst(&chain->postfix);
+        op->type = POSTFIX_END;
+    }
+    blockchain_compile_ends(chain);
+    blockchain_compile_loop_jumps(chain);
 }
 
 void argument_set_block(ScrArgument* block_arg, ScrBlock block) {
@@ -1581,9 +4981,11 @@ void argument_set_text(ScrArgument* block_arg, char* text) {
 ScrBlockdef* blockdef_new(const char* id, ScrBlockdefType type, ScrColor color, ScrBlockFunc func) {
     assert(id != NULL);
     ScrBlockdef* blockdef = malloc(sizeof(ScrBlockdef));
-    blockdef->id = strcpy(malloc((strlen(id) + 1) * sizeof(char)), id);
+    blockdef->id = intern_str(id);
     blockdef->color = color;
     blockdef->type = type;
+    blockdef->short_circuit = SHORT_CIRCUIT_NONE;
+    blockdef->builtin = BUILTIN_NONE;
     blockdef->ms = (ScrMeasurement) {0};
     blockdef->hidden = false;
     blockdef->ref_count = 0;
@@ -1597,9 +4999,11 @@ ScrBlockdef* blockdef_new(const char* id, ScrBlockdefType type, ScrColor color,
 
 ScrBlockdef* blockdef_copy(ScrBlockdef* blockdef) {
     ScrBlockdef* new = malloc(sizeof(ScrBlockdef));
-    new->id = strcpy(malloc((strlen(blockdef->id) + 1) * sizeof(char)), blockdef->id);
+    new->id = blockdef->id;
     new->color = blockdef->color;
     new->type = blockdef->type;
+    new->short_circuit = blockdef->short_circuit;
+    new->builtin = blockdef->builtin;
     new->ms = blockdef->ms;
     new->hidden = blockdef->hidden;
     new->ref_count = blockdef->ref_count;
@@ -1669,6 +5073,13 @@ size_t blockdef_register(ScrVm* vm, ScrBlockdef* blockdef) {
     return vector_size(vm->blockdefs) - 1;
 }
 
+ScrBlockdef* blockdef_find(ScrVm* vm, const char* id) {
+    for (size_t i = 0; i < vector_size(vm->blockdefs); i++) {
+        if (!strcmp(vm->blockdefs[i]->id, id)) return vm->blockdefs[i];
+    }
+    return NULL;
+}
+
 void blockdef_add_text(ScrBlockdef* blockdef, char* text) {
     ScrInput* input = vector_add_dst(&blockdef->inputs);
     ScrMeasurement ms = (ScrMeasurement) {0};
@@ -1729,8 +5140,15 @@ void blockdef_add_image(ScrBlockdef* blockdef, ScrImage image) {
 }
 
 void blockdef_set_id(ScrBlockdef* blockdef, const char* new_id) {
-    free((void*)blockdef->id);
-    blockdef->id = strcpy(malloc((strlen(new_id) + 1) * sizeof(char)), new_id);
+    blockdef->id = intern_str(new_id);
+}
+
+void blockdef_set_short_circuit(ScrBlockdef* blockdef, ScrShortCircuit short_circuit) {
+    blockdef->short_circuit = short_circuit;
+}
+
+void blockdef_set_builtin(ScrBlockdef* blockdef, ScrBuiltin builtin) {
+    blockdef->builtin = builtin;
 }
 
 void blockdef_delete_input(ScrBlockdef* blockdef, size_t input) {
@@ -1766,7 +5184,6 @@ void blockdef_free(ScrBlockdef* blockdef) {
         }
     }
     vector_free(blockdef->inputs);
-    free((void*)blockdef->id);
     free(blockdef);
 }
 
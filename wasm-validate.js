@@ -0,0 +1,26 @@
+// Validates wasm modules written by scrap-wasm and instantiates them the same way
+// jit_wasm_instantiate in vm.h does. Usage: node wasm-validate.js <module.wasm>...
+const fs = require('fs');
+
+const shared_memory = new WebAssembly.Memory({ initial: 1, maximum: 65536, shared: true });
+const memory = new WebAssembly.Memory({ initial: 1 });
+const table = new WebAssembly.Table({ initial: 1, element: 'anyfunc' });
+
+let failed = 0;
+for (const path of process.argv.slice(2)) {
+    try {
+        const code = fs.readFileSync(path);
+        if (!WebAssembly.validate(code)) throw new Error('module is not valid');
+        const module = new WebAssembly.Module(code);
+        const env = { memory: path.endsWith('.unshared.wasm') ? memory : shared_memory, table: table };
+        const instance = new WebAssembly.Instance(module, { env: env });
+        if (typeof instance.exports.run !== 'function' || instance.exports.run.length !== 4) {
+            throw new Error('module does not export run(exec, start, arena_base, frame)');
+        }
+    } catch (e) {
+        console.log(`[WASM] ${path}: ${e.message}`);
+        failed++;
+    }
+}
+console.log(`[WASM] ${process.argv.length - 2 - failed} of ${process.argv.length - 2} modules are valid`);
+process.exit(failed ? 1 : 0);